@@ -0,0 +1,639 @@
+// historybenchmark.cpp - 捕获、列表重建、保存和加载热路径的基准测试
+//
+// 在 offscreen 平台下无界面运行，结果写入 JSON（默认 clipboard_bench.json，
+// 可用环境变量 CLIPBOARD_BENCH_JSON 指定路径）。
+#include "historygenerator.h"
+#include "../main/mainwindow.h"
+#include "../components/clipboardhistory.h"
+#include "../components/storedmimedata.h"
+#include "../components/pagedecoder.h"
+#include "../components/ui/historyrow.h"
+#include "../components/ui/theme.h"
+#include "../components/chunkstore.h"
+#include "../components/tilestore.h"
+#include "../components/entrycolumns.h"
+#include <QtTest>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QMimeData>
+#include <QPainter>
+#include <QDir>
+#include <QBuffer>
+#include <QEventLoop>
+#include <QThread>
+#include <QThreadPool>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+class HistoryBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void imageHash_data();
+    void imageHash();
+    void updateList_data();
+    void updateList();
+    void saveHistory_data();
+    void saveHistory();
+    void loadHistory_data();
+    void loadHistory();
+    void createImageLabel_data();
+    void createImageLabel();
+    void copyBack_data();
+    void copyBack();
+    void pageDecode_data();
+    void pageDecode();
+    void rowPolish_data();
+    void rowPolish();
+    void chunkText_data();
+    void chunkText();
+    void tileImage_data();
+    void tileImage();
+    void columnFilter_data();
+    void columnFilter();
+    void removeEntries_data();
+    void removeEntries();
+
+private:
+    // 至少运行 minIterations 次，并在时间预算内尽量多跑；setup 不计时
+    void measure(const QString& name, const std::function<void()>& body,
+                 const std::function<void()>& setup = nullptr,
+                 int minIterations = 3, qint64 budgetMs = 1000);
+    void addSizeRows();
+    // 给最近一条结果附加字段
+    void annotateLast(const QString& key, const QJsonValue& value);
+
+    QJsonArray m_results;
+};
+
+void HistoryBenchmark::annotateLast(const QString& key, const QJsonValue& value) {
+    QJsonObject result = m_results.last().toObject();
+    result[key] = value;
+    m_results[m_results.size() - 1] = result;
+}
+
+void HistoryBenchmark::measure(const QString& name, const std::function<void()>& body,
+                               const std::function<void()>& setup,
+                               int minIterations, qint64 budgetMs) {
+    QList<double> samples;
+    QElapsedTimer total;
+    total.start();
+
+    while (samples.size() < minIterations || total.elapsed() < budgetMs) {
+        if (setup) setup();
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        samples.append(timer.nsecsElapsed() / 1e6);
+        if (samples.size() >= 1000) break;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) sum += sample;
+
+    QJsonObject result;
+    result["name"] = name;
+    result["case"] = QString::fromLatin1(QTest::currentDataTag());
+    result["iterations"] = static_cast<int>(samples.size());
+    result["mean_ms"] = sum / samples.size();
+    result["min_ms"] = samples.first();
+    result["median_ms"] = samples.at(samples.size() / 2);
+    result["max_ms"] = samples.last();
+    m_results.append(result);
+
+    qDebug().noquote() << name << QTest::currentDataTag()
+                       << "median" << result["median_ms"].toDouble() << "ms";
+}
+
+void HistoryBenchmark::initTestCase() {
+    // 不触碰真实的历史数据目录
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void HistoryBenchmark::cleanupTestCase() {
+    QString path = qEnvironmentVariable("CLIPBOARD_BENCH_JSON", "clipboard_bench.json");
+    QJsonObject root;
+    root["qt_version"] = QString::fromLatin1(qVersion());
+    root["platform"] = QGuiApplication::platformName();
+    root["ideal_threads"] = QThread::idealThreadCount();
+    root["results"] = m_results;
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QJsonDocument(root).toJson());
+    qDebug() << "Benchmark results written to" << path;
+}
+
+void HistoryBenchmark::imageHash_data() {
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("1080p") << QSize(1920, 1080);
+    QTest::newRow("4k") << QSize(3840, 2160);
+}
+
+void HistoryBenchmark::imageHash() {
+    QFETCH(QSize, size);
+    HistoryGenerator generator;
+    QPixmap image = QPixmap::fromImage(generator.makeImage(size));
+
+    measure("imageHash", [&]() {
+        QString hash = ClipboardHistory::imageHash(image);
+        QVERIFY(!hash.isEmpty());
+    });
+}
+
+void HistoryBenchmark::addSizeRows() {
+    QTest::addColumn<int>("count");
+    QTest::addColumn<double>("imageRatio");
+    QTest::newRow("100_text") << 100 << 0.0;
+    QTest::newRow("100_mixed") << 100 << 0.3;
+    QTest::newRow("1k_text") << 1000 << 0.0;
+    QTest::newRow("1k_mixed") << 1000 << 0.1;
+    QTest::newRow("10k_text") << 10000 << 0.0;
+}
+
+void HistoryBenchmark::updateList_data() {
+    addSizeRows();
+}
+
+void HistoryBenchmark::updateList() {
+    QFETCH(int, count);
+    QFETCH(double, imageRatio);
+
+    HistoryGenerator generator;
+    const auto entries = generator.generate(count, imageRatio, QSize(640, 360));
+
+    MainWindow window;
+    window.items.clear();
+    window.columns.clear();
+    for (const auto& entry : entries) {
+        MainWindow::ClipboardItem item;
+        item.type = entry.type == StorageManager::ClipboardData::Text
+                        ? MainWindow::ClipboardItem::Text : MainWindow::ClipboardItem::Image;
+        item.id = entry.id;
+        item.text = entry.text;
+        item.image = entry.image;
+        item.timestamp = entry.timestamp;
+        window.items.append(item);
+        window.insertColumn(0, item);
+    }
+
+    measure("updateList", [&]() {
+        window.updateList();
+    }, nullptr, 1, count >= 10000 ? 0 : 1000);
+}
+
+void HistoryBenchmark::saveHistory_data() {
+    addSizeRows();
+}
+
+void HistoryBenchmark::saveHistory() {
+    QFETCH(int, count);
+    QFETCH(double, imageRatio);
+
+    HistoryGenerator generator;
+    const auto entries = generator.generate(count, imageRatio, QSize(1280, 720));
+
+    // 冷存储：每次都写入新目录，包含图片编码
+    std::unique_ptr<QTemporaryDir> dir;
+    StorageManager storage;
+    storage.setStorageLimit(count);
+    measure("saveHistory_cold", [&]() {
+        QVERIFY(storage.saveHistory(entries));
+    }, [&]() {
+        dir = std::make_unique<QTemporaryDir>();
+        storage.setStoragePath(dir->path());
+    }, 1, 0);
+
+    // 热存储：图片文件已在捕获时写入，只重写索引
+    measure("saveHistory_warm", [&]() {
+        QVERIFY(storage.saveHistory(entries));
+    });
+}
+
+void HistoryBenchmark::loadHistory_data() {
+    addSizeRows();
+}
+
+void HistoryBenchmark::loadHistory() {
+    QFETCH(int, count);
+    QFETCH(double, imageRatio);
+
+    HistoryGenerator generator;
+    QTemporaryDir dir;
+    {
+        StorageManager writer;
+        writer.setStoragePath(dir.path());
+        writer.setStorageLimit(count);
+        QVERIFY(writer.saveHistory(generator.generate(count, imageRatio, QSize(1280, 720))));
+    }
+
+    // 只解析索引（捕获核心的启动路径）
+    measure("loadIndex", [&]() {
+        StorageManager storage;
+        storage.setStoragePath(dir.path());
+        QCOMPARE(storage.loadIndex(), count);
+    });
+
+    // 完整加载并解码图片
+    measure("loadHistory", [&]() {
+        StorageManager storage;
+        storage.setStoragePath(dir.path());
+        QCOMPARE(storage.loadHistory().size(), count);
+    });
+}
+
+void HistoryBenchmark::createImageLabel_data() {
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("720p") << QSize(1280, 720);
+    QTest::newRow("1080p") << QSize(1920, 1080);
+    QTest::newRow("4k") << QSize(3840, 2160);
+}
+
+void HistoryBenchmark::createImageLabel() {
+    QFETCH(QSize, size);
+    HistoryGenerator generator;
+    QPixmap image = QPixmap::fromImage(generator.makeImage(size));
+    MainWindow window;
+
+    measure("createImageLabel", [&]() {
+        delete window.createImageLabel(image);
+    });
+}
+
+void HistoryBenchmark::copyBack_data() {
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("1080p") << QSize(1920, 1080);
+    QTest::newRow("4k") << QSize(3840, 2160);
+}
+
+void HistoryBenchmark::copyBack() {
+    // 其他程序请求 image/png 时的准备耗时：旧方式每次粘贴都从 QImage 重新编码，
+    // StoredMimeData 直接返回存储中的 PNG 字节
+    QFETCH(QSize, size);
+    HistoryGenerator generator;
+    QImage image = generator.makeImage(size);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.filePath("image.png");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(ClipboardHistory::encodeImage(image));
+    file.close();
+
+    QMimeData encoded;
+    encoded.setImageData(image);
+    measure("copyBack_reencode", [&]() {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        qvariant_cast<QImage>(encoded.imageData()).save(&buffer, "PNG");
+        QVERIFY(buffer.size() > 0);
+    });
+
+    StoredMimeData stored(path);
+    measure("copyBack_first_paste", [&]() {
+        StoredMimeData fresh(path);
+        QVERIFY(!fresh.data("image/png").isEmpty());
+    });
+    measure("copyBack_repeat_paste", [&]() {
+        QVERIFY(!stored.data("image/png").isEmpty());
+    });
+}
+
+void HistoryBenchmark::pageDecode_data() {
+    QTest::addColumn<int>("count");
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("32x1080p") << 32 << QSize(1920, 1080);
+    QTest::newRow("16x4k") << 16 << QSize(3840, 2160);
+}
+
+void HistoryBenchmark::pageDecode() {
+    // 冷加载一页图片：单线程逐个解码 vs PageDecoder 在 1 个和全部核心上并行解码
+    QFETCH(int, count);
+    QFETCH(QSize, size);
+    HistoryGenerator generator;
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QList<PageDecoder::Item> batch;
+    for (int i = 0; i < count; ++i) {
+        PageDecoder::Item item;
+        item.entry.type = StorageManager::ClipboardData::Image;
+        item.entry.id = count - i;
+        item.imagePath = dir.filePath(QString("%1.png").arg(i));
+        QVERIFY(generator.makeImage(size).save(item.imagePath, "PNG"));
+        batch.append(item);
+    }
+
+    const QSize thumbnailSize(200, 150);
+    measure("pageDecode_sequential", [&]() {
+        for (const auto& item : batch) {
+            QImage image(item.imagePath, "PNG");
+            QVERIFY(!PageDecoder::makeThumbnail(image, thumbnailSize).isNull());
+        }
+    });
+
+    QList<int> threadCounts{1, QThread::idealThreadCount()};
+    if (threadCounts.last() <= 1) threadCounts.removeLast();
+    for (int threads : threadCounts) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        PageDecoder decoder;
+        decoder.setThreadPool(&pool);
+        decoder.setThumbnailSize(thumbnailSize);
+
+        int published = 0;
+        quint64 lastId = 0;
+        connect(&decoder, &PageDecoder::decoded, this, [&](const PageDecoder::Item& item) {
+            // 结果必须按原顺序发布
+            QVERIFY(lastId == 0 || item.entry.id < lastId);
+            lastId = item.entry.id;
+            ++published;
+        });
+
+        measure(QString("pageDecode_%1t").arg(threads), [&]() {
+            published = 0;
+            lastId = 0;
+            QEventLoop loop;
+            connect(&decoder, &PageDecoder::finished, &loop, &QEventLoop::quit);
+            decoder.start(batch);
+            loop.exec();
+            QCOMPARE(published, count);
+        });
+    }
+}
+
+void HistoryBenchmark::rowPolish_data() {
+    QTest::addColumn<int>("count");
+    QTest::newRow("100") << 100;
+    QTest::newRow("1k") << 1000;
+}
+
+void HistoryBenchmark::rowPolish() {
+    // 构建并 polish 一批列表行：旧方式每行和每个按钮各调用一次 setStyleSheet，
+    // 主题方式只设置 objectName，由启动时解析好的应用样式表匹配
+    QFETCH(int, count);
+
+    const QString rowSheet = R"(
+       #itemContainer {
+           background-color: #F8F9FA;
+           border-radius: 6px;
+           margin: 5px;
+       }
+    )";
+    const QString buttonSheet = R"(
+        QPushButton {
+            background-color: #4B8BF4;
+            color: white;
+            border: none;
+            padding: 5px 10px;
+            border-radius: 4px;
+        }
+        QPushButton:hover {
+            background-color: #357ABD;
+        }
+    )";
+
+    auto buildRows = [&](QWidget *parent, bool themed) {
+        for (int i = 0; i < count; ++i) {
+            QWidget *row = themed ? new HistoryRow(false, parent) : new QWidget(parent);
+            if (!themed) {
+                row->setObjectName("itemContainer");
+                row->setStyleSheet(rowSheet);
+            }
+            auto *layout = new QHBoxLayout(row);
+            layout->addWidget(new QLabel(QString("entry %1").arg(i)));
+            layout->addStretch();
+            for (const char *text : {"复制", "保存", "置顶"}) {
+                auto *button = new QPushButton(QString::fromUtf8(text));
+                if (themed) {
+                    button->setObjectName(Theme::RowButton);
+                } else {
+                    button->setStyleSheet(buttonSheet);
+                }
+                layout->addWidget(button);
+            }
+            row->ensurePolished();
+            for (auto *child : row->findChildren<QWidget*>()) child->ensurePolished();
+        }
+    };
+
+    auto run = [&](const QString& name, bool themed) {
+        std::unique_ptr<QWidget> parent;
+        measure(name, [&]() {
+            buildRows(parent.get(), themed);
+        }, [&]() {
+            parent = std::make_unique<QWidget>();
+        });
+        // 附加每行耗时，便于与行数无关地比较
+        annotateLast("per_row_us", m_results.last().toObject().value("median_ms").toDouble() * 1000.0 / count);
+    };
+
+    auto *app = qobject_cast<QApplication*>(QCoreApplication::instance());
+    app->setStyleSheet(QString());
+    run("rowPolish_inline", false);
+    Theme::install(app);
+    run("rowPolish_theme", true);
+}
+
+void HistoryBenchmark::chunkText_data() {
+    QTest::addColumn<int>("megabytes");
+    QTest::newRow("4MB") << 4;
+    QTest::newRow("32MB") << 32;
+}
+
+void HistoryBenchmark::chunkText() {
+    // 切分吞吐，以及在中间插入一行后的版本与原版本共享的块数
+    QFETCH(int, megabytes);
+    HistoryGenerator generator;
+    QByteArray payload;
+    payload.reserve(qsizetype(megabytes) * 1024 * 1024);
+    while (payload.size() < qsizetype(megabytes) * 1024 * 1024) {
+        payload += generator.makeText(40, 200).toUtf8();
+        payload += '\n';
+    }
+
+    QList<qsizetype> ends;
+    measure("chunkBoundaries", [&]() {
+        ends = ChunkStore::boundaries(payload.constData(), payload.size());
+    });
+
+    QByteArray edited = payload;
+    edited.insert(edited.size() / 2, "inserted line\n");
+    QTemporaryDir dir;
+    ChunkStore store(dir.path());
+    QStringList first = store.store(payload);
+    QStringList second = store.store(edited);
+    QSet<QString> firstIds(first.begin(), first.end());
+    int shared = 0;
+    for (const auto& id : second) shared += firstIds.contains(id);
+
+    annotateLast("chunks", static_cast<int>(ends.size()));
+    annotateLast("throughput_MBps", megabytes / (m_results.last().toObject().value("median_ms").toDouble() / 1000.0));
+    annotateLast("edited_shared_chunks", shared);
+}
+
+void HistoryBenchmark::tileImage_data() {
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("1080p") << QSize(1920, 1080);
+    QTest::newRow("4k") << QSize(3840, 2160);
+}
+
+void HistoryBenchmark::tileImage() {
+    // 一组连续截图：同一画面每次只有一小块区域变化。
+    // 记录分块写入耗时、重建耗时，以及与逐张存 PNG 相比的磁盘占用
+    QFETCH(QSize, size);
+    HistoryGenerator generator;
+    QImage base = generator.makeImage(size);
+    const int shots = 10;
+    QList<QImage> sequence;
+    qint64 pngBytes = 0;
+    for (int i = 0; i < shots; ++i) {
+        QImage shot = base.copy();
+        QPainter painter(&shot);
+        painter.fillRect(QRect(40 + i * 30, 60, 200, 40), QColor::fromRgb(0xff000000 | (i * 0x151515)));
+        painter.drawText(50 + i * 30, 85, QString("update %1").arg(i));
+        painter.end();
+        pngBytes += ClipboardHistory::encodeImage(shot).size();
+        sequence.append(shot);
+    }
+
+    QTemporaryDir dir;
+    QDir(dir.path()).mkpath("images");
+    TileStore store(dir.path() + "/tiles");
+    int next = 0;
+    measure("tileStore", [&]() {
+        QString mapPath = dir.filePath(QString("images/%1.tiles").arg(next));
+        store.release(store.store(mapPath, sequence.at(next % shots)));
+        ++next;
+    }, nullptr, shots);
+
+    qint64 stored = 0;
+    for (const auto& stat : store.stats()) {
+        if (stat.first == "storedBytes") stored = stat.second;
+    }
+    // 整组截图分别存 PNG 与分块存放（重复写入的相同块不计）的字节数
+    annotateLast("png_bytes", pngBytes);
+    annotateLast("tile_bytes", stored);
+
+    QImage restored;
+    measure("tileLoad", [&]() {
+        restored = TileStore::load(dir.filePath("images/0.tiles"));
+    });
+    QCOMPARE(restored.size(), size);
+}
+
+void HistoryBenchmark::columnFilter_data() {
+    QTest::addColumn<bool>("recent");
+    QTest::newRow("last_hour") << true;
+    QTest::newRow("all_time") << false;
+}
+
+void HistoryBenchmark::columnFilter() {
+    // 一百万条元数据（约每 30 秒一条），筛选超过 1 MB 的图片：
+    // 限定最近一小时时先二分缩小范围，不限时间时整列扫描
+    QFETCH(bool, recent);
+    const qsizetype count = 1000000;
+    QRandomGenerator random(42);
+    EntryColumns columns;
+    columns.reserve(count);
+    const qint64 start = QDateTime::currentMSecsSinceEpoch() - count * 30000;
+    for (qsizetype i = 0; i < count; ++i) {
+        int type = random.bounded(4) == 0 ? StorageManager::ClipboardData::Image : StorageManager::ClipboardData::Text;
+        qint64 bytes = type == StorageManager::ClipboardData::Image ? random.bounded(4 * 1024 * 1024) : random.bounded(4096);
+        columns.append(i + 1, type, start + i * 30000, bytes, 0);
+    }
+
+    EntryColumns::Query query;
+    query.type = StorageManager::ClipboardData::Image;
+    query.minBytes = 1024 * 1024;
+    if (recent) query.sinceMs = QDateTime::currentMSecsSinceEpoch() - 3600 * 1000;
+
+    QList<qsizetype> rows;
+    measure("columnFilter", [&]() {
+        rows = columns.select(query);
+    }, nullptr, 10);
+    annotateLast("matches", static_cast<qint64>(rows.size()));
+}
+
+void HistoryBenchmark::removeEntries_data() {
+    QTest::addColumn<int>("removed");
+    QTest::newRow("1") << 1;
+    QTest::newRow("100") << 100;
+}
+
+void HistoryBenchmark::removeEntries() {
+    // 一万条历史中删除 k 条：追加删除记录与重写整个历史文件对比
+    QFETCH(int, removed);
+    const int count = 10000;
+    HistoryGenerator generator;
+    QList<StorageManager::ClipboardData> entries = generator.generate(count, 0.0, QSize(1280, 720));
+    QList<quint64> ids;
+    for (int i = 0; i < removed; ++i) ids.append(entries.at(i * (count / removed)).id);
+
+    QTemporaryDir dir;
+    StorageManager storage;
+    storage.setStoragePath(dir.path());
+    storage.setStorageLimit(count);
+    QVERIFY(storage.saveHistory(entries));
+
+    measure("removeEntries_tombstone", [&]() {
+        QVERIFY(storage.appendTombstones(ids));
+    });
+    // 重写之前确认删除记录已生效
+    QCOMPARE(storage.loadIndex(), count - removed);
+
+    QList<StorageManager::ClipboardData> kept = entries;
+    const QSet<quint64> idSet(ids.cbegin(), ids.cend());
+    kept.removeIf([&](const StorageManager::ClipboardData& entry) { return idSet.contains(entry.id); });
+    measure("removeEntries_rewrite", [&]() {
+        QVERIFY(storage.saveHistory(kept));
+    });
+    QCOMPARE(storage.loadIndex(), count - removed);
+
+    // 内存中的删除（列压缩、统计更新）加上追加删除记录；ClipboardHistory
+    // 使用默认数据目录（测试模式下为临时位置），每轮重新写入并加载，不计时
+    StorageManager defaultStorage;
+    defaultStorage.setStorageLimit(count);
+    std::unique_ptr<ClipboardHistory> history;
+    measure("removeEntries_history", [&]() {
+        history->removeEntries(ids);
+    }, [&]() {
+        history.reset();
+        QVERIFY(defaultStorage.saveHistory(entries));
+        history = std::make_unique<ClipboardHistory>();
+        history->setMaxItems(count);
+        QCOMPARE(static_cast<int>(history->entries().size()), count);
+    });
+    QCOMPARE(static_cast<int>(history->entries().size()), count - removed);
+    history.reset();
+    QVERIFY(defaultStorage.saveHistory({}));
+}
+
+int main(int argc, char *argv[]) {
+    // 默认无界面运行
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    app.setApplicationName("clipboard_manager_bench");
+    Theme::install(&app);
+
+    HistoryBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "historybenchmark.moc"
@@ -0,0 +1,76 @@
+// historygenerator.cpp
+#include "historygenerator.h"
+#include <QPainter>
+#include <QPixmap>
+#include <QStringList>
+
+namespace {
+const QStringList WORDS = {
+    "clipboard", "history", "QString", "return", "const", "auto", "void", "int",
+    "剪贴板", "历史", "记录", "复制", "图片", "文本", "std::vector", "nullptr",
+    "https://example.com/api/v1", "{\"id\": 42}", "SELECT * FROM items", "\n", "\t"
+};
+}
+
+HistoryGenerator::HistoryGenerator(quint32 seed)
+    : m_random(seed) {}
+
+QString HistoryGenerator::makeText(int minLength, int maxLength) {
+    int target = m_random.bounded(minLength, maxLength + 1);
+    QString text;
+    text.reserve(target + 32);
+    while (text.size() < target) {
+        text += WORDS.at(m_random.bounded(int(WORDS.size())));
+        text += ' ';
+    }
+    return text.left(target);
+}
+
+QImage HistoryGenerator::makeImage(const QSize& size) {
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(QColor(240, 240, 240));
+
+    QPainter painter(&image);
+    // 窗口色块
+    for (int i = 0; i < 12; ++i) {
+        QRect rect(m_random.bounded(size.width()), m_random.bounded(size.height()),
+                   m_random.bounded(size.width() / 2 + 1), m_random.bounded(size.height() / 2 + 1));
+        painter.fillRect(rect, QColor::fromRgb(m_random.generate() | 0xff000000));
+    }
+    // 文字行
+    painter.setPen(Qt::black);
+    for (int y = 20; y < size.height(); y += 24) {
+        painter.drawText(10, y, makeText(20, 120));
+    }
+    painter.end();
+
+    // 少量噪点，避免过于理想的压缩率
+    for (int i = 0; i < size.width() * size.height() / 200; ++i) {
+        image.setPixel(m_random.bounded(size.width()), m_random.bounded(size.height()),
+                       m_random.generate() | 0xff000000);
+    }
+    return image;
+}
+
+QList<StorageManager::ClipboardData> HistoryGenerator::generate(int count, double imageRatio, const QSize& imageSize) {
+    QList<StorageManager::ClipboardData> items;
+    items.reserve(count);
+
+    QDateTime timestamp = QDateTime(QDate(2024, 1, 1), QTime(12, 0));
+    for (int i = 0; i < count; ++i) {
+        StorageManager::ClipboardData item;
+        item.id = count - i;
+        item.timestamp = timestamp.addSecs(-i * 37);
+
+        if (m_random.generateDouble() < imageRatio) {
+            item.type = StorageManager::ClipboardData::Image;
+            item.image = QPixmap::fromImage(makeImage(imageSize));
+            item.hash = QString("bench_%1_%2").arg(imageSize.width()).arg(i);
+        } else {
+            item.type = StorageManager::ClipboardData::Text;
+            item.text = makeText(10, 2000);
+        }
+        items.append(std::move(item));
+    }
+    return items;
+}
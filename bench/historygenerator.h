@@ -0,0 +1,26 @@
+// historygenerator.h
+#ifndef HISTORYGENERATOR_H
+#define HISTORYGENERATOR_H
+
+#include <QRandomGenerator>
+#include <QImage>
+#include <QList>
+#include "../components/storagemanager.h"
+
+// 生成可复现的合成历史：相同种子得到完全相同的文本和图片
+class HistoryGenerator {
+public:
+    explicit HistoryGenerator(quint32 seed = 20241019);
+
+    // imageRatio: 图片条目占比 (0~1)
+    QList<StorageManager::ClipboardData> generate(int count, double imageRatio, const QSize& imageSize);
+
+    QString makeText(int minLength, int maxLength);
+    // 类截图内容：色块 + 文字行 + 少量噪点，压缩特性接近真实截图
+    QImage makeImage(const QSize& size);
+
+private:
+    QRandomGenerator m_random;
+};
+
+#endif // HISTORYGENERATOR_H
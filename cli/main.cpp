@@ -0,0 +1,368 @@
+// main.cpp - 命令行客户端：直接读写历史存储，或连接正在运行的后台进程
+//
+//   clipboard_manager_cli dump [--type text|image] [--limit N]    按 NDJSON 逐行输出
+//   clipboard_manager_cli search <query> [--type ...] [--limit N]
+//   clipboard_manager_cli cat <id>                                  输出原始载荷（文本为 UTF-8，图片为 PNG）
+//   clipboard_manager_cli remove <id>[,<id>...]                    删除指定条目（包括置顶）
+//   clipboard_manager_cli remove --match [<query>] [--type ...]     删除所有匹配的普通条目，可与 --since 等条件组合
+//   clipboard_manager_cli export <dir>                              导出索引和图片到目录
+//   clipboard_manager_cli restore <dir>                             从导出目录恢复（需先停止后台进程）
+#include "../components/storagemanager.h"
+#include "../components/tilestore.h"
+#include "../components/entrycolumns.h"
+#include "../components/ipc/ipcprotocol.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QFile>
+#include <QDir>
+#include <cstdio>
+
+namespace {
+
+const int PAGE_SIZE = 500;
+const qint64 COPY_BUFFER_SIZE = 64 * 1024;
+
+QTextStream& errorStream() {
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+int fail(const QString& message) {
+    errorStream() << message << Qt::endl;
+    return 1;
+}
+
+// 标准输出：NDJSON 和原始字节共用一个带缓冲的设备
+class Output {
+public:
+    Output() { m_file.open(stdout, QIODevice::WriteOnly); }
+    ~Output() { m_file.flush(); }
+
+    void writeEntry(const StorageManager::ClipboardData& entry) {
+        QByteArray line = QJsonDocument(IpcProtocol::entryToJson(entry)).toJson(QJsonDocument::Compact);
+        line.append('\n');
+        m_file.write(line);
+    }
+
+    void write(const char *data, qint64 size) { m_file.write(data, size); }
+    void write(const QByteArray& data) { m_file.write(data); }
+
+private:
+    QFile m_file;
+};
+
+// 同步方式访问后台进程（命令行不订阅事件，应答按请求顺序到达）
+class RemoteSession {
+public:
+    bool connectToDaemon() {
+        m_socket.connectToServer(IpcProtocol::serverName());
+        return m_socket.waitForConnected(200);
+    }
+
+    bool request(QJsonObject request, QJsonObject& response) {
+        request["seq"] = ++m_seq;
+        m_socket.write(IpcProtocol::encodeMessage(request));
+        m_socket.flush();
+        return readMessage(response) && response["ok"].toBool();
+    }
+
+    bool readMessage(QJsonObject& message) {
+        while (!m_socket.canReadLine()) {
+            if (!m_socket.waitForReadyRead(5000)) return false;
+        }
+        return IpcProtocol::decodeMessage(m_socket.readLine(), message);
+    }
+
+    bool copyRaw(qint64 bytes, Output& out) {
+        while (bytes > 0) {
+            if (m_socket.bytesAvailable() == 0 && !m_socket.waitForReadyRead(5000)) return false;
+            QByteArray data = m_socket.read(qMin(bytes, COPY_BUFFER_SIZE));
+            out.write(data);
+            bytes -= data.size();
+        }
+        return true;
+    }
+
+private:
+    QLocalSocket m_socket;
+    int m_seq = 0;
+};
+
+struct Filter {
+    EntryColumns::Query meta;   // 类型、时间和大小条件
+    qint64 limit = -1;
+    QString query;
+    StorageManager *storage = nullptr;  // 直接读取时用于补算旧记录的图片大小
+
+    qint64 entryBytes(const StorageManager::ClipboardData& entry) const {
+        if (entry.bytes > 0) return entry.bytes;
+        if (entry.type == StorageManager::ClipboardData::Image) return storage ? storage->imageBytes(entry.hash) : 0;
+        return (entry.isChunked() ? entry.textLength : entry.text.size()) * qint64(sizeof(QChar));
+    }
+
+    bool matches(const StorageManager::ClipboardData& entry) const {
+        if (!meta.isEmpty()) {
+            quint8 flags = (entry.pinned ? EntryColumns::Pinned : 0) | (entry.isChunked() ? EntryColumns::Chunked : 0);
+            if (!meta.matches(entry.type, entry.timestamp.toMSecsSinceEpoch(), entryBytes(entry), flags)) return false;
+        }
+        // 与后台的 ClipboardHistory::search 相同：分块文本只匹配预览
+        return query.isEmpty() || entry.matchesQuery(query);
+    }
+};
+
+// dump / search：按页向后台请求，每页输出后即释放
+int listRemote(RemoteSession& session, const Filter& filter, Output& out) {
+    quint64 before = 0;
+    qint64 written = 0;
+    while (true) {
+        QJsonObject request;
+        if (filter.query.isEmpty() && filter.meta.isEmpty()) {
+            request = {{"op", "page"}, {"count", PAGE_SIZE}};
+        } else {
+            request = {{"op", "search"}, {"query", filter.query}, {"limit", PAGE_SIZE}};
+            IpcProtocol::queryToJson(filter.meta, request);
+        }
+        request["before"] = static_cast<qint64>(before);
+
+        QJsonObject response;
+        if (!session.request(request, response)) {
+            return fail("后台请求失败: " + response["error"].toString());
+        }
+
+        const QJsonArray entries = response["entries"].toArray();
+        for (const auto& value : entries) {
+            if (filter.limit >= 0 && written >= filter.limit) return 0;
+            StorageManager::ClipboardData entry = IpcProtocol::entryFromJson(value.toObject());
+            out.writeEntry(entry);
+            before = entry.id;
+            written++;
+        }
+        if (response["finished"].toBool() || entries.isEmpty()) return 0;
+    }
+}
+
+int listDirect(StorageManager& storage, const Filter& filter, Output& out) {
+    qint64 written = 0;
+    bool ok = storage.readHistory([&](const StorageManager::ClipboardData& entry) {
+        if (filter.limit >= 0 && written >= filter.limit) return false;
+        if (!filter.matches(entry)) return true;
+        out.writeEntry(entry);
+        written++;
+        return true;
+    });
+    return ok ? 0 : fail(storage.getLastError());
+}
+
+int catRemote(RemoteSession& session, quint64 id, Output& out) {
+    QJsonObject response;
+    if (!session.request({{"op", "fetch"}, {"id", static_cast<qint64>(id)}}, response)) {
+        return fail("获取失败: " + response["error"].toString());
+    }
+
+    qint64 chunks = response["chunks"].toInteger();
+    for (qint64 i = 0; i < chunks; ++i) {
+        QJsonObject frame;
+        if (!session.readMessage(frame) || !session.copyRaw(frame["bytes"].toInteger(), out)) {
+            return fail("传输中断");
+        }
+    }
+    return 0;
+}
+
+int catDirect(StorageManager& storage, quint64 id, Output& out) {
+    StorageManager::ClipboardData found;
+    bool exists = false;
+    storage.readHistory([&](const StorageManager::ClipboardData& entry) {
+        if (entry.id != id) return true;
+        found = entry;
+        exists = true;
+        return false;
+    });
+    if (!exists) return fail("未找到条目");
+
+    if (found.type == StorageManager::ClipboardData::Text) {
+        out.write(storage.loadTextData(found));
+        return 0;
+    }
+
+    QString path = storage.imagePath(found.hash);
+    if (TileStore::isMapPath(path)) {
+        QByteArray png = storage.loadImageData(found.hash);
+        if (png.isEmpty()) return fail("无法读取图片文件");
+        out.write(png);
+        return 0;
+    }
+
+    // 图片按固定大小的缓冲区拷贝，不解码
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return fail("无法读取图片文件");
+    QByteArray buffer(COPY_BUFFER_SIZE, Qt::Uninitialized);
+    qint64 read = 0;
+    while ((read = file.read(buffer.data(), buffer.size())) > 0) {
+        out.write(buffer.constData(), read);
+    }
+    return 0;
+}
+
+int removeRemote(RemoteSession& session, const QList<quint64>& ids, const Filter& filter, bool match) {
+    QJsonObject request{{"op", "remove"}};
+    if (match) {
+        request["query"] = filter.query;
+        IpcProtocol::queryToJson(filter.meta, request);
+    } else {
+        QJsonArray array;
+        for (quint64 id : ids) array.append(static_cast<qint64>(id));
+        request["ids"] = array;
+    }
+    QJsonObject response;
+    if (!session.request(request, response)) return fail("删除失败: " + response["error"].toString());
+    errorStream() << "已删除 " << response["removed"].toInteger() << " 条记录" << Qt::endl;
+    return 0;
+}
+
+// 直接删除只追加删除记录，不重写历史文件
+int removeDirect(StorageManager& storage, const QList<quint64>& ids, const Filter& filter, bool match) {
+    const QSet<quint64> wanted(ids.cbegin(), ids.cend());
+    QList<quint64> removed;
+    bool ok = storage.readHistory([&](const StorageManager::ClipboardData& entry) {
+        bool hit = match ? (!entry.pinned && filter.matches(entry)) : wanted.contains(entry.id);
+        if (hit) removed.append(entry.id);
+        return true;
+    });
+    if (!ok) return fail(storage.getLastError());
+    if (!storage.appendTombstones(removed)) return fail(storage.getLastError());
+    errorStream() << "已删除 " << removed.size() << " 条记录" << Qt::endl;
+    return 0;
+}
+
+// export / restore：两个存储之间逐条拷贝，内存占用与条数无关
+int copyStore(StorageManager& source, StorageManager& target) {
+    if (!target.beginHistoryWrite()) return fail(target.getLastError());
+
+    qint64 copied = 0;
+    bool ok = source.readHistory([&](const StorageManager::ClipboardData& entry) {
+        if (entry.type == StorageManager::ClipboardData::Image &&
+            !target.importImage(source, entry.hash)) {
+            return true;
+        }
+        if (entry.isChunked() && !target.importChunks(source, entry.chunks)) return true;
+        if (target.writeHistoryEntry(entry)) copied++;
+        return true;
+    });
+
+    if (!ok) return fail(source.getLastError());
+    if (!target.commitHistoryWrite()) return fail(target.getLastError());
+    errorStream() << "已复制 " << copied << " 条记录" << Qt::endl;
+    return 0;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    // 与界面和后台进程使用相同的应用名，共享数据目录和套接字名
+    app.setApplicationName("clipboard_manager");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("剪贴板历史命令行工具");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "dump | search | cat | remove | export | restore");
+    parser.addPositionalArgument("argument", "查询字符串、条目 id 或目录", "[argument]");
+    QCommandLineOption typeOption("type", "只输出指定类型 (text|image)", "type");
+    QCommandLineOption limitOption("limit", "最多输出条数", "count");
+    QCommandLineOption storeOption("store", "历史存储目录（默认为应用数据目录）", "dir");
+    QCommandLineOption directOption("direct", "不连接后台进程，直接读取存储文件");
+    QCommandLineOption sinceOption("since", "只输出最近 N 秒内的条目", "seconds");
+    QCommandLineOption minSizeOption("min-size", "只输出载荷不小于 N 字节的条目", "bytes");
+    QCommandLineOption maxSizeOption("max-size", "只输出载荷不大于 N 字节的条目", "bytes");
+    QCommandLineOption matchOption("match", "remove：按查询字符串和筛选条件删除，而不是按 id");
+    parser.addOptions({typeOption, limitOption, storeOption, directOption, sinceOption, minSizeOption, maxSizeOption,
+                       matchOption});
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.isEmpty()) parser.showHelp(1);
+    const QString command = args.first();
+    const QString argument = args.value(1);
+
+    Filter filter;
+    filter.meta.type = IpcProtocol::typeFromString(parser.value(typeOption));
+    if (parser.isSet(sinceOption)) {
+        filter.meta.sinceMs = QDateTime::currentMSecsSinceEpoch() - parser.value(sinceOption).toLongLong() * 1000;
+    }
+    if (parser.isSet(minSizeOption)) filter.meta.minBytes = parser.value(minSizeOption).toLongLong();
+    if (parser.isSet(maxSizeOption)) filter.meta.maxBytes = parser.value(maxSizeOption).toLongLong();
+    if (parser.isSet(limitOption)) filter.limit = parser.value(limitOption).toLongLong();
+
+    StorageManager storage;
+    if (parser.isSet(storeOption)) storage.setStoragePath(parser.value(storeOption));
+    filter.storage = &storage;
+
+    // 后台进程在运行时优先通过它查询（内存中的历史比磁盘更新）
+    RemoteSession session;
+    bool remote = !parser.isSet(directOption) && !parser.isSet(storeOption) && session.connectToDaemon();
+
+    Output out;
+    if (command == "dump" || command == "search") {
+        if (command == "search") {
+            if (argument.isEmpty()) return fail("缺少查询字符串");
+            filter.query = argument;
+        }
+        return remote ? listRemote(session, filter, out) : listDirect(storage, filter, out);
+    }
+
+    if (command == "cat") {
+        bool ok = false;
+        quint64 id = argument.toULongLong(&ok);
+        if (!ok) return fail("无效的条目 id");
+        return remote ? catRemote(session, id, out) : catDirect(storage, id, out);
+    }
+
+    if (command == "remove") {
+        const bool match = parser.isSet(matchOption);
+        QList<quint64> ids;
+        if (match) {
+            filter.query = argument;
+            if (filter.query.isEmpty() && filter.meta.isEmpty()) return fail("缺少删除条件");
+        } else {
+            for (const auto& part : argument.split(',', Qt::SkipEmptyParts)) {
+                bool ok = false;
+                ids.append(part.trimmed().toULongLong(&ok));
+                if (!ok) return fail("无效的条目 id: " + part);
+            }
+            if (ids.isEmpty()) return fail("缺少条目 id");
+        }
+        if (parser.isSet(directOption) && !parser.isSet(storeOption)) {
+            // 后台进程下次保存会用内存中的历史覆盖删除记录
+            RemoteSession probe;
+            if (probe.connectToDaemon()) return fail("后台进程正在运行，请去掉 --direct/--store 后重试");
+        }
+        return remote ? removeRemote(session, ids, filter, match) : removeDirect(storage, ids, filter, match);
+    }
+
+    if (command == "export") {
+        if (argument.isEmpty()) return fail("缺少导出目录");
+        if (remote) {
+            // 先让后台进程落盘，导出的是最新状态
+            QJsonObject response;
+            session.request({{"op", "save"}}, response);
+        }
+        StorageManager target;
+        target.setStoragePath(QDir(argument).absolutePath());
+        return copyStore(storage, target);
+    }
+
+    if (command == "restore") {
+        if (argument.isEmpty()) return fail("缺少导出目录");
+        if (remote) return fail("后台进程正在运行，请先停止后再恢复");
+        StorageManager source;
+        source.setStoragePath(QDir(argument).absolutePath());
+        return copyStore(source, storage);
+    }
+
+    return fail("未知命令: " + command);
+}
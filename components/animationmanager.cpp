@@ -1,83 +1,255 @@
 #include "animationmanager.h"
-#include <QGraphicsScale>
-#include <QPauseAnimation>
+#include "tracer.h"
+#include "ui/toastsurface.h"
+#include <QGraphicsEffect>
+#include <QSettings>
+#include <QRect>
+#include <algorithm>
 
-AnimationManager::AnimationManager(QObject *parent) : QObject(parent) {}
+namespace {
 
-void AnimationManager::playToastAnimation(QWidget* toast, const QPoint& centerPos) {
-    toast->setAttribute(Qt::WA_DeleteOnClose);
-    toast->setAttribute(Qt::WA_TranslucentBackground);
+QString toastText(const QString& message, int repeat) {
+    return repeat > 1 ? QString("%1 (×%2)").arg(message).arg(repeat) : message;
+}
 
-    auto* opacity = new QGraphicsOpacityEffect(toast);
-    toast->setGraphicsEffect(opacity);
+} // namespace
+
+AnimationManager::AnimationManager(QObject *parent) : QObject(parent) {
+    m_ticker.setInterval(FRAME_INTERVAL_MS);
+    m_ticker.setTimerType(Qt::PreciseTimer);
+    connect(&m_ticker, &QTimer::timeout, this, &AnimationManager::onTick);
+    m_toastHold.setSingleShot(true);
+    connect(&m_toastHold, &QTimer::timeout, this, &AnimationManager::startToastExit);
+    m_clock.start();
+    m_frameUs.reserve(FRAME_HISTORY);
+    m_reducedMotion = QSettings().value("ui/reducedMotion", false).toBool();
+}
 
-    auto* group = new QSequentialAnimationGroup(toast);
-    activeAnimations.append(group);
+AnimationManager::~AnimationManager() {
+    m_ticker.stop();
+    m_tweens.clear();
+}
 
-    const int fadeTime = 150; // 减少动画时间
-    const int pauseTime = 800;
+int AnimationManager::animate(QObject* target, const QByteArray& property,
+                              const QVariant& from, const QVariant& to, int durationMs,
+                              const QEasingCurve& easing, int delayMs, Callback onFinished) {
+    if (!target) return 0;
+
+    Tween tween;
+    tween.id = m_nextId++;
+    tween.target = target;
+    tween.property = property;
+    tween.from = from;
+    tween.to = to;
+    tween.easing = easing;
+    tween.startMs = m_clock.elapsed() + qMax(0, delayMs);
+    tween.durationMs = m_reducedMotion ? 0 : qMax(0, durationMs);
+    tween.onFinished = std::move(onFinished);
+
+    // 无需插值时立即到位，回调在下一帧执行
+    if (tween.durationMs == 0 && delayMs <= 0) {
+        target->setProperty(property, to);
+    }
 
-    QRect startGeom = toast->geometry();
-    startGeom.moveCenter(centerPos + QPoint(0, 20));
-    QRect endGeom = startGeom;
-    endGeom.moveCenter(centerPos);
+    m_tweens.append(std::move(tween));
+    if (!m_ticker.isActive()) m_ticker.start();
+    return m_tweens.last().id;
+}
 
-    auto* parallelIn = new QParallelAnimationGroup;
+void AnimationManager::stop(int id, bool jumpToEnd) {
+    for (int i = 0; i < m_tweens.size(); ++i) {
+        if (m_tweens[i].id != id) continue;
+        if (jumpToEnd && m_tweens[i].target) {
+            m_tweens[i].target->setProperty(m_tweens[i].property, m_tweens[i].to);
+        }
+        m_tweens.removeAt(i);
+        return;
+    }
+}
 
-    auto* moveIn = new QPropertyAnimation(toast, "geometry");
-    moveIn->setDuration(fadeTime);
-    moveIn->setStartValue(startGeom);
-    moveIn->setEndValue(endGeom);
-    moveIn->setEasingCurve(QEasingCurve::OutQuad);
+void AnimationManager::stopAll(QObject* target) {
+    m_tweens.erase(std::remove_if(m_tweens.begin(), m_tweens.end(),
+                                  [target](const Tween& tween) { return tween.target == target; }),
+                   m_tweens.end());
+}
 
-    auto* fadeIn = new QPropertyAnimation(opacity, "opacity");
-    fadeIn->setDuration(fadeTime);
-    fadeIn->setStartValue(0.0);
-    fadeIn->setEndValue(1.0);
+bool AnimationManager::isAnimating(QObject* target) const {
+    return std::any_of(m_tweens.begin(), m_tweens.end(),
+                       [target](const Tween& tween) { return tween.target == target; });
+}
 
-    parallelIn->addAnimation(moveIn);
-    parallelIn->addAnimation(fadeIn);
+void AnimationManager::onTick() {
+    TRACE_SCOPE("animation.tick");
+
+    // 帧间隔：定时器空闲后重新启动的第一帧不计入
+    qint64 nowNs = Tracer::nowNs();
+    if (m_lastTickNs > 0) {
+        qint64 frameUs = (nowNs - m_lastTickNs) / 1000;
+        if (m_frameUs.size() < FRAME_HISTORY) {
+            m_frameUs.append(frameUs);
+        } else {
+            m_frameUs[m_frameCursor] = frameUs;
+        }
+        m_frameCursor = (m_frameCursor + 1) % FRAME_HISTORY;
+        ++m_frames;
+        if (frameUs > 2 * FRAME_INTERVAL_MS * 1000) ++m_lateFrames;
+        m_maxFrameUs = qMax(m_maxFrameUs, frameUs);
+        if (Tracer::isEnabled()) Tracer::record("animation.frame", m_lastTickNs, nowNs - m_lastTickNs);
+    }
+    m_lastTickNs = nowNs;
+
+    // 回调可能启动或停止其他补间，先推进完本帧再统一调用
+    QList<Callback> finished;
+    qint64 nowMs = m_clock.elapsed();
+    for (int i = 0; i < m_tweens.size();) {
+        Tween& tween = m_tweens[i];
+        if (!tween.target) {
+            m_tweens.removeAt(i);
+            continue;
+        }
+        if (nowMs < tween.startMs) {
+            ++i;
+            continue;
+        }
+        if (!tween.started) {
+            tween.started = true;
+            if (!tween.from.isValid()) tween.from = tween.target->property(tween.property);
+        }
 
-    auto* pause = new QPauseAnimation(pauseTime);
+        qreal progress = tween.durationMs > 0 ?
+                             qMin<qreal>(1.0, static_cast<qreal>(nowMs - tween.startMs) / tween.durationMs) :
+                             1.0;
+        if (progress < 1.0) {
+            tween.target->setProperty(tween.property,
+                                      interpolate(tween.from, tween.to, tween.easing.valueForProgress(progress)));
+            ++i;
+            continue;
+        }
 
-    auto* parallelOut = new QParallelAnimationGroup;
+        tween.target->setProperty(tween.property, tween.to);
+        if (tween.onFinished) finished.append(std::move(tween.onFinished));
+        m_tweens.removeAt(i);
+    }
 
-    auto* moveOut = new QPropertyAnimation(toast, "geometry");
-    moveOut->setDuration(fadeTime);
-    moveOut->setStartValue(endGeom);
-    QRect finalGeom = endGeom;
-    finalGeom.moveCenter(centerPos + QPoint(0, -20));
-    moveOut->setEndValue(finalGeom);
-    moveOut->setEasingCurve(QEasingCurve::InQuad);
+    if (m_tweens.isEmpty()) {
+        m_ticker.stop();
+        m_lastTickNs = 0;
+    }
+    for (const auto& callback : finished) callback();
+}
 
-    auto* fadeOut = new QPropertyAnimation(opacity, "opacity");
-    fadeOut->setDuration(fadeTime);
-    fadeOut->setStartValue(1.0);
-    fadeOut->setEndValue(0.0);
+QVariant AnimationManager::interpolate(const QVariant& from, const QVariant& to, qreal progress) {
+    auto mix = [progress](qreal a, qreal b) { return a + (b - a) * progress; };
+    switch (to.typeId()) {
+    case QMetaType::Int:
+        return qRound(mix(from.toInt(), to.toInt()));
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return mix(from.toDouble(), to.toDouble());
+    case QMetaType::QPoint: {
+        QPoint a = from.toPoint(), b = to.toPoint();
+        return QPoint(qRound(mix(a.x(), b.x())), qRound(mix(a.y(), b.y())));
+    }
+    case QMetaType::QSize: {
+        QSize a = from.toSize(), b = to.toSize();
+        return QSize(qRound(mix(a.width(), b.width())), qRound(mix(a.height(), b.height())));
+    }
+    case QMetaType::QRect: {
+        QRect a = from.toRect(), b = to.toRect();
+        return QRect(qRound(mix(a.x(), b.x())), qRound(mix(a.y(), b.y())),
+                     qRound(mix(a.width(), b.width())), qRound(mix(a.height(), b.height())));
+    }
+    default:
+        return progress < 1.0 ? from : to;
+    }
+}
 
-    parallelOut->addAnimation(moveOut);
-    parallelOut->addAnimation(fadeOut);
+void AnimationManager::showToast(QWidget* host, const QString& message) {
+    if (!host) return;
+    TRACE_SCOPE("animation.toast.start");
 
-    group->addAnimation(parallelIn);
-    group->addAnimation(pause);
-    group->addAnimation(parallelOut);
+    if (!m_toast || m_toast->parentWidget() != host) {
+        if (m_toast) {
+            m_toastHold.stop();
+            stopAll(m_toast);
+            m_toast->deleteLater();
+        }
+        m_toast = new ToastSurface(host);
+        m_toastQueue.clear();
+        m_toastVisible = false;
+        m_toastLeaving = false;
+    }
 
-    connect(group, &QSequentialAnimationGroup::finished, this, [this, group, toast]() {
-        toast->close();
-        cleanupAnimation(group);
-    });
+    // 正在显示同一条消息：合并计数并重新计时
+    if (m_toastVisible && !m_toastLeaving && message == m_toastMessage) {
+        ++m_toastRepeat;
+        int centerX = m_toast->x() + m_toast->width() / 2;
+        m_toast->setText(toastText(m_toastMessage, m_toastRepeat));
+        m_toast->move(centerX - m_toast->width() / 2, m_toast->y());
+        scheduleToastExit();
+        return;
+    }
+
+    if (!m_toastQueue.isEmpty() && m_toastQueue.last().first == message) {
+        ++m_toastQueue.last().second;
+        return;
+    }
+    // 队列已满时丢弃最旧的消息
+    if (m_toastQueue.size() >= MAX_TOAST_QUEUE) m_toastQueue.removeFirst();
+    m_toastQueue.append({message, 1});
 
-    group->start(QAbstractAnimation::DeleteWhenStopped);
+    if (!m_toastVisible) showNextToast();
 }
 
+void AnimationManager::showNextToast() {
+    if (!m_toast) return;
+    if (m_toastQueue.isEmpty()) {
+        m_toast->hide();
+        m_toastVisible = false;
+        return;
+    }
 
+    auto next = m_toastQueue.takeFirst();
+    m_toastMessage = next.first;
+    m_toastRepeat = next.second;
+    m_toast->setText(toastText(m_toastMessage, m_toastRepeat));
 
-AnimationManager::~AnimationManager() {
-    qDeleteAll(activeAnimations);
+    QWidget* host = m_toast->parentWidget();
+    QPoint endPos(host->width() / 2 - m_toast->width() / 2, host->height() / 2 - m_toast->height() / 2);
+
+    m_toastVisible = true;
+    m_toastLeaving = false;
+    m_toast->setOpacity(0.0);
+    m_toast->move(endPos + QPoint(0, 20));
+    m_toast->show();
+    m_toast->raise();
+
+    animate(m_toast, "pos", endPos + QPoint(0, 20), endPos, TOAST_DURATION, QEasingCurve::OutQuad);
+    animate(m_toast, "opacity", 0.0, 1.0, TOAST_DURATION, QEasingCurve::Linear);
+    scheduleToastExit();
 }
 
+void AnimationManager::scheduleToastExit() {
+    // 淡入后停留 TOAST_HOLD 再淡出；重复调用时重新计时
+    m_toastHold.start(TOAST_DURATION + TOAST_HOLD);
+}
+
+void AnimationManager::startToastExit() {
+    if (!m_toast) return;
+    TRACE_SCOPE("animation.toast.finished");
+    m_toastLeaving = true;
+
+    QPoint pos = m_toast->pos();
+    animate(m_toast, "pos", pos, pos - QPoint(0, 20), TOAST_DURATION, QEasingCurve::InQuad);
+    animate(m_toast, "opacity", 1.0, 0.0, TOAST_DURATION, QEasingCurve::Linear, 0, [this]() {
+        m_toastVisible = false;
+        m_toastLeaving = false;
+        showNextToast();
+    });
+}
 
 void AnimationManager::playPreviewShowAnimation(QWidget* preview, const QRect& finalGeometry) {
+    TRACE_SCOPE("animation.preview.start");
     if(!preview || !preview->isVisible()) return;
 
     preview->setAttribute(Qt::WA_TranslucentBackground);
@@ -86,100 +258,95 @@ void AnimationManager::playPreviewShowAnimation(QWidget* preview, const QRect& f
     startGeom.setSize(QSize(finalGeometry.width()/2, finalGeometry.height()/2));
     startGeom.moveCenter(finalGeometry.center());
 
-    auto* anim = new QPropertyAnimation(preview, "geometry");
-    activeAnimations.append(anim);
-
-    anim->setDuration(200);
-    anim->setStartValue(startGeom);
-    anim->setEndValue(finalGeometry);
-    anim->setEasingCurve(QEasingCurve::OutQuad);
-
-    connect(anim, &QPropertyAnimation::finished, this, [this, anim]() {
-        cleanupAnimation(anim);
-    });
-
-    anim->start(QAbstractAnimation::DeleteWhenStopped);
+    animate(preview, "geometry", startGeom, finalGeometry, PREVIEW_DURATION, QEasingCurve::OutQuad);
 }
 
 void AnimationManager::playPreviewHideAnimation(QWidget* preview, const QRect& finalGeometry) {
+    Q_UNUSED(finalGeometry);
+    if (!preview) return;
+
     QRect startGeom = preview->geometry();
     QRect endGeom = startGeom;
     endGeom.setSize(QSize(startGeom.width()/2, startGeom.height()/2));
     endGeom.moveCenter(startGeom.center());
 
-    auto* anim = new QPropertyAnimation(preview, "geometry");
-    anim->setDuration(150); // Reduced duration
-    anim->setStartValue(startGeom);
-    anim->setEndValue(endGeom);
-    anim->setEasingCurve(QEasingCurve::InQuad);
-
-    connect(anim, &QPropertyAnimation::finished, preview, &QWidget::close);
-    anim->start(QAbstractAnimation::DeleteWhenStopped);
+    QPointer<QWidget> guard(preview);
+    stopAll(preview);
+    animate(preview, "geometry", startGeom, endGeom, 150, QEasingCurve::InQuad, 0, [guard]() {
+        if (guard) guard->close();
+    });
 }
 
 void AnimationManager::playListItemAnimation(QWidget* item) {
+    if (!item) return;
     item->setAttribute(Qt::WA_TranslucentBackground);
     item->setAttribute(Qt::WA_OpaquePaintEvent);
 
-    auto* heightAnim = new QPropertyAnimation(item, "minimumHeight");
-    heightAnim->setDuration(150);
-    heightAnim->setStartValue(0);
-    heightAnim->setEndValue(item->sizeHint().height());
-    heightAnim->setEasingCurve(QEasingCurve::OutQuad);
-    heightAnim->start(QAbstractAnimation::DeleteWhenStopped);
+    animate(item, "minimumHeight", 0, item->sizeHint().height(), LISTITEM_DURATION, QEasingCurve::OutQuad);
 }
 
 void AnimationManager::playButtonClickAnimation(QPushButton* button) {
-    if(!button) return;
-
-    // 停止已有动画
-    for(auto* anim : activeAnimations) {
-        if(anim->parent() == button) {
-            cleanupAnimation(anim);
-            return;  // 等待动画完全停止
-        }
-    }
-
-    // 使用属性存储原始大小和状态
-    static const char* ORIGINAL_GEOMETRY = "originalGeometry";
-    static const char* IS_SCALED = "isScaled";
+    // 上一次按压还没结束时忽略，避免几何尺寸累积偏移
+    if(!button || isAnimating(button)) return;
+    TRACE_SCOPE("animation.button.start");
+
+    QRect originalGeom = button->geometry();
+    QRect pressedGeom = originalGeom.adjusted(
+        originalGeom.width() * 0.025,
+        originalGeom.height() * 0.025,
+        -originalGeom.width() * 0.025,
+        -originalGeom.height() * 0.025
+        );
+
+    QPointer<QPushButton> guard(button);
+    animate(button, "geometry", originalGeom, pressedGeom, BUTTON_DURATION, QEasingCurve::InQuad, 0,
+            [this, guard, originalGeom, pressedGeom]() {
+                if (!guard) return;
+                animate(guard, "geometry", pressedGeom, originalGeom, BUTTON_DURATION, QEasingCurve::OutQuad);
+            });
+}
 
-    if(!button->property(ORIGINAL_GEOMETRY).isValid()) {
-        button->setProperty(ORIGINAL_GEOMETRY, button->geometry());
-        button->setProperty(IS_SCALED, false);
+void AnimationManager::setEffect(QWidget* widget, QGraphicsEffect* effect) {
+    if (!widget) return;
+    // 控件接管效果的所有权，随控件一起销毁
+    widget->setGraphicsEffect(effect);
+    if (!effect) {
+        m_effects.remove(widget);
+        return;
     }
-
-    auto* animGroup = new QParallelAnimationGroup(button);
-    activeAnimations.append(animGroup);
-
-    QRect originalGeom = button->property(ORIGINAL_GEOMETRY).toRect();
-    bool isScaled = button->property(IS_SCALED).toBool();
-
-    QRect targetGeom;
-    if(!isScaled) {
-        targetGeom = originalGeom;
-        targetGeom.adjust(
-            originalGeom.width() * 0.025,
-            originalGeom.height() * 0.025,
-            -originalGeom.width() * 0.025,
-            -originalGeom.height() * 0.025
-            );
-    } else {
-        targetGeom = originalGeom;
+    if (!m_effects.contains(widget)) {
+        connect(widget, &QObject::destroyed, this, [this, widget]() {
+            m_effects.remove(widget);
+        });
     }
+    m_effects.insert(widget, effect);
+}
 
-    auto* anim = new QPropertyAnimation(button, "geometry", animGroup);
-    anim->setDuration(60);
-    anim->setStartValue(button->geometry());
-    anim->setEndValue(targetGeom);
-    anim->setEasingCurve(!isScaled ? QEasingCurve::InQuad : QEasingCurve::OutQuad);
-
-    connect(animGroup, &QParallelAnimationGroup::finished, this, [this, animGroup, button, isScaled]() {
-        button->setProperty(IS_SCALED, !isScaled);
-        cleanupAnimation(animGroup);
-    });
+void AnimationManager::setReducedMotion(bool enabled) {
+    m_reducedMotion = enabled;
+    QSettings().setValue("ui/reducedMotion", enabled);
+    if (!enabled) return;
+    // 进行中的补间在下一帧直接到达终值
+    for (auto& tween : m_tweens) tween.durationMs = 0;
+}
 
-    animGroup->start(QAbstractAnimation::DeleteWhenStopped);
+QList<QPair<QString, qint64>> AnimationManager::stats() const {
+    QList<qint64> sorted = m_frameUs;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) -> qint64 {
+        if (sorted.isEmpty()) return 0;
+        return sorted[qMin(static_cast<int>(sorted.size()) - 1, static_cast<int>(p * sorted.size()))];
+    };
+
+    return {
+        {"frames", static_cast<qint64>(m_frames)},
+        {"late_frames", static_cast<qint64>(m_lateFrames)},
+        {"frame_p50_us", percentile(0.50)},
+        {"frame_p99_us", percentile(0.99)},
+        {"frame_max_us", m_maxFrameUs},
+        {"active_tweens", static_cast<qint64>(m_tweens.size())},
+        {"tracked_effects", static_cast<qint64>(m_effects.size())},
+    };
 }
 
 QEasingCurve AnimationManager::getCustomBounceEasing() const {
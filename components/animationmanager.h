@@ -4,22 +4,42 @@
 
 #include <QObject>
 #include <QWidget>
-#include <QPropertyAnimation>
-#include <QSequentialAnimationGroup>
-#include <QParallelAnimationGroup>
-#include <QGraphicsOpacityEffect>
+#include <QPointer>
+#include <QVariant>
 #include <QEasingCurve>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QHash>
+#include <QList>
+#include <QPair>
 #include <QPushButton>
+#include <functional>
 
+class QGraphicsEffect;
+class ToastSurface;
+
+// 所有动画由同一个定时器逐帧推进，不再为每个动画创建 QPropertyAnimation
 class AnimationManager : public QObject {
     Q_OBJECT
 
 public:
+    using Callback = std::function<void()>;
+
     explicit AnimationManager(QObject *parent = nullptr);
     ~AnimationManager() override;
 
-    // Toast动画
-    void playToastAnimation(QWidget* toast, const QPoint& centerPos);
+    // 通用补间：支持 int/double/QPoint/QSize/QRect 属性，返回的 id 可用于 stop()；
+    // 目标销毁时补间自动丢弃，不调用 onFinished
+    int animate(QObject* target, const QByteArray& property,
+                const QVariant& from, const QVariant& to, int durationMs,
+                const QEasingCurve& easing = QEasingCurve::OutQuad,
+                int delayMs = 0, Callback onFinished = nullptr);
+    void stop(int id, bool jumpToEnd = false);
+    void stopAll(QObject* target);
+    bool isAnimating(QObject* target) const;
+
+    // Toast：每个宿主窗口只有一个浮层，消息排队显示，连续重复的消息合并计数
+    void showToast(QWidget* host, const QString& message);
 
     // 预览窗口动画
     void playPreviewShowAnimation(QWidget* preview, const QRect& finalGeometry);
@@ -31,29 +51,76 @@ public:
     // 按钮点击动画
     void playButtonClickAnimation(QPushButton* button);
 
+    // 显式登记图形效果，控件销毁时移除记录，不必遍历对象树查找
+    void setEffect(QWidget* widget, QGraphicsEffect* effect);
+    int trackedEffects() const { return m_effects.size(); }
+
+    // 减少动态效果（设置项 ui/reducedMotion）：不做插值，直接设置终值，延迟仍然保留
+    void setReducedMotion(bool enabled);
+    bool reducedMotion() const { return m_reducedMotion; }
+
+    // 帧统计：帧数、超时帧数、帧间隔 p50/p99/最大值（微秒）和活动补间数
+    QList<QPair<QString, qint64>> stats() const;
+
     // 自定义缓动曲线
     QEasingCurve getCustomBounceEasing() const;
     QEasingCurve getCustomElasticEasing() const;
 
+private slots:
+    void onTick();
+
 private:
-    QGraphicsEffect *scaleEffect;
-    QList<QAbstractAnimation*> activeAnimations; // 跟踪所有活动的动画
+    struct Tween {
+        int id = 0;
+        QPointer<QObject> target;
+        QByteArray property;
+        QVariant from;
+        QVariant to;
+        QEasingCurve easing;
+        qint64 startMs = 0;   // 含延迟
+        int durationMs = 0;
+        bool started = false;
+        Callback onFinished;
+    };
 
-    void cleanupAnimation(QAbstractAnimation* animation){
-        if(!animation) return;
+    static QVariant interpolate(const QVariant& from, const QVariant& to, qreal progress);
+    void showNextToast();
+    void scheduleToastExit();
+    void startToastExit();
 
-        activeAnimations.removeOne(animation);
-        animation->stop();
-        animation->deleteLater();
+    QTimer m_ticker;
+    QElapsedTimer m_clock;
+    QList<Tween> m_tweens;
+    int m_nextId = 1;
+    bool m_reducedMotion = false;
 
-        // Clear any orphaned effects
-        QList<QGraphicsEffect*> effects = animation->findChildren<QGraphicsEffect*>();
-        qDeleteAll(effects);
-    };
-    const int TOAST_DURATION = 300;
-    const int PREVIEW_DURATION = 300;
-    const int LISTITEM_DURATION = 300;
-    const int BUTTON_DURATION = 150;
+    // 帧统计
+    qint64 m_lastTickNs = 0;
+    quint64 m_frames = 0;
+    quint64 m_lateFrames = 0;
+    qint64 m_maxFrameUs = 0;
+    QList<qint64> m_frameUs;   // 最近 FRAME_HISTORY 帧的间隔
+    int m_frameCursor = 0;
+
+    QHash<QWidget*, QPointer<QGraphicsEffect>> m_effects;
+
+    // Toast 队列：(消息, 重复次数)
+    QPointer<ToastSurface> m_toast;
+    QList<QPair<QString, int>> m_toastQueue;
+    QString m_toastMessage;
+    int m_toastRepeat = 0;
+    bool m_toastVisible = false;
+    bool m_toastLeaving = false;
+    QTimer m_toastHold;  // 单次定时：停留期间没有补间，帧定时器可以停下
+
+    static const int FRAME_INTERVAL_MS = 16;
+    static const int FRAME_HISTORY = 240;
+    static const int MAX_TOAST_QUEUE = 3;
+    const int TOAST_DURATION = 150;
+    const int TOAST_HOLD = 800;
+    const int PREVIEW_DURATION = 200;
+    const int LISTITEM_DURATION = 150;
+    const int BUTTON_DURATION = 60;
 };
 
 #endif // ANIMATIONMANAGER_H
@@ -0,0 +1,90 @@
+// capturescheduler.cpp
+#include "capturescheduler.h"
+#include <QSettings>
+
+CaptureScheduler::CaptureScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &CaptureScheduler::fire);
+
+    // 合并窗口可在配置文件中调整：[capture] coalesceMs=100 maxDelayMs=1000
+    QSettings settings;
+    m_windowMs = settings.value("capture/coalesceMs", m_windowMs).toInt();
+    m_maxDelayMs = settings.value("capture/maxDelayMs", m_maxDelayMs).toInt();
+}
+
+void CaptureScheduler::setWindow(int windowMs) {
+    m_windowMs = qMax(0, windowMs);
+}
+
+void CaptureScheduler::notifyChanged() {
+    qint64 second = nowSecond();
+    m_signals.add(second);
+    m_generation.fetch_add(1, std::memory_order_acq_rel);
+
+    if (m_windowMs == 0) {
+        fire();
+        return;
+    }
+
+    if (m_pending) {
+        // 与尚未捕获的变化合并
+        m_coalesced.add(second);
+    } else {
+        m_pending = true;
+        m_pendingSince.start();
+    }
+
+    // 持续变化时不再推迟，保证至少每 maxDelay 捕获一次
+    qint64 remaining = m_maxDelayMs - m_pendingSince.elapsed();
+    if (remaining <= 0) {
+        m_timer.stop();
+        fire();
+        return;
+    }
+    m_timer.start(static_cast<int>(qMin<qint64>(m_windowMs, remaining)));
+}
+
+void CaptureScheduler::fire() {
+    m_pending = false;
+    emit captureDue(generation());
+}
+
+void CaptureScheduler::noteCaptured() {
+    m_captures.add(nowSecond());
+}
+
+void CaptureScheduler::noteDropped() {
+    m_coalesced.add(nowSecond());
+}
+
+QList<QPair<QString, qint64>> CaptureScheduler::stats() const {
+    qint64 second = nowSecond();
+    return {
+        {"signals", m_signals.total},
+        {"captured", m_captures.total},
+        {"coalesced", m_coalesced.total},
+        {"captured_per_sec", m_captures.perSecond(second)},
+        {"coalesced_per_sec", m_coalesced.perSecond(second)},
+        {"window_ms", m_windowMs},
+    };
+}
+
+void CaptureScheduler::RateCounter::add(qint64 nowSecond) {
+    if (nowSecond != second) {
+        previous = (nowSecond == second + 1) ? current : 0;
+        current = 0;
+        second = nowSecond;
+    }
+    ++current;
+    ++total;
+}
+
+qint64 CaptureScheduler::RateCounter::perSecond(qint64 nowSecond) const {
+    // 报告最近一个完整秒的次数
+    if (nowSecond == second) return previous;
+    if (nowSecond == second + 1) return current;
+    return 0;
+}
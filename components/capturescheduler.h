@@ -0,0 +1,69 @@
+// capturescheduler.h
+#ifndef CAPTURESCHEDULER_H
+#define CAPTURESCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+
+// 剪贴板变化的合并调度：窗口期内的连续变化只在最后一次之后捕获一次。
+// 持续变化（终端选区、远程桌面）时最多等待 maxDelay 就强制捕获一次。
+// 每次变化都会递增代号，工作线程上已排队的旧代号任务据此丢弃。
+class CaptureScheduler : public QObject {
+    Q_OBJECT
+public:
+    explicit CaptureScheduler(QObject *parent = nullptr);
+
+    // windowMs 为 0 时不合并，每次变化立即捕获
+    void setWindow(int windowMs);
+    int window() const { return m_windowMs; }
+    void setMaxDelay(int maxDelayMs) { m_maxDelayMs = maxDelayMs; }
+
+    // 剪贴板发出 dataChanged 时调用
+    void notifyChanged();
+
+    quint64 generation() const { return m_generation.load(std::memory_order_acquire); }
+    // 线程安全：工作线程在开始耗时处理前检查，结果发布前再检查一次
+    bool isSuperseded(quint64 generation) const { return generation != this->generation(); }
+
+    void noteCaptured();
+    void noteDropped();   // 已开始的捕获因出现更新的变化而丢弃
+
+    // (名称, 数值)：累计次数以及最近一秒的捕获/合并次数
+    QList<QPair<QString, qint64>> stats() const;
+
+signals:
+    void captureDue(quint64 generation);
+
+private:
+    // 按秒分桶的计数器，读取时才滚动，空闲时不需要定时器
+    struct RateCounter {
+        qint64 second = -1;
+        qint64 current = 0;
+        qint64 previous = 0;
+        qint64 total = 0;
+        void add(qint64 nowSecond);
+        qint64 perSecond(qint64 nowSecond) const;
+    };
+
+    void fire();
+    qint64 nowSecond() const { return m_clock.elapsed() / 1000; }
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QElapsedTimer m_pendingSince;   // 本轮合并中第一次变化的时间
+    bool m_pending = false;
+    int m_windowMs = 100;
+    int m_maxDelayMs = 1000;
+    std::atomic<quint64> m_generation{0};
+
+    RateCounter m_signals;
+    RateCounter m_captures;
+    RateCounter m_coalesced;
+};
+
+#endif // CAPTURESCHEDULER_H
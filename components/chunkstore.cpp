@@ -0,0 +1,264 @@
+// chunkstore.cpp
+#include "chunkstore.h"
+#include "tracer.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <algorithm>
+#include <array>
+
+namespace {
+
+const int LANES = 4;
+const int WINDOW = 64;   // Gear 哈希每字节左移一位，只受最近 64 字节影响
+
+// 归一化切分：达到平均大小之前用更严格的掩码，之后用更宽松的掩码，块大小集中在平均值附近。
+// 掩码取高位：Gear 哈希的第 k 位只受最近 k+1 字节影响，低位的窗口太短
+const quint64 MASK_STRICT = ~0ULL << (64 - 18);
+const quint64 MASK_LOOSE = ~0ULL << (64 - 14);
+
+const quint64 *gearTable() {
+    // splitmix64，固定种子，切分结果跨版本稳定
+    static const std::array<quint64, 256> table = []() {
+        std::array<quint64, 256> values{};
+        quint64 x = 0;
+        for (auto& value : values) {
+            x += 0x9E3779B97F4A7C15ULL;
+            quint64 z = x;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            value = z ^ (z >> 31);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+struct Candidates {
+    QList<qsizetype> strict;   // 满足严格掩码（必然也满足宽松掩码）
+    QList<qsizetype> loose;
+};
+
+// 计算每个位置的 Gear 哈希，记录满足掩码的位置 p（可在 p 之后切分）。
+// 哈希只取决于最近 64 字节，与从哪里开始计算无关，因此数据可以分成 LANES 段，
+// 每段从前 64 字节预热后独立推进。循环体内几条哈希链互不依赖，交错执行，
+// 不再受逐字节串行依赖的延迟限制
+Candidates scan(const uchar *data, qsizetype size) {
+    const quint64 *gear = gearTable();
+    const qsizetype laneLength = size / LANES;
+
+    quint64 h[LANES];
+    const uchar *lane[LANES];
+    QList<qsizetype> strict[LANES];
+    QList<qsizetype> loose[LANES];
+    for (int k = 0; k < LANES; ++k) {
+        qsizetype start = k * laneLength;
+        lane[k] = data + start;
+        h[k] = 0;
+        for (qsizetype i = qMax<qsizetype>(0, start - WINDOW); i < start; ++i) {
+            h[k] = (h[k] << 1) + gear[data[i]];
+        }
+    }
+
+    auto check = [&](int k, qsizetype pos) {
+        if ((h[k] & MASK_LOOSE) != 0) return;
+        loose[k].append(pos);
+        if ((h[k] & MASK_STRICT) == 0) strict[k].append(pos);
+    };
+
+    for (qsizetype t = 0; t < laneLength; ++t) {
+        h[0] = (h[0] << 1) + gear[lane[0][t]];
+        h[1] = (h[1] << 1) + gear[lane[1][t]];
+        h[2] = (h[2] << 1) + gear[lane[2][t]];
+        h[3] = (h[3] << 1) + gear[lane[3][t]];
+        // 平均每 16K 字节才命中一次，先合并判断，不逐条分支
+        if (((h[0] & MASK_LOOSE) == 0) | ((h[1] & MASK_LOOSE) == 0) |
+            ((h[2] & MASK_LOOSE) == 0) | ((h[3] & MASK_LOOSE) == 0)) {
+            for (int k = 0; k < LANES; ++k) check(k, k * laneLength + t);
+        }
+    }
+    // 不能整除的尾部接在最后一段之后
+    for (qsizetype i = LANES * laneLength; i < size; ++i) {
+        h[LANES - 1] = (h[LANES - 1] << 1) + gear[data[i]];
+        check(LANES - 1, i);
+    }
+
+    Candidates result;
+    for (int k = 0; k < LANES; ++k) {
+        result.strict += strict[k];
+        result.loose += loose[k];
+    }
+    return result;
+}
+
+} // namespace
+
+ChunkStore::ChunkStore(const QString& root)
+    : m_root(root)
+{
+}
+
+void ChunkStore::setRoot(const QString& root) {
+    QMutexLocker locker(&m_mutex);
+    m_root = root;
+}
+
+QString ChunkStore::root() const {
+    QMutexLocker locker(&m_mutex);
+    return m_root;
+}
+
+QString ChunkStore::chunkPath(const QString& id) const {
+    return root() + "/" + id.left(2) + "/" + id;
+}
+
+QList<qsizetype> ChunkStore::boundaries(const char *data, qsizetype size) {
+    QList<qsizetype> ends;
+    if (size <= 0) return ends;
+
+    const Candidates candidates = scan(reinterpret_cast<const uchar*>(data), size);
+    auto firstFrom = [](const QList<qsizetype>& list, qsizetype from) {
+        return std::lower_bound(list.begin(), list.end(), from);
+    };
+
+    qsizetype start = 0;
+    while (start < size) {
+        qsizetype end = qMin(start + MAX_CHUNK, size);
+        if (size - start <= MIN_CHUNK) {
+            end = size;
+        } else {
+            // 在 p 之后切分时块长为 p + 1 - start
+            const qsizetype normal = qMin(start + AVG_CHUNK, size);
+            auto strict = firstFrom(candidates.strict, start + MIN_CHUNK - 1);
+            if (strict != candidates.strict.end() && *strict + 1 < normal) {
+                end = *strict + 1;
+            } else {
+                auto loose = firstFrom(candidates.loose, normal - 1);
+                if (loose != candidates.loose.end() && *loose + 1 <= end) end = *loose + 1;
+            }
+        }
+        ends.append(end);
+        start = end;
+    }
+    return ends;
+}
+
+QStringList ChunkStore::store(const QByteArray& payload, QString *error) {
+    TRACE_SCOPE("chunkStore.store");
+    qint64 cutStart = Tracer::nowNs();
+    const QList<qsizetype> ends = boundaries(payload.constData(), payload.size());
+    qint64 cutNs = Tracer::nowNs() - cutStart;
+
+    QStringList ids;
+    ids.reserve(ends.size());
+    qint64 written = 0;
+    int created = 0;
+    qsizetype start = 0;
+    for (qsizetype end : ends) {
+        QByteArray chunk = QByteArray::fromRawData(payload.constData() + start, end - start);
+        QString id = QString::fromLatin1(QCryptographicHash::hash(chunk, QCryptographicHash::Sha256).toHex());
+        QString path = chunkPath(id);
+
+        // 检查和登记在同一把锁内，remove 不会删掉刚确认存在的块
+        QMutexLocker locker(&m_mutex);
+        if (!QFile::exists(path)) {
+            QDir().mkpath(QFileInfo(path).path());
+            QSaveFile file(path);
+            if (!file.open(QIODevice::WriteOnly) || file.write(chunk) != chunk.size() || !file.commit()) {
+                if (error) *error = "无法写入数据块: " + file.errorString();
+                locker.unlock();
+                release(ids);
+                return QStringList();
+            }
+            written += chunk.size();
+            created++;
+        }
+        m_held[id]++;
+        ids.append(id);
+        start = end;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_logicalBytes += payload.size();
+    m_writtenBytes += written;
+    m_chunks += ids.size();
+    m_newChunks += created;
+    m_cutBytes += payload.size();
+    m_cutNs += cutNs;
+    return ids;
+}
+
+void ChunkStore::release(const QStringList& ids) {
+    QMutexLocker locker(&m_mutex);
+    for (const auto& id : ids) {
+        auto it = m_held.find(id);
+        if (it != m_held.end() && --it.value() <= 0) m_held.erase(it);
+    }
+}
+
+QByteArray ChunkStore::load(const QStringList& ids, bool *ok) const {
+    TRACE_SCOPE("chunkStore.load");
+    QByteArray result;
+    result.reserve(ids.size() * AVG_CHUNK);
+    for (const auto& id : ids) {
+        QFile file(chunkPath(id));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qDebug() << "数据块缺失:" << id;
+            if (ok) *ok = false;
+            return QByteArray();
+        }
+        result.append(file.readAll());
+    }
+    if (ok) *ok = true;
+    return result;
+}
+
+bool ChunkStore::stream(const QStringList& ids, const std::function<bool(const QByteArray&)>& sink) const {
+    for (const auto& id : ids) {
+        QFile file(chunkPath(id));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qDebug() << "数据块缺失:" << id;
+            return false;
+        }
+        if (!sink(file.readAll())) return false;
+    }
+    return true;
+}
+
+bool ChunkStore::contains(const QString& id) const {
+    return QFile::exists(chunkPath(id));
+}
+
+bool ChunkStore::import(const ChunkStore& source, const QStringList& ids) {
+    for (const auto& id : ids) {
+        QString path = chunkPath(id);
+        if (QFile::exists(path)) continue;
+        QDir().mkpath(QFileInfo(path).path());
+        if (!QFile::copy(source.chunkPath(id), path)) return false;
+    }
+    return true;
+}
+
+void ChunkStore::remove(const QSet<QString>& ids) {
+    QMutexLocker locker(&m_mutex);
+    for (const auto& id : ids) {
+        if (m_held.contains(id)) continue;
+        QFile::remove(m_root + "/" + id.left(2) + "/" + id);
+    }
+}
+
+QList<QPair<QString, qint64>> ChunkStore::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return {
+        {"logicalBytes", m_logicalBytes},
+        {"storedBytes", m_writtenBytes},
+        {"chunks", m_chunks},
+        {"newChunks", m_newChunks},
+        {"dedupePercent", m_logicalBytes > 0 ? (m_logicalBytes - m_writtenBytes) * 100 / m_logicalBytes : 0},
+        {"cutMBps", m_cutNs > 0 ? m_cutBytes * 1000 / m_cutNs : 0},
+    };
+}
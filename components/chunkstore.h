@@ -0,0 +1,63 @@
+// chunkstore.h
+#ifndef CHUNKSTORE_H
+#define CHUNKSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+// 内容定义分块存储：载荷按 FastCDC（Gear 滚动哈希 + 归一化切分）切成变长块，
+// 每块按 SHA-256 存为 chunks/<前两位>/<哈希> 一个文件。同一文件的相邻版本
+// 只有改动附近的块不同，其余块只存一份。线程安全，可在工作线程中写入。
+class ChunkStore {
+public:
+    static const qsizetype MIN_CHUNK = 16 * 1024;
+    static const qsizetype AVG_CHUNK = 64 * 1024;
+    static const qsizetype MAX_CHUNK = 256 * 1024;
+
+    explicit ChunkStore(const QString& root = QString());
+
+    void setRoot(const QString& root);
+    QString root() const;
+
+    // 切分点：每块的结束偏移（最后一个等于 size）
+    static QList<qsizetype> boundaries(const char *data, qsizetype size);
+
+    // 切分并写入缺失的块，返回按顺序排列的块 id，失败时返回空列表。
+    // 返回的块在 release 之前不会被 remove 删除（引用它的条目可能尚未登记）
+    QStringList store(const QByteArray& payload, QString *error = nullptr);
+    void release(const QStringList& ids);
+
+    QByteArray load(const QStringList& ids, bool *ok = nullptr) const;
+    // 逐块读取交给 sink，内存中只有一个块；块缺失或 sink 返回 false 时停止并返回 false
+    bool stream(const QStringList& ids, const std::function<bool(const QByteArray&)>& sink) const;
+    bool contains(const QString& id) const;
+    // 从另一个存储复制缺失的块（导出/恢复）
+    bool import(const ChunkStore& source, const QStringList& ids);
+    // 删除不再被引用的块，调用方负责确认引用关系
+    void remove(const QSet<QString>& ids);
+
+    // 本进程内的累计统计：逻辑字节、实际写入字节、去重率、切分吞吐
+    QList<QPair<QString, qint64>> stats() const;
+
+private:
+    QString chunkPath(const QString& id) const;
+
+    mutable QMutex m_mutex;
+    QString m_root;
+    QHash<QString, int> m_held;
+    qint64 m_logicalBytes = 0;
+    qint64 m_writtenBytes = 0;
+    qint64 m_chunks = 0;
+    qint64 m_newChunks = 0;
+    qint64 m_cutBytes = 0;
+    qint64 m_cutNs = 0;
+};
+
+#endif // CHUNKSTORE_H
@@ -0,0 +1,739 @@
+// clipboardhistory.cpp
+#include "clipboardhistory.h"
+#include "tracer.h"
+#include "memoryaccountant.h"
+#include "storedmimedata.h"
+#include <QGuiApplication>
+#include <QMimeData>
+#include <QImage>
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QScopeGuard>
+#include <QSettings>
+#include <algorithm>
+
+ClipboardHistory::ClipboardHistory(QObject *parent)
+    : HistorySource(parent)
+    , m_storage(new StorageManager(this))
+    , m_scheduler(new CaptureScheduler(this))
+    , m_extractor(new MimeExtractor(QClipboard::Clipboard, this))
+{
+    m_storage->setStorageLimit(m_maxItems);
+    // 单个工作线程：捕获结果天然按顺序完成
+    m_workers.setMaxThreadCount(1);
+    connectChannel(m_scheduler, m_extractor);
+
+    QSettings settings;
+    m_selectionEnabled = settings.value("capture/selection", false).toBool();
+    // 超过此长度（字符数）的文本按内容分块存储，相邻版本共用相同的块；0 为关闭
+    m_storage->setChunkThreshold(settings.value("storage/chunkThresholdChars", 64 * 1024).toLongLong());
+    // 大图按像素块去重存放，连续的相似截图共用未变化的块
+    m_storage->setTileImages(settings.value("storage/tileImages", true).toBool());
+
+    // 保留策略：超限条目先挑出，再由定时的批量清理统一移除
+    m_retention.setPolicy(RetentionIndex::Policy::fromSettings());
+    m_retentionTimer = new QTimer(this);
+    m_retentionTimer->setSingleShot(true);
+    m_retentionTimer->setInterval(RETENTION_BATCH_DELAY_MS);
+    connect(m_retentionTimer, &QTimer::timeout, this, &ClipboardHistory::runRetentionPass);
+
+    qint64 maxAgeSecs = m_retention.policy().maxAgeSecs;
+    if (maxAgeSecs > 0) {
+        // 过期检查的间隔取最长保留时间的 1/4，限制在 1 分钟到 1 小时之间
+        auto *ageTimer = new QTimer(this);
+        ageTimer->setInterval(static_cast<int>(qBound<qint64>(60, maxAgeSecs / 4, 3600) * 1000));
+        connect(ageTimer, &QTimer::timeout, this, [this]() {
+            if (!m_loaded) return;
+            queueRemoval(m_retention.collectExpired(QDateTime::currentDateTime()));
+        });
+        ageTimer->start();
+    }
+}
+
+ClipboardHistory::~ClipboardHistory() {
+    m_workers.clear();
+    m_workers.waitForDone();
+    if (m_autoSaveTimer && m_autoSaveTimer->isActive()) {
+        save();
+    }
+    accountText(-m_textBytes);
+    for (const auto& png : std::as_const(m_pinnedPayloads)) {
+        MemoryAccountant::instance()->release(MemoryAccountant::Pinned, png.size());
+    }
+}
+
+void ClipboardHistory::accountText(qint64 delta) {
+    m_textBytes += delta;
+    MemoryAccountant::instance()->charge(MemoryAccountant::TextPayload, delta);
+}
+
+void ClipboardHistory::connectChannel(CaptureScheduler *scheduler, MimeExtractor *extractor) {
+    connect(scheduler, &CaptureScheduler::captureDue, this, [this, extractor](quint64 generation) {
+        TRACE_SCOPE("clipboardChanged");
+        ensureLoaded();
+        // 分阶段读取剪贴板内容，结果通过 textReady / imageReady 返回
+        extractor->start(generation);
+    });
+    connect(extractor, &MimeExtractor::textReady, this, [this, scheduler](quint64 generation, const QString& text) {
+        addCapturedText(scheduler, generation, text);
+    });
+    connect(extractor, &MimeExtractor::imageReady, this, [this, scheduler](quint64 generation, const QImage& image) {
+        addCapturedImage(scheduler, generation, image);
+    });
+    connect(extractor, &MimeExtractor::skipped, this, [](quint64, const QString& reason) {
+        qDebug() << "跳过剪贴板内容:" << reason;
+    });
+}
+
+void ClipboardHistory::startMonitoring() {
+    if (m_clipboard) return;
+    m_clipboard = QGuiApplication::clipboard();
+    connect(m_clipboard, &QClipboard::dataChanged, this, &ClipboardHistory::onClipboardChanged);
+    setSelectionCapture(m_selectionEnabled);
+}
+
+void ClipboardHistory::setSelectionCapture(bool enable) {
+    m_selectionEnabled = enable;
+    if (!m_clipboard) return;  // startMonitoring 时再连接
+
+    if (!enable) {
+        disconnect(m_clipboard, &QClipboard::selectionChanged, this, &ClipboardHistory::onSelectionChanged);
+        if (m_selectionExtractor) m_selectionExtractor->cancel();
+        return;
+    }
+    if (!m_clipboard->supportsSelection()) {
+        qDebug() << "当前平台不支持 PRIMARY 选区";
+        return;
+    }
+
+    if (!m_selectionScheduler) {
+        // 拖动选择时选区每秒变化几十次：用更长的合并窗口，直到选区稳定后才读取；
+        // 只读取文本，并限制大小和最短长度
+        QSettings settings;
+        m_selectionScheduler = new CaptureScheduler(this);
+        m_selectionScheduler->setWindow(settings.value("capture/selectionCoalesceMs", 500).toInt());
+        m_selectionScheduler->setMaxDelay(settings.value("capture/selectionMaxDelayMs", 5000).toInt());
+        m_selectionExtractor = new MimeExtractor(QClipboard::Selection, this);
+        m_selectionExtractor->setImagesEnabled(false);
+        m_selectionExtractor->setMaxTextBytes(settings.value("capture/selectionMaxTextKB", 256).toLongLong() * 1024);
+        m_selectionMinChars = settings.value("capture/selectionMinChars", 3).toInt();
+        connectChannel(m_selectionScheduler, m_selectionExtractor);
+    }
+    connect(m_clipboard, &QClipboard::selectionChanged, this, &ClipboardHistory::onSelectionChanged,
+            Qt::UniqueConnection);
+}
+
+void ClipboardHistory::onSelectionChanged() {
+    m_selectionExtractor->cancel();
+    m_selectionScheduler->notifyChanged();
+}
+
+void ClipboardHistory::setAutoSave(bool enable, int delayMs) {
+    if (!enable) {
+        delete m_autoSaveTimer;
+        m_autoSaveTimer = nullptr;
+        return;
+    }
+    if (!m_autoSaveTimer) {
+        m_autoSaveTimer = new QTimer(this);
+        m_autoSaveTimer->setSingleShot(true);
+        connect(m_autoSaveTimer, &QTimer::timeout, this, [this]() { save(); });
+    }
+    m_autoSaveTimer->setInterval(delayMs);
+}
+
+void ClipboardHistory::setMaxItems(int maxItems) {
+    m_maxItems = maxItems;
+    m_storage->setStorageLimit(maxItems);
+}
+
+void ClipboardHistory::ensureLoaded() {
+    if (m_loaded) return;
+    m_loaded = true;
+
+    // 只解析索引，图片保持磁盘句柄，显示时再解码
+    int total = m_storage->loadIndex();
+    QList<Entry> stored = m_storage->loadPage(0, total, false);
+
+    // 旧版本文件没有 id，按时间顺序补齐（越新越大）
+    bool hasIds = std::all_of(stored.cbegin(), stored.cend(),
+                              [](const Entry& entry) { return entry.id != 0; });
+    quint64 maxId = 0;
+    for (int i = 0; i < stored.size(); ++i) {
+        if (!hasIds) stored[i].id = stored.size() - i;
+        maxId = qMax(maxId, stored[i].id);
+    }
+
+    qint64 textBytes = 0;
+    for (auto& entry : stored) {
+        textBytes += entry.text.size() * sizeof(QChar);
+        // 旧记录没有载荷大小，补算一次，下次保存后写入记录
+        if (entry.bytes == 0) entry.bytes = entryBytes(entry);
+    }
+    accountText(textBytes);
+
+    m_entries = std::move(stored);
+    m_storedIds = hasIds;
+    // 已删除的 id 不再分配，否则新条目会被尚未清理的删除记录遮住
+    m_nextId = qMax(maxId, m_storage->maxRemovedId()) + 1;
+    rebuildColumns();
+
+    for (const auto& entry : m_entries) {
+        if (entry.pinned) {
+            preparePinned(entry);
+        } else {
+            trackRetention(entry);
+        }
+    }
+    queueRemoval(m_retention.collectExpired(QDateTime::currentDateTime()));
+    queueRemoval(m_retention.collectOverLimit());
+}
+
+qint64 ClipboardHistory::entryBytes(const Entry& entry) const {
+    if (entry.bytes > 0) return entry.bytes;
+    if (entry.isChunked()) return entry.textLength * sizeof(QChar);
+    if (entry.type == Entry::Text) return entry.text.size() * sizeof(QChar);
+    return m_storage->imageBytes(entry.hash);
+}
+
+void ClipboardHistory::trackRetention(const Entry& entry) {
+    if (m_retention.policy().isEmpty()) return;
+    m_retention.insert(entry.id, entry.type, entryBytes(entry), entry.timestamp);
+}
+
+void ClipboardHistory::rebuildColumns() {
+    m_columns.clear();
+    m_columns.reserve(m_entries.size());
+    for (auto it = m_entries.crbegin(); it != m_entries.crend(); ++it) appendColumn(*it);
+}
+
+void ClipboardHistory::appendColumn(const Entry& entry) {
+    quint8 flags = (entry.pinned ? EntryColumns::Pinned : 0) | (entry.isChunked() ? EntryColumns::Chunked : 0);
+    m_columns.append(entry.id, entry.type, entry.timestamp.toMSecsSinceEpoch(), entryBytes(entry), flags);
+}
+
+void ClipboardHistory::updateColumnFlags(const Entry& entry) {
+    qsizetype row = m_columns.lowerBound(entry.id);
+    if (row >= m_columns.size() || m_columns.id(row) != entry.id) return;
+    m_columns.setFlags(row, (entry.pinned ? EntryColumns::Pinned : 0) |
+                                (entry.isChunked() ? EntryColumns::Chunked : 0));
+}
+
+void ClipboardHistory::queueRemoval(const QList<quint64>& ids) {
+    if (ids.isEmpty()) return;
+    for (quint64 id : ids) m_pendingRemoval.insert(id);
+    if (!m_retentionTimer->isActive()) m_retentionTimer->start();
+}
+
+void ClipboardHistory::runRetentionPass() {
+    TRACE_SCOPE("retention.pass");
+    if (m_pendingRemoval.isEmpty()) return;
+    const QSet<quint64> pending = std::exchange(m_pendingRemoval, {});
+    QList<quint64> removed = removeIds(pending, false);
+    if (!removed.isEmpty()) qDebug() << "保留策略移除" << removed.size() << "条历史记录";
+}
+
+QList<quint64> ClipboardHistory::removeIds(const QSet<quint64>& ids, bool includePinned, bool tombstone) {
+    TRACE_SCOPE("history.remove");
+    QList<quint64> removed;
+    qint64 textBytes = 0;
+    auto take = [&](Entry& entry) {
+        removed.append(entry.id);
+        textBytes += entry.text.size() * sizeof(QChar);
+        if (entry.type == Entry::Image) m_pendingBlobs.insert(entry.hash);
+        for (const auto& id : std::as_const(entry.chunks)) m_pendingChunks.insert(id);
+        m_retention.remove(entry.id);
+        releasePinned(entry.id);
+        m_pendingRemoval.remove(entry.id);
+    };
+
+    if (ids.size() * 8 < m_entries.size()) {
+        // 少量删除：m_entries 按 id 降序、列按升序，二分定位并标记，
+        // 再各自从最小位置起压缩一次，不重建列
+        QList<qsizetype> positions;
+        positions.reserve(ids.size());
+        for (quint64 id : ids) {
+            auto it = std::lower_bound(m_entries.begin(), m_entries.end(), id,
+                                       [](const Entry& entry, quint64 target) { return entry.id > target; });
+            if (it == m_entries.end() || it->id != id || (it->pinned && !includePinned)) continue;
+            take(*it);
+            positions.append(it - m_entries.begin());
+        }
+        if (!positions.isEmpty()) {
+            // ids 来自集合，位置不会重复；仍去重，压缩游标依赖严格递增
+            std::sort(positions.begin(), positions.end());
+            positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+            const qsizetype last = m_entries.size() - 1;
+            QList<qsizetype> rows;
+            rows.reserve(positions.size());
+            for (auto it = positions.crbegin(); it != positions.crend(); ++it) rows.append(last - *it);
+
+            qsizetype kept = positions.first();
+            qsizetype next = 0;
+            for (qsizetype i = positions.first(); i < m_entries.size(); ++i) {
+                if (next < positions.size() && positions.at(next) == i) {
+                    ++next;
+                    continue;
+                }
+                m_entries[kept++] = std::move(m_entries[i]);
+            }
+            m_entries.resize(kept);
+            m_columns.removeRows(rows);
+        }
+    } else {
+        // 大批量删除：一次遍历压缩，再重建列
+        auto kept = m_entries.begin();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (ids.contains(it->id) && (includePinned || !it->pinned)) {
+                take(*it);
+            } else {
+                if (kept != it) *kept = std::move(*it);
+                ++kept;
+            }
+        }
+        if (kept != m_entries.end()) {
+            m_entries.erase(kept, m_entries.end());
+            rebuildColumns();
+        }
+    }
+    if (removed.isEmpty()) return removed;
+
+    accountText(-textBytes);
+    // 磁盘上只追加删除记录，历史文件留到下次完整保存时再重写
+    if (tombstone && (!m_storedIds || !m_storage->appendTombstones(removed))) scheduleAutoSave();
+    emit entriesRemoved(removed);
+    return removed;
+}
+
+void ClipboardHistory::removeEntries(const QList<quint64>& ids) {
+    ensureLoaded();
+    QList<quint64> removed = removeIds(QSet<quint64>(ids.cbegin(), ids.cend()), true);
+    qDebug() << "删除" << removed.size() << "条历史记录";
+}
+
+void ClipboardHistory::removeMatching(const QString& query, const EntryColumns::Query& filter) {
+    // 批量删除只作用于普通历史，置顶条目需要单独选中删除
+    EntryColumns::Query unpinned = filter;
+    unpinned.excludeFlags |= EntryColumns::Pinned;
+    const QList<Entry> matched = search(query, unpinned, 0, std::numeric_limits<int>::max());
+    QSet<quint64> ids;
+    ids.reserve(matched.size());
+    for (const auto& entry : matched) ids.insert(entry.id);
+    QList<quint64> removed = removeIds(ids, false);
+    qDebug() << "按条件删除" << removed.size() << "条历史记录";
+}
+
+void ClipboardHistory::deleteUnreferencedBlobs() {
+    // 索引写入成功后才删除图片文件，异常退出时不会留下指向缺失文件的记录
+    if (m_pendingBlobs.isEmpty() && m_pendingChunks.isEmpty()) return;
+    QSet<QString> liveImages;
+    // 剪贴板仍持有的图片留到下一次回收
+    QSet<QString> deferred;
+    if (m_clipboardOwner) {
+        liveImages.insert(m_clipboardHash);
+        if (m_pendingBlobs.remove(m_clipboardHash)) deferred.insert(m_clipboardHash);
+    }
+    for (const auto& entry : std::as_const(m_entries)) {
+        if (entry.type == Entry::Image) {
+            m_pendingBlobs.remove(entry.hash);
+            liveImages.insert(entry.hash);
+        }
+        // 块可能被多个版本共用，仍有条目引用的保留
+        for (const auto& id : entry.chunks) m_pendingChunks.remove(id);
+    }
+    if (!m_pendingBlobs.isEmpty()) m_storage->removeImages(m_pendingBlobs, liveImages);
+    m_pendingBlobs = std::move(deferred);
+    m_storage->removeChunks(m_pendingChunks);
+    m_pendingChunks.clear();
+}
+
+void ClipboardHistory::preparePinned(const Entry& entry) {
+    // 置顶图片的 PNG 常驻内存，复制时无需读盘；分块图片要重建并编码，放到工作线程
+    if (entry.type != Entry::Image || m_pinnedPayloads.contains(entry.id)) return;
+    m_workers.start([this, id = entry.id, hash = entry.hash]() {
+        QByteArray png = m_storage->loadImageData(hash);
+        QMetaObject::invokeMethod(this, [this, id, png]() {
+            // 完成前可能已取消置顶或被删除
+            const Entry *entry = findEntry(id);
+            if (png.isEmpty() || !entry || !entry->pinned || m_pinnedPayloads.contains(id)) return;
+            MemoryAccountant::instance()->charge(MemoryAccountant::Pinned, png.size());
+            m_pinnedPayloads.insert(id, png);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ClipboardHistory::releasePinned(quint64 id) {
+    auto it = m_pinnedPayloads.find(id);
+    if (it == m_pinnedPayloads.end()) return;
+    MemoryAccountant::instance()->release(MemoryAccountant::Pinned, it->size());
+    m_pinnedPayloads.erase(it);
+}
+
+QList<ClipboardHistory::Entry> ClipboardHistory::pinnedEntries() {
+    ensureLoaded();
+    QList<Entry> result;
+    for (const auto& entry : m_entries) {
+        if (entry.pinned) result.append(entry);
+    }
+    return result;
+}
+
+void ClipboardHistory::requestPinned() {
+    emit pinnedLoaded(pinnedEntries());
+}
+
+void ClipboardHistory::setPinned(quint64 id, bool pinned) {
+    ensureLoaded();
+    for (auto& entry : m_entries) {
+        if (entry.id != id) continue;
+        if (entry.pinned == pinned) return;
+        entry.pinned = pinned;
+        updateColumnFlags(entry);
+        if (pinned) {
+            preparePinned(entry);
+            m_retention.remove(id);
+        } else {
+            releasePinned(id);
+            trackRetention(entry);
+            queueRemoval(m_retention.collectOverLimit());
+        }
+        emit entryPinned(entry);
+        scheduleAutoSave();
+        return;
+    }
+}
+
+QList<ClipboardHistory::Entry> ClipboardHistory::page(quint64 beforeId, int count, bool *finished) {
+    ensureLoaded();
+
+    QList<Entry> result;
+    int i = 0;
+    if (beforeId != 0) {
+        while (i < m_entries.size() && m_entries.at(i).id >= beforeId) ++i;
+    }
+    for (; i < m_entries.size() && result.size() < count; ++i) {
+        result.append(m_entries.at(i));
+    }
+    if (finished) *finished = (i >= m_entries.size());
+    return result;
+}
+
+QList<ClipboardHistory::Entry> ClipboardHistory::search(const QString& query, const EntryColumns::Query& filter,
+                                                       quint64 beforeId, int limit, bool *finished) {
+    ensureLoaded();
+
+    // 元数据条件先在列上筛出候选行（只看 id 小于 beforeId 的部分），再从新到旧逐条匹配文本
+    const qsizetype last = m_entries.size() - 1;
+    const QList<qsizetype> rows = m_columns.select(filter, 0, beforeId != 0 ? m_columns.lowerBound(beforeId) : -1);
+    QList<Entry> result;
+    qsizetype k = rows.size() - 1;
+    for (; k >= 0 && result.size() < limit; --k) {
+        const Entry& entry = m_entries.at(last - rows.at(k));
+        if (!query.isEmpty()) {
+            if (!entry.matchesQuery(query)) continue;
+        }
+        result.append(entry);
+    }
+    if (finished) *finished = (k < 0);
+    return result;
+}
+
+void ClipboardHistory::requestPage(quint64 beforeId, int count) {
+    bool finished = false;
+    QList<Entry> result = page(beforeId, count, &finished);
+    emit pageLoaded(result, finished);
+}
+
+const QList<ClipboardHistory::Entry>& ClipboardHistory::entries() {
+    ensureLoaded();
+    return m_entries;
+}
+
+const ClipboardHistory::Entry* ClipboardHistory::findEntry(quint64 id) {
+    ensureLoaded();
+    auto it = std::lower_bound(m_entries.cbegin(), m_entries.cend(), id,
+                               [](const Entry& entry, quint64 target) { return entry.id > target; });
+    return (it != m_entries.cend() && it->id == id) ? &*it : nullptr;
+}
+
+QPixmap ClipboardHistory::loadImage(const Entry& entry) {
+    if (!entry.image.isNull()) return entry.image;
+    return m_storage->loadImage(entry.hash);
+}
+
+QString ClipboardHistory::imagePath(const Entry& entry) const {
+    return m_storage->imagePath(entry.hash);
+}
+
+bool ClipboardHistory::forEachEntry(const std::function<bool(const Entry&)>& callback) {
+    // 内存中就是完整历史，尚未落盘的条目也在其中
+    ensureLoaded();
+    for (const auto& entry : std::as_const(m_entries)) {
+        if (!callback(entry)) return false;
+    }
+    return true;
+}
+
+QString ClipboardHistory::chunksPath() const {
+    return m_storage->getChunksPath();
+}
+
+QString ClipboardHistory::loadText(const Entry& entry) {
+    return m_storage->loadText(entry);
+}
+
+void ClipboardHistory::copyToClipboard(quint64 id) {
+    const Entry* entry = findEntry(id);
+    if (!entry) return;
+
+    QClipboard *clipboard = m_clipboard ? m_clipboard : QGuiApplication::clipboard();
+    if (entry->type == Entry::Image) {
+        // 直接提供存储中的 PNG，粘贴时无需解码再编码；剪贴板接管对象所有权。
+        // 分块存放的图片在首次粘贴时才重建
+        QString path = m_storage->imagePath(entry->hash);
+        QByteArray pinned = m_pinnedPayloads.value(entry->id);
+        if (QFile::exists(path)) {
+            auto *data = new StoredMimeData(path, pinned);
+            clipboard->setMimeData(data);
+            m_clipboardOwner = data;
+            m_clipboardHash = entry->hash;
+        } else {
+            clipboard->setPixmap(loadImage(*entry));
+        }
+    } else {
+        clipboard->setText(m_storage->loadText(*entry));
+    }
+}
+
+void ClipboardHistory::clear() {
+    // 清空只作用于普通历史，置顶条目保留
+    ensureLoaded();
+    QList<Entry> pinned;
+    qint64 pinnedTextBytes = 0;
+    for (const auto& entry : m_entries) {
+        if (!entry.pinned) {
+            if (entry.type == Entry::Image) m_pendingBlobs.insert(entry.hash);
+            for (const auto& id : entry.chunks) m_pendingChunks.insert(id);
+            continue;
+        }
+        pinned.append(entry);
+        pinnedTextBytes += entry.text.size() * sizeof(QChar);
+    }
+    m_entries = std::move(pinned);
+    rebuildColumns();
+    accountText(pinnedTextBytes - m_textBytes);
+    m_retention.clear();
+    m_pendingRemoval.clear();
+    emit historyCleared();
+    scheduleAutoSave();
+}
+
+bool ClipboardHistory::save() {
+    if (m_autoSaveTimer) m_autoSaveTimer->stop();
+    if (!m_loaded) return true;  // 未加载过，磁盘内容即为最新
+
+    qsizetype unpinned = std::count_if(m_entries.cbegin(), m_entries.cend(),
+                                       [](const Entry& entry) { return !entry.pinned; });
+    if (unpinned > m_maxItems) {
+        emit historyLimitReached();
+        // 与 saveHistory 的裁剪一致：去掉超出上限的最旧普通条目，
+        // 其图片和块随后由 deleteUnreferencedBlobs 回收
+        QSet<quint64> overflow;
+        overflow.reserve(unpinned - m_maxItems);
+        qsizetype kept = 0;
+        for (const auto& entry : std::as_const(m_entries)) {
+            if (entry.pinned) continue;
+            if (++kept > m_maxItems) overflow.insert(entry.id);
+        }
+        removeIds(overflow, false, false);
+    }
+
+    // 旧记录中的大文本在保存时迁移到分块存储，内存中也只留预览
+    for (auto& entry : m_entries) {
+        if (!m_storage->shouldChunk(entry)) continue;
+        qint64 before = entry.text.size();
+        if (m_storage->chunkText(entry)) {
+            m_storage->releaseChunks(entry.chunks);
+            updateColumnFlags(entry);
+            accountText((entry.text.size() - before) * sizeof(QChar));
+        }
+    }
+
+    if (!m_storage->saveHistory(m_entries)) {
+        m_lastError = m_storage->getLastError();
+        qDebug() << "保存历史记录失败:" << m_lastError;
+        return false;
+    }
+    deleteUnreferencedBlobs();
+    return true;
+}
+
+void ClipboardHistory::scheduleAutoSave() {
+    if (m_autoSaveTimer) m_autoSaveTimer->start();
+}
+
+void ClipboardHistory::addEntry(Entry entry) {
+    ensureLoaded();
+    entry.id = m_nextId++;
+    entry.timestamp = QDateTime::currentDateTime();
+    entry.bytes = entryBytes(entry);
+
+    // 内存中只保留磁盘句柄，通知时附带图片，界面无需再读磁盘
+    Entry stored = entry;
+    stored.image = QPixmap();
+    m_entries.prepend(stored);
+    appendColumn(stored);
+    accountText(stored.text.size() * sizeof(QChar));
+
+    emit entryAdded(entry);
+    scheduleAutoSave();
+
+    trackRetention(stored);
+    queueRemoval(m_retention.collectOverLimit());
+}
+
+void ClipboardHistory::onClipboardChanged() {
+    // 取消尚未完成的读取；连续变化先合并，只捕获窗口期结束时的最终内容
+    m_extractor->cancel();
+    m_scheduler->notifyChanged();
+}
+
+void ClipboardHistory::addCapturedText(CaptureScheduler *scheduler, quint64 generation, const QString& text) {
+    if (scheduler->isSuperseded(generation)) {
+        scheduler->noteDropped();
+        return;
+    }
+    // 选区中误触产生的极短文本不记录
+    if (scheduler == m_selectionScheduler && text.trimmed().size() < m_selectionMinChars) {
+        return;
+    }
+    if (!m_entries.isEmpty() && m_entries.first().type == Entry::Text &&
+        m_entries.first().text == text) {
+        return;
+    }
+
+    Entry entry;
+    entry.type = Entry::Text;
+    entry.text = text;
+    if (!m_storage->shouldChunk(entry)) {
+        addEntry(std::move(entry));
+        scheduler->noteCaptured();
+        return;
+    }
+
+    // 大文本在工作线程中分块写入，内存中只保留预览
+    m_workers.start([this, scheduler, generation, entry]() mutable {
+        if (scheduler->isSuperseded(generation)) {
+            QMetaObject::invokeMethod(this, [scheduler]() { scheduler->noteDropped(); }, Qt::QueuedConnection);
+            return;
+        }
+        QString error;
+        if (!m_storage->chunkText(entry, &error)) {
+            // 分块失败时仍按普通文本保存
+            qDebug() << "文本分块失败:" << error;
+        }
+        QMetaObject::invokeMethod(this, [this, scheduler, generation, entry]() {
+            finishTextCapture(scheduler, generation, entry);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ClipboardHistory::finishTextCapture(CaptureScheduler *scheduler, quint64 generation, const Entry& entry) {
+    // 条目登记（或丢弃）之后才释放块，期间的清理不会删掉它们
+    auto releaseChunks = qScopeGuard([this, &entry]() { m_storage->releaseChunks(entry.chunks); });
+
+    if (scheduler->isSuperseded(generation)) {
+        scheduler->noteDropped();
+        m_pendingChunks.unite(QSet<QString>(entry.chunks.cbegin(), entry.chunks.cend()));
+        return;
+    }
+    // 与上一条内容相同（块序列一致）
+    if (!m_entries.isEmpty() && m_entries.first().isChunked() &&
+        m_entries.first().chunks == entry.chunks) {
+        return;
+    }
+
+    addEntry(entry);
+    scheduler->noteCaptured();
+}
+
+void ClipboardHistory::addCapturedImage(CaptureScheduler *scheduler, quint64 generation, const QImage& image) {
+    // PNG 编码和哈希放到工作线程，完成时若已有更新的变化则丢弃结果
+    // 析构时会等待工作线程结束，任务中可以直接使用 this
+    m_workers.start([this, scheduler, generation, image]() {
+        if (scheduler->isSuperseded(generation)) {
+            QMetaObject::invokeMethod(this, [scheduler]() { scheduler->noteDropped(); }, Qt::QueuedConnection);
+            return;
+        }
+        // PNG 只编码一次：同时用于计算哈希和写入磁盘
+        QByteArray pngData = encodeImage(image);
+        QString hash = imageHash(pngData);
+        // 大图按像素块写入，与之前的截图相同的块不再重复存放
+        QStringList tiles;
+        if (m_storage->shouldTile(image) && !m_storage->hasImage(hash)) {
+            QString error;
+            tiles = m_storage->tileImage(hash, image, &error);
+            if (tiles.isEmpty()) qDebug() << "图片分块失败:" << error;
+        }
+        QMetaObject::invokeMethod(this, [this, scheduler, generation, image, pngData, hash, tiles]() {
+            finishImageCapture(scheduler, generation, image, pngData, hash, tiles);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ClipboardHistory::finishImageCapture(CaptureScheduler *scheduler, quint64 generation, const QImage& image,
+                                          const QByteArray& pngData, const QString& hash,
+                                          const QStringList& tiles) {
+    // 与分块文本相同：条目登记（或丢弃）之后才释放块
+    auto releaseTiles = qScopeGuard([this, &tiles]() { m_storage->releaseTiles(tiles); });
+
+    if (scheduler->isSuperseded(generation)) {
+        scheduler->noteDropped();
+        // 已写入的块映射若没有其他条目引用，下次保存后删除
+        if (!tiles.isEmpty()) m_pendingBlobs.insert(hash);
+        return;
+    }
+
+    // 检查是否重复
+    if (!m_entries.isEmpty() && m_entries.first().type == Entry::Image &&
+        m_entries.first().hash == hash) {
+        return;
+    }
+
+    if (!m_storage->hasImage(hash) && !m_storage->saveImageData(hash, pngData)) {
+        qDebug() << "保存图片失败:" << m_storage->getLastError();
+        return;
+    }
+
+    Entry entry;
+    entry.type = Entry::Image;
+    entry.image = QPixmap::fromImage(image);
+    entry.hash = hash;
+    addEntry(std::move(entry));
+    scheduler->noteCaptured();
+}
+
+QByteArray ClipboardHistory::encodeImage(const QPixmap& image) {
+    return encodeImage(image.toImage());
+}
+
+QByteArray ClipboardHistory::encodeImage(const QImage& image) {
+    TRACE_SCOPE("encodeImage");
+    QByteArray byteArray;
+    QBuffer buffer(&byteArray);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return byteArray;
+}
+
+QString ClipboardHistory::imageHash(const QByteArray& pngData) {
+    TRACE_SCOPE("getImageHash");
+    return QString(QCryptographicHash::hash(pngData, QCryptographicHash::Md5).toHex());
+}
+
+QString ClipboardHistory::imageHash(const QPixmap& image) {
+    return imageHash(encodeImage(image));
+}
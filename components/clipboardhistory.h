@@ -0,0 +1,130 @@
+// clipboardhistory.h
+#ifndef CLIPBOARDHISTORY_H
+#define CLIPBOARDHISTORY_H
+
+#include "historysource.h"
+#include <QClipboard>
+#include <QTimer>
+#include <QThreadPool>
+#include <QHash>
+#include <QMimeData>
+#include <QPointer>
+#include "capturescheduler.h"
+#include "mimeextractor.h"
+#include "retentionindex.h"
+#include "entrycolumns.h"
+#include <QSet>
+
+// 捕获核心：监听剪贴板、维护历史并负责持久化，不依赖 Widgets
+class ClipboardHistory : public HistorySource {
+    Q_OBJECT
+public:
+    explicit ClipboardHistory(QObject *parent = nullptr);
+    ~ClipboardHistory() override;
+
+    void startMonitoring();
+
+    void requestPage(quint64 beforeId, int count) override;
+    void copyToClipboard(quint64 id) override;
+    void clear() override;
+    bool save() override;
+    QPixmap loadImage(const Entry& entry) override;
+    QString imagePath(const Entry& entry) const override;
+    QString loadText(const Entry& entry) override;
+    QString chunksPath() const override;
+    bool forEachEntry(const std::function<bool(const Entry&)>& callback) override;
+    void requestPinned() override;
+    void setPinned(quint64 id, bool pinned) override;
+    void removeEntries(const QList<quint64>& ids) override;
+    void removeMatching(const QString& query, const EntryColumns::Query& filter) override;
+
+    QList<Entry> page(quint64 beforeId, int count, bool *finished = nullptr);
+    // 先按列扫描类型、时间和大小条件，文本再按子串（不区分大小写）匹配；
+    // 分块存放的大文本只匹配内存中的预览，不在每次按键时从磁盘重组
+    QList<Entry> search(const QString& query, const EntryColumns::Query& filter, quint64 beforeId, int limit,
+                        bool *finished = nullptr);
+    const QList<Entry>& entries();
+    QList<Entry> pinnedEntries();
+    // 保留策略（配置项 [retention]）的当前统计
+    QList<QPair<QString, qint64>> retentionStats() const { return m_retention.stats(); }
+    const Entry* findEntry(quint64 id);
+
+    // 有变更后延迟自动保存（守护进程使用）
+    void setAutoSave(bool enable, int delayMs = 2000);
+    void setMaxItems(int maxItems);
+    int maxItems() const { return m_maxItems; }
+
+    StorageManager* storage() const { return m_storage; }
+    // 剪贴板变化的合并窗口与捕获计数
+    CaptureScheduler* scheduler() const { return m_scheduler; }
+    // X11 PRIMARY 选区捕获（配置项 capture/selection），未开启时为 nullptr
+    void setSelectionCapture(bool enable);
+    CaptureScheduler* selectionScheduler() const { return m_selectionEnabled ? m_selectionScheduler : nullptr; }
+    QString getLastError() const { return m_lastError; }
+
+    static QByteArray encodeImage(const QPixmap& image);
+    static QByteArray encodeImage(const QImage& image);
+    static QString imageHash(const QByteArray& pngData);
+    static QString imageHash(const QPixmap& image);
+
+private slots:
+    void onClipboardChanged();
+    void onSelectionChanged();
+
+private:
+    void ensureLoaded();
+    void addEntry(Entry entry);
+    void scheduleAutoSave();
+    void accountText(qint64 delta);
+    void preparePinned(const Entry& entry);
+    void releasePinned(quint64 id);
+    qint64 entryBytes(const Entry& entry) const;
+    void trackRetention(const Entry& entry);
+    void rebuildColumns();
+    void appendColumn(const Entry& entry);
+    void updateColumnFlags(const Entry& entry);
+    void queueRemoval(const QList<quint64>& ids);
+    // tombstone 为 false 时不追加删除记录，由调用方随后完整重写历史文件
+    QList<quint64> removeIds(const QSet<quint64>& ids, bool includePinned, bool tombstone = true);
+    void runRetentionPass();
+    void deleteUnreferencedBlobs();
+    void connectChannel(CaptureScheduler *scheduler, MimeExtractor *extractor);
+    void addCapturedText(CaptureScheduler *scheduler, quint64 generation, const QString& text);
+    void finishTextCapture(CaptureScheduler *scheduler, quint64 generation, const Entry& entry);
+    void addCapturedImage(CaptureScheduler *scheduler, quint64 generation, const QImage& image);
+    void finishImageCapture(CaptureScheduler *scheduler, quint64 generation, const QImage& image,
+                            const QByteArray& pngData, const QString& hash, const QStringList& tiles);
+
+    StorageManager *m_storage;
+    QClipboard *m_clipboard = nullptr;
+    CaptureScheduler *m_scheduler;
+    MimeExtractor *m_extractor;
+    CaptureScheduler *m_selectionScheduler = nullptr;
+    MimeExtractor *m_selectionExtractor = nullptr;
+    bool m_selectionEnabled = false;
+    int m_selectionMinChars = 3;
+    QThreadPool m_workers;    // 图片编码、哈希与分块，大文本分块
+    QList<Entry> m_entries;   // 最新的在前，置顶条目也在其中（带 pinned 标记）
+    EntryColumns m_columns;   // 与 m_entries 一一对应，顺序相反
+    QHash<quint64, QByteArray> m_pinnedPayloads;  // 置顶图片常驻内存的 PNG
+    quint64 m_nextId = 1;
+    bool m_loaded = false;
+    bool m_storedIds = true;  // 旧版本文件没有 id，删除记录无法对应，只能整体重写
+    int m_maxItems = 100;
+    QTimer *m_autoSaveTimer = nullptr;
+    QString m_lastError;
+    qint64 m_textBytes = 0;   // 已计入 MemoryAccountant 的文本字节数
+
+    static const int RETENTION_BATCH_DELAY_MS = 1000;
+    RetentionIndex m_retention;
+    QTimer *m_retentionTimer = nullptr;
+    QSet<quint64> m_pendingRemoval;   // 已挑出、等待批量移除的条目
+    QSet<QString> m_pendingBlobs;     // 下次保存成功后删除的图片（及不再引用的图片块）
+    QSet<QString> m_pendingChunks;    // 同上，已移除的分块文本用到的块（仍被引用的保留）
+    // 剪贴板上的 StoredMimeData 按路径延迟读取，它仍被剪贴板持有时不删除对应图片；
+    // 剪贴板换成其他内容后对象被销毁，指针自动清空
+    QPointer<QMimeData> m_clipboardOwner;
+    QString m_clipboardHash;
+};
+
+#endif // CLIPBOARDHISTORY_H
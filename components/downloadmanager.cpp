@@ -1,65 +1,383 @@
 #include "downloadmanager.h"
+#include "tilestore.h"
+#include "chunkstore.h"
 #include <QFile>
 #include <QDir>
 #include <QFileInfo>
-#include <QTextStream>
 #include <QDateTime>
 #include <QBuffer>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QQueue>
+#include <QPainter>
+#include <QSaveFile>
+#include <QStringEncoder>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <atomic>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
 
 struct DownloadManager::DownloadManagerPrivate {
     QString lastError;
-    std::unique_ptr<QBuffer> imageBuffer;
-    std::unique_ptr<QBuffer> textBuffer;
+
+    // 批量导出
+    QFutureWatcher<bool> exportWatcher;
+    std::atomic<bool> exportCancelled{false};
+    QString exportError;   // 由导出线程写入，finished 之后读取
 };
 
-DownloadManager::DownloadManager(QObject *parent)
-    : QObject(parent)
-    , d(std::make_unique<DownloadManagerPrivate>()) {}
+namespace {
 
-DownloadManager::~DownloadManager() {
-    clearBuffers();
+const int TAR_BLOCK = 512;
+const qint64 STREAM_CHUNK = 64 * 1024;
+const qsizetype TEXT_CHUNK = 64 * 1024;
+
+// gzip 尾部需要 CRC-32（与 zlib 的 adler32 不同）
+quint32 crc32(const QByteArray& data) {
+    static quint32 table[256] = {0};
+    static const bool initialized = []() {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        return true;
+    }();
+    Q_UNUSED(initialized);
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (char byte : data) crc = table[(crc ^ static_cast<uchar>(byte)) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
 }
 
-void DownloadManager::clearBuffers() {
-    if(d->imageBuffer) {
-        d->imageBuffer->close();
-        d->imageBuffer.reset();
+void appendLE32(QByteArray& out, quint32 value) {
+    for (int i = 0; i < 4; ++i) out.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+// 把一段数据压缩为一个独立的 gzip 分段；多个分段直接拼接仍是合法的 gzip 文件，
+// 因此各条目可以在不同线程上并行压缩
+QByteArray gzipMember(const QByteArray& data) {
+    QByteArray zlib = qCompress(data, 6);  // 4 字节长度前缀 + zlib 流
+    QByteArray out;
+    out.reserve(zlib.size() + 18);
+    const char header[10] = {0x1f, static_cast<char>(0x8b), 8, 0, 0, 0, 0, 0, 0, static_cast<char>(0xff)};
+    out.append(header, sizeof(header));
+    // 去掉长度前缀、2 字节 zlib 头和 4 字节 adler32，得到原始 deflate 数据
+    out.append(zlib.constData() + 6, zlib.size() - 10);
+    appendLE32(out, crc32(data));
+    appendLE32(out, static_cast<quint32>(data.size()));
+    return out;
+}
+
+// 把 sourcePath 的内容写入已打开的 dest。优先 reflink（FICLONE，同一 btrfs/xfs 卷上只复制元数据），
+// 其次 copy_file_range（数据在内核中搬运，不经过用户态）；都不支持时用一个固定大小的块流式复制
+bool copyInto(const QString& sourcePath, QFileDevice& dest, QString *error) {
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        *error = "无法读取文件: " + source.errorString();
+        return false;
     }
-    if(d->textBuffer) {
-        d->textBuffer->close();
-        d->textBuffer.reset();
+
+#ifdef Q_OS_LINUX
+    const int in = source.handle();
+    const int out = dest.handle();
+    if (in >= 0 && out >= 0) {
+#ifdef FICLONE
+        if (::ioctl(out, FICLONE, in) == 0) return true;
+#endif
+        qint64 copied = 0;
+        const qint64 size = source.size();
+        while (copied < size) {
+            ssize_t n = ::copy_file_range(in, nullptr, out, nullptr, static_cast<size_t>(size - copied), 0);
+            if (n <= 0) break;
+            copied += n;
+        }
+        if (copied == size) return true;
+        if (copied > 0) {
+            // 中途失败时文件偏移已经前移，不再混用两种方式
+            *error = "复制文件中断: " + sourcePath;
+            return false;
+        }
+        // 不支持（跨文件系统、旧内核等），退回用户态复制
     }
+#endif
+
+    QByteArray block(STREAM_CHUNK, Qt::Uninitialized);
+    while (!source.atEnd()) {
+        qint64 n = source.read(block.data(), block.size());
+        if (n < 0 || dest.write(block.constData(), n) != n) {
+            *error = "复制文件失败: " + (n < 0 ? source.errorString() : dest.errorString());
+            return false;
+        }
+    }
+    return true;
 }
 
-bool DownloadManager::saveText(const QString& text, const QString& filePath) {
-    if (!ensureDirectoryExists(filePath)) {
+QByteArray imageFormatFor(const QString& filePath) {
+    QByteArray suffix = QFileInfo(filePath).suffix().toLower().toLatin1();
+    if (suffix == "jpg") return "jpeg";
+    if (!suffix.isEmpty() && QImageWriter::supportedImageFormats().contains(suffix)) return suffix;
+    return "png";
+}
+
+// 编码 image 写入 dest；JPEG 等不支持透明的格式先铺白底，避免透明区域变黑
+bool writeImage(const QImage& image, const QByteArray& format, QIODevice *dest, QString *error) {
+    QImage output = image;
+    if ((format == "jpeg" || format == "bmp") && image.hasAlphaChannel()) {
+        output = QImage(image.size(), QImage::Format_RGB32);
+        output.fill(Qt::white);
+        QPainter painter(&output);
+        painter.drawImage(0, 0, image);
+    }
+    QImageWriter writer(dest, format);
+    if (!writer.write(output)) {
+        *error = "无法转换图片数据: " + writer.errorString();
         return false;
     }
+    return true;
+}
 
-    clearBuffers();
-    d->textBuffer = std::make_unique<QBuffer>();
+// 在工作线程中执行，成功时返回空字符串
+QString saveImageFile(const QString& sourcePath, const QImage& image, const QString& filePath) {
+    QByteArray format = imageFormatFor(filePath);
+    bool hasSource = !sourcePath.isEmpty() && QFile::exists(sourcePath);
 
-    if (!d->textBuffer->open(QIODevice::WriteOnly)) {
-        d->lastError = "无法初始化缓冲区";
-        return false;
+    QSaveFile file(filePath);
+    file.setDirectWriteFallback(true);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return "无法创建文件: " + file.errorString();
     }
 
-    QTextStream stream(d->textBuffer.get());
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    stream.setCodec("UTF-8");
-#endif
-    stream << text;
-    stream.flush();
+    QString error;
+    bool ok;
+    if (hasSource && QImageReader::imageFormat(sourcePath) == format) {
+        ok = copyInto(sourcePath, file, &error);
+    } else {
+        QImage decoded = image.isNull() && hasSource ? TileStore::readImageFile(sourcePath) : image;
+        if (decoded.isNull()) {
+            error = "无法读取图片: " + sourcePath;
+            ok = false;
+        } else {
+            ok = writeImage(decoded, format, &file, &error);
+        }
+    }
 
-    QFile file(filePath);
+    if (!ok) {
+        file.cancelWriting();
+        return error;
+    }
+    if (!file.commit()) {
+        return "无法保存图片: " + file.errorString();
+    }
+    return QString();
+}
+
+// 在工作线程中执行，成功时返回空字符串
+QString saveTextFile(const QString& text, const QStringList& chunks, const QString& chunkRoot,
+                     const QString& filePath) {
+    QSaveFile file(filePath);
+    file.setDirectWriteFallback(true);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        d->lastError = "无法创建文件: " + file.errorString();
+        return "无法创建文件: " + file.errorString();
+    }
+
+    bool written = false;
+    if (!chunks.isEmpty()) {
+        // 块即 UTF-8 字节，逐块写出
+        written = ChunkStore(chunkRoot).stream(chunks, [&file](const QByteArray& chunk) {
+            return file.write(chunk) == chunk.size();
+        });
+        // 块缺失时从头改写预览
+        if (!written && (!file.seek(0) || !file.resize(0))) {
+            file.cancelWriting();
+            return "写入文件失败: " + file.errorString();
+        }
+    }
+    if (!written) {
+        // 分块编码，编码器跨块保留状态，代理对被切开也能正确处理
+        QStringEncoder encoder(QStringEncoder::Utf8);
+        for (qsizetype pos = 0; pos < text.size(); pos += TEXT_CHUNK) {
+            QByteArray bytes = encoder.encode(QStringView(text).mid(pos, TEXT_CHUNK));
+            if (file.write(bytes) != bytes.size()) {
+                file.cancelWriting();
+                return "写入文件失败: " + file.errorString();
+            }
+        }
+    }
+
+    if (!file.commit()) {
+        return "无法保存文件: " + file.errorString();
+    }
+    return QString();
+}
+
+QByteArray tarHeader(const QString& name, qint64 size, const QDateTime& mtime) {
+    QByteArray header(TAR_BLOCK, '\0');
+    auto put = [&header](int offset, int length, const QByteArray& value) {
+        std::memcpy(header.data() + offset, value.constData(), qMin(length, static_cast<int>(value.size())));
+    };
+    auto octal = [](qint64 value, int digits) {
+        return QByteArray::number(value, 8).rightJustified(digits, '0');
+    };
+
+    put(0, 100, name.toUtf8());
+    put(100, 8, "0000644");
+    put(108, 8, "0000000");
+    put(116, 8, "0000000");
+    put(124, 12, octal(size, 11));
+    put(136, 12, octal(mtime.isValid() ? mtime.toSecsSinceEpoch() : 0, 11));
+    std::memset(header.data() + 148, ' ', 8);  // 计算校验和时按空格计
+    header[156] = '0';
+    put(257, 6, "ustar");
+    put(263, 2, "00");
+
+    quint32 sum = 0;
+    for (char byte : header) sum += static_cast<uchar>(byte);
+    put(148, 6, octal(sum, 6));
+    header[154] = '\0';
+    header[155] = ' ';
+    return header;
+}
+
+QByteArray tarPadding(qint64 size) {
+    qint64 remainder = size % TAR_BLOCK;
+    return remainder ? QByteArray(TAR_BLOCK - remainder, '\0') : QByteArray();
+}
+
+QString exportFileName(const DownloadManager::ExportItem& item) {
+    return QString("%1-%2").arg(item.id, 6, 10, QChar('0'))
+        .arg(item.isImage ? "image.png" : "text.txt");
+}
+
+struct EncodedEntry {
+    QByteArray data;        // 归档模式下的 tar 成员（可能已压缩）
+    QJsonObject manifest;
+    QString error;
+};
+
+// 在工作线程中执行：读取/编码载荷，目录模式直接写文件，归档模式生成 tar 成员
+EncodedEntry encodeEntry(const DownloadManager::ExportItem& item, const QString& target,
+                         DownloadManager::ExportFormat format) {
+    using Format = DownloadManager::ExportFormat;
+    EncodedEntry result;
+    QString name = exportFileName(item);
+
+    QByteArray payload;
+    bool copied = false;
+    // 分块存放的图片没有现成的 PNG，在导出线程中重建后编码
+    bool stored = item.isImage && !item.imagePath.isEmpty() && !TileStore::isMapPath(item.imagePath);
+    if (stored && format == Format::Directory) {
+        // 目录模式下已编码的 PNG 直接复制文件
+        QSaveFile dest(target + "/" + name);
+        copied = dest.open(QIODevice::WriteOnly) && copyInto(item.imagePath, dest, &result.error) && dest.commit();
+        if (!copied) {
+            if (result.error.isEmpty()) result.error = "无法复制图片: " + item.imagePath;
+            return result;
+        }
+    } else if (stored) {
+        QFile file(item.imagePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            result.error = "无法读取图片: " + item.imagePath;
+            return result;
+        }
+        payload = file.readAll();
+    } else if (item.isImage) {
+        QImage image = item.imagePath.isEmpty() ? item.image : TileStore::readImageFile(item.imagePath);
+        QBuffer buffer(&payload);
+        buffer.open(QIODevice::WriteOnly);
+        if (!image.save(&buffer, "PNG")) {
+            result.error = "无法转换图片数据";
+            return result;
+        }
+    } else if (!item.chunks.isEmpty()) {
+        // 分块文本在导出线程中读取，块缺失时退回预览
+        bool ok = false;
+        payload = ChunkStore(item.chunkRoot).load(item.chunks, &ok);
+        if (!ok) payload = item.text.toUtf8();
+    } else {
+        payload = item.text.toUtf8();
+    }
+
+    result.manifest["id"] = static_cast<qint64>(item.id);
+    result.manifest["type"] = item.isImage ? "image" : "text";
+    result.manifest["timestamp"] = item.timestamp.toString(Qt::ISODate);
+    result.manifest["file"] = name;
+    result.manifest["bytes"] = copied ? QFileInfo(target + "/" + name).size() : payload.size();
+
+    if (format == Format::Directory) {
+        if (!copied) {
+            QFile file(target + "/" + name);
+            if (!file.open(QIODevice::WriteOnly) || file.write(payload) != payload.size()) {
+                result.error = "无法写入文件: " + file.errorString();
+            }
+        }
+        return result;
+    }
+
+    QByteArray record = tarHeader(name, payload.size(), item.timestamp);
+    record += payload;
+    record += tarPadding(payload.size());
+    result.data = (format == Format::TarGz) ? gzipMember(record) : record;
+    return result;
+}
+
+} // namespace
+
+DownloadManager::DownloadManager(QObject *parent)
+    : QObject(parent)
+    , d(std::make_unique<DownloadManagerPrivate>())
+{
+    connect(&d->exportWatcher, &QFutureWatcher<bool>::finished, this, [this]() {
+        bool ok = d->exportWatcher.result();
+        if (!ok) d->lastError = d->exportError;
+        emit exportFinished(ok, d->exportError);
+    });
+}
+
+DownloadManager::~DownloadManager() {
+    cancelExport();
+    d->exportWatcher.waitForFinished();
+}
+
+bool DownloadManager::saveText(const QString& text, const QString& filePath) {
+    if (!ensureDirectoryExists(filePath)) {
+        return false;
+    }
+    QString error = saveTextFile(text, QStringList(), QString(), filePath);
+    if (!error.isEmpty()) {
+        d->lastError = error;
+        return false;
+    }
+    return true;
+}
+
+bool DownloadManager::startTextSave(const QString& text, const QStringList& chunks, const QString& chunkRoot,
+                                    const QString& filePath) {
+    if (!ensureDirectoryExists(filePath)) {
         return false;
     }
 
-    file.write(d->textBuffer->data());
-    file.close();
-    clearBuffers();
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, filePath]() {
+        watcher->deleteLater();
+        QString error = watcher->result();
+        if (!error.isEmpty()) d->lastError = error;
+        emit fileSaved(error.isEmpty(), filePath, error);
+    });
+    watcher->setFuture(QtConcurrent::run([text, chunks, chunkRoot, filePath]() {
+        return saveTextFile(text, chunks, chunkRoot, filePath);
+    }));
     return true;
 }
 
@@ -68,28 +386,40 @@ bool DownloadManager::saveImage(const QPixmap& image, const QString& filePath) {
         return false;
     }
 
-    clearBuffers();
-    d->imageBuffer = std::make_unique<QBuffer>();
-
-    if (!d->imageBuffer->open(QIODevice::WriteOnly)) {
-        d->lastError = "无法初始化图片缓冲区";
+    QSaveFile file(filePath);
+    file.setDirectWriteFallback(true);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        d->lastError = "无法保存图片";
         return false;
     }
 
-    if (!image.save(d->imageBuffer.get(), "PNG")) {
-        d->lastError = "无法转换图片数据";
+    // 直接编码进文件，不经过中间缓冲区
+    if (!writeImage(image.toImage(), imageFormatFor(filePath), &file, &d->lastError)) {
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) {
+        d->lastError = "无法保存图片: " + file.errorString();
         return false;
     }
+    return true;
+}
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        d->lastError = "无法保存图片";
+bool DownloadManager::startImageSave(const QString& sourcePath, const QImage& image, const QString& filePath) {
+    if (!ensureDirectoryExists(filePath)) {
         return false;
     }
 
-    file.write(d->imageBuffer->data());
-    file.close();
-    clearBuffers();
+    auto *watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, filePath]() {
+        watcher->deleteLater();
+        QString error = watcher->result();
+        if (!error.isEmpty()) d->lastError = error;
+        emit fileSaved(error.isEmpty(), filePath, error);
+    });
+    watcher->setFuture(QtConcurrent::run([sourcePath, image, filePath]() {
+        return saveImageFile(sourcePath, image, filePath);
+    }));
     return true;
 }
 
@@ -107,3 +437,153 @@ bool DownloadManager::ensureDirectoryExists(const QString& filePath) {
 QString DownloadManager::getLastError() const {
     return d->lastError;
 }
+
+bool DownloadManager::isExporting() const {
+    return d->exportWatcher.isRunning();
+}
+
+void DownloadManager::cancelExport() {
+    d->exportCancelled = true;
+}
+
+bool DownloadManager::startExport(const QList<ExportItem>& items, const QString& target, ExportFormat format) {
+    if (isExporting()) {
+        d->lastError = "已有导出任务在进行";
+        return false;
+    }
+    if (format != ExportFormat::Directory && !ensureDirectoryExists(target)) {
+        return false;
+    }
+
+    d->exportCancelled = false;
+    d->exportError.clear();
+    // 协调线程负责按顺序写出，编码和压缩分发到独立的线程池
+    d->exportWatcher.setFuture(QtConcurrent::run([this, items, target, format]() {
+        return runExport(items, target, format, &d->exportError);
+    }));
+    return true;
+}
+
+bool DownloadManager::runExport(const QList<ExportItem>& items, const QString& target,
+                                ExportFormat format, QString *error) {
+    const bool archive = format != ExportFormat::Directory;
+    const int total = items.size();
+
+    std::unique_ptr<QSaveFile> output;
+    std::unique_ptr<QFileDevice> manifest;
+    QStringList written;  // 目录模式下取消时需要清理的文件
+
+    if (archive) {
+        output = std::make_unique<QSaveFile>(target);
+        if (!output->open(QIODevice::WriteOnly)) {
+            *error = "无法创建归档文件: " + output->errorString();
+            return false;
+        }
+        // 清单先写入临时文件，最后作为归档的最后一个成员流式写入
+        auto temp = std::make_unique<QTemporaryFile>();
+        if (!temp->open()) {
+            *error = "无法创建临时文件";
+            return false;
+        }
+        manifest = std::move(temp);
+    } else {
+        if (!QDir().mkpath(target)) {
+            *error = "无法创建目录: " + target;
+            return false;
+        }
+        auto file = std::make_unique<QSaveFile>(target + "/manifest.jsonl");
+        if (!file->open(QIODevice::WriteOnly)) {
+            *error = "无法创建清单文件: " + file->errorString();
+            return false;
+        }
+        manifest = std::move(file);
+    }
+
+    auto writeArchive = [&](const QByteArray& data, bool compress) {
+        const QByteArray& out = (compress && format == ExportFormat::TarGz) ? gzipMember(data) : data;
+        return output->write(out) == out.size();
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    // 同时在途的条目数有上限，内存占用与导出总量无关
+    const int window = pool.maxThreadCount() * 2;
+    const int progressStep = qMax(1, total / 100);
+
+    QQueue<QFuture<EncodedEntry>> inflight;
+    int done = 0;
+    bool ok = true;
+
+    auto consume = [&](const EncodedEntry& entry) {
+        if (!ok) return;
+        if (!entry.error.isEmpty()) {
+            *error = entry.error;
+            ok = false;
+            return;
+        }
+        if (archive && output->write(entry.data) != entry.data.size()) {
+            *error = "写入归档失败: " + output->errorString();
+            ok = false;
+            return;
+        }
+        if (!archive) written.append(entry.manifest["file"].toString());
+
+        QByteArray line = QJsonDocument(entry.manifest).toJson(QJsonDocument::Compact);
+        line.append('\n');
+        manifest->write(line);
+
+        ++done;
+        if (done % progressStep == 0 || done == total) {
+            QMetaObject::invokeMethod(this, [this, done, total]() {
+                emit exportProgress(done, total);
+            }, Qt::QueuedConnection);
+        }
+    };
+
+    for (const auto& item : items) {
+        if (d->exportCancelled || !ok) break;
+        inflight.enqueue(QtConcurrent::run(&pool, encodeEntry, item, target, format));
+        if (inflight.size() >= window) consume(inflight.dequeue().result());
+    }
+    // 取消或出错时也要等在途任务结束
+    while (!inflight.isEmpty()) consume(inflight.dequeue().result());
+
+    if (d->exportCancelled && ok) {
+        *error = "导出已取消";
+        ok = false;
+    }
+
+    if (ok && archive) {
+        // 清单成员：头部之后按块读取临时文件
+        qint64 size = manifest->size();
+        manifest->seek(0);
+        QByteArray chunk = tarHeader("manifest.jsonl", size, QDateTime::currentDateTime());
+        while (ok && !manifest->atEnd()) {
+            chunk += manifest->read(STREAM_CHUNK);
+            ok = writeArchive(chunk, true);
+            chunk.clear();
+        }
+        ok = ok && writeArchive(chunk + tarPadding(size) + QByteArray(2 * TAR_BLOCK, '\0'), true);
+        if (!ok && error->isEmpty()) *error = "写入归档失败: " + output->errorString();
+    }
+
+    if (archive) {
+        if (ok && !output->commit()) {
+            *error = "写入归档失败: " + output->errorString();
+            ok = false;
+        }
+        if (!ok) output->cancelWriting();
+        return ok;
+    }
+
+    auto *manifestFile = static_cast<QSaveFile*>(manifest.get());
+    if (ok && !manifestFile->commit()) {
+        *error = "无法写入清单文件";
+        ok = false;
+    }
+    if (!ok) {
+        manifestFile->cancelWriting();
+        for (const auto& name : written) QFile::remove(target + "/" + name);
+    }
+    return ok;
+}
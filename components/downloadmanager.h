@@ -3,7 +3,11 @@
 
 #include <QObject>
 #include <QPixmap>
+#include <QImage>
+#include <QDateTime>
 #include <QString>
+#include <QList>
+#include <QStringList>
 #include <memory>
 
 class DownloadManager : public QObject {
@@ -12,15 +16,54 @@ public:
     explicit DownloadManager(QObject *parent = nullptr);
     ~DownloadManager();
 
+    // 文本分块编码后直接写入文件，不在内存中生成整份副本
     bool saveText(const QString& text, const QString& filePath);
+    // 异步保存文本，结束时发出 fileSaved。chunks 非空时在工作线程中从 chunkRoot
+    // 逐块读出写入文件（块即 UTF-8 字节），完整文本不进入内存；块缺失时退回 text（预览）
+    bool startTextSave(const QString& text, const QStringList& chunks, const QString& chunkRoot,
+                       const QString& filePath);
+    // 同步保存内存中的图片，格式按扩展名决定
     bool saveImage(const QPixmap& image, const QString& filePath);
     QString getLastError() const;
 
+    // 异步保存图片，结束时发出 fileSaved。sourcePath 为存储中已编码的文件：
+    // 目标格式相同时直接复制文件（reflink / copy_file_range），不解码；
+    // 其他格式（或只有内存图像 image）在工作线程中转码
+    bool startImageSave(const QString& sourcePath, const QImage& image, const QString& filePath);
+
+    // 批量导出：每个条目只带元数据和图片文件路径，载荷由工作线程按需读取
+    struct ExportItem {
+        quint64 id = 0;
+        bool isImage = false;
+        QString text;
+        QStringList chunks;  // 分块存放的大文本：由导出线程从 chunkRoot 读取，text 只是预览
+        QString chunkRoot;
+        QString imagePath;   // 存储中已编码的 PNG，直接复制字节
+        QImage image;        // 没有图片文件时才需要在工作线程中编码
+        QDateTime timestamp;
+    };
+
+    enum class ExportFormat {
+        Directory,   // 每个条目一个文件，外加 manifest.jsonl
+        Tar,         // 单个 tar 归档，最后一个成员为 manifest.jsonl
+        TarGz        // 每个成员独立压缩为一个 gzip 分段，可并行压缩
+    };
+
+    // 异步导出，进度通过 exportProgress 报告，结束时发出 exportFinished
+    bool startExport(const QList<ExportItem>& items, const QString& target, ExportFormat format);
+    void cancelExport();
+    bool isExporting() const;
+
+signals:
+    void exportProgress(int done, int total);
+    void exportFinished(bool success, const QString& error);
+    void fileSaved(bool success, const QString& filePath, const QString& error);
+
 private:
     struct DownloadManagerPrivate;
     std::unique_ptr<DownloadManagerPrivate> d;
     bool ensureDirectoryExists(const QString& filePath);
-    void clearBuffers();
+    bool runExport(const QList<ExportItem>& items, const QString& target, ExportFormat format, QString *error);
 };
 
 #endif
@@ -0,0 +1,149 @@
+// entrycolumns.cpp
+#include "entrycolumns.h"
+#include "tracer.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// 每块先把判断结果写成字节掩码（可向量化），再按掩码收集行号
+const qsizetype BLOCK = 512;
+
+} // namespace
+
+bool EntryColumns::Query::isEmpty() const {
+    return type < 0 && sinceMs == std::numeric_limits<qint64>::min() &&
+           untilMs == std::numeric_limits<qint64>::max() && minBytes <= 0 &&
+           maxBytes == std::numeric_limits<qint64>::max() && requireFlags == 0 && excludeFlags == 0;
+}
+
+bool EntryColumns::Query::matches(int entryType, qint64 timestampMs, qint64 bytes, quint8 flags) const {
+    return (type < 0 || entryType == type) &&
+           timestampMs >= sinceMs && timestampMs <= untilMs &&
+           bytes >= minBytes && bytes <= maxBytes &&
+           (flags & requireFlags) == requireFlags && (flags & excludeFlags) == 0;
+}
+
+void EntryColumns::clear() {
+    m_ids.clear();
+    m_types.clear();
+    m_timestamps.clear();
+    m_bytes.clear();
+    m_flags.clear();
+    m_timeSorted = true;
+}
+
+void EntryColumns::reserve(qsizetype size) {
+    m_ids.reserve(size);
+    m_types.reserve(size);
+    m_timestamps.reserve(size);
+    m_bytes.reserve(size);
+    m_flags.reserve(size);
+}
+
+void EntryColumns::append(quint64 id, int type, qint64 timestampMs, qint64 bytes, quint8 flags) {
+    if (!m_timestamps.isEmpty() && timestampMs < m_timestamps.last()) m_timeSorted = false;
+    m_ids.append(id);
+    m_types.append(static_cast<quint8>(type));
+    m_timestamps.append(timestampMs);
+    m_bytes.append(bytes);
+    m_flags.append(flags);
+}
+
+void EntryColumns::insert(qsizetype row, quint64 id, int type, qint64 timestampMs, qint64 bytes, quint8 flags) {
+    if ((row > 0 && timestampMs < m_timestamps.at(row - 1)) ||
+        (row < size() && timestampMs > m_timestamps.at(row))) {
+        m_timeSorted = false;
+    }
+    m_ids.insert(row, id);
+    m_types.insert(row, static_cast<quint8>(type));
+    m_timestamps.insert(row, timestampMs);
+    m_bytes.insert(row, bytes);
+    m_flags.insert(row, flags);
+}
+
+void EntryColumns::removeRow(qsizetype row) {
+    m_ids.removeAt(row);
+    m_types.removeAt(row);
+    m_timestamps.removeAt(row);
+    m_bytes.removeAt(row);
+    m_flags.removeAt(row);
+}
+
+namespace {
+// 把 rows 之外、first 之后的元素依次前移，最后截掉尾部；rows 严格升序
+template <typename T>
+void compactRows(QList<T>& column, const QList<qsizetype>& rows) {
+    qsizetype kept = rows.first();
+    qsizetype next = 0;
+    for (qsizetype i = rows.first(); i < column.size(); ++i) {
+        if (next < rows.size() && rows.at(next) == i) {
+            ++next;
+            continue;
+        }
+        column[kept++] = column.at(i);
+    }
+    column.resize(kept);
+}
+}
+
+void EntryColumns::removeRows(const QList<qsizetype>& rows) {
+    if (rows.isEmpty()) return;
+    Q_ASSERT(std::adjacent_find(rows.cbegin(), rows.cend(), std::greater_equal<qsizetype>()) == rows.cend());
+    compactRows(m_ids, rows);
+    compactRows(m_types, rows);
+    compactRows(m_timestamps, rows);
+    compactRows(m_bytes, rows);
+    compactRows(m_flags, rows);
+}
+
+qsizetype EntryColumns::lowerBound(quint64 beforeId) const {
+    return std::lower_bound(m_ids.cbegin(), m_ids.cend(), beforeId) - m_ids.cbegin();
+}
+
+QList<qsizetype> EntryColumns::select(const Query& query, qsizetype from, qsizetype to) const {
+    TRACE_SCOPE("columns.select");
+    if (to < 0 || to > size()) to = size();
+    if (m_timeSorted && from < to) {
+        const qint64 *first = m_timestamps.constData();
+        from = std::lower_bound(first + from, first + to, query.sinceMs) - first;
+        to = std::upper_bound(first + from, first + to, query.untilMs) - first;
+    }
+    QList<qsizetype> rows;
+    if (from >= to) return rows;
+
+    const quint8 *types = m_types.constData();
+    const qint64 *timestamps = m_timestamps.constData();
+    const qint64 *bytes = m_bytes.constData();
+    const quint8 *flags = m_flags.constData();
+    // 不限类型时 anyType 恒为真，类型比较仍照常计算，循环体保持一致
+    const bool anyType = query.type < 0;
+    const quint8 type = static_cast<quint8>(query.type);
+    const qint64 since = query.sinceMs, until = query.untilMs;
+    const qint64 minBytes = query.minBytes, maxBytes = query.maxBytes;
+    const quint8 require = query.requireFlags, exclude = query.excludeFlags;
+
+    quint8 mask[BLOCK];
+    qsizetype selected[BLOCK];
+    for (qsizetype base = from; base < to; base += BLOCK) {
+        const qsizetype count = qMin(BLOCK, to - base);
+        // 只用按位与/或组合比较结果，不做短路求值
+        for (qsizetype j = 0; j < count; ++j) {
+            const qsizetype row = base + j;
+            mask[j] = static_cast<quint8>((anyType | (types[row] == type)) &
+                                          (timestamps[row] >= since) & (timestamps[row] <= until) &
+                                          (bytes[row] >= minBytes) & (bytes[row] <= maxBytes) &
+                                          ((flags[row] & require) == require) & ((flags[row] & exclude) == 0));
+        }
+        // 无分支收集：每行都写入，只有命中时游标前进
+        qsizetype hits = 0;
+        for (qsizetype j = 0; j < count; ++j) {
+            selected[hits] = base + j;
+            hits += mask[j];
+        }
+        const qsizetype offset = rows.size();
+        rows.resize(offset + hits);
+        std::copy_n(selected, hits, rows.begin() + offset);
+    }
+    return rows;
+}
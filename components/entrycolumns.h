@@ -0,0 +1,65 @@
+// entrycolumns.h
+#ifndef ENTRYCOLUMNS_H
+#define ENTRYCOLUMNS_H
+
+#include <QList>
+#include <QtGlobal>
+#include <limits>
+
+// 条目元数据按列存放（id、类型、毫秒时间戳、载荷字节数、标志各一个连续数组），
+// 按类型/时间/大小筛选时只扫描这几列，按块计算掩码，循环体无分支。
+// 时间戳随行号递增时（正常捕获顺序），时间条件先用二分查找缩小扫描范围。
+// 行号由调用方约定（ClipboardHistory 和 MainWindow 中都按 id 升序，即从旧到新）。
+class EntryColumns {
+public:
+    enum Flag : quint8 {
+        Pinned = 0x1,
+        Chunked = 0x2,
+    };
+
+    // 各项默认不限制；时间为毫秒时间戳，区间两端都包含
+    struct Query {
+        int type = -1;
+        qint64 sinceMs = std::numeric_limits<qint64>::min();
+        qint64 untilMs = std::numeric_limits<qint64>::max();
+        qint64 minBytes = 0;
+        qint64 maxBytes = std::numeric_limits<qint64>::max();
+        quint8 requireFlags = 0;
+        quint8 excludeFlags = 0;
+
+        bool isEmpty() const;
+        // 逐条判断，供流式读取等没有列数据的场合使用
+        bool matches(int type, qint64 timestampMs, qint64 bytes, quint8 flags) const;
+    };
+
+    void clear();
+    void reserve(qsizetype size);
+    qsizetype size() const { return m_ids.size(); }
+
+    void append(quint64 id, int type, qint64 timestampMs, qint64 bytes, quint8 flags);
+    // 在 row 之前插入（row 为 0 时插到最前，QList 前插均摊 O(1)）
+    void insert(qsizetype row, quint64 id, int type, qint64 timestampMs, qint64 bytes, quint8 flags);
+    void setFlags(qsizetype row, quint8 flags) { m_flags[row] = flags; }
+    // 删除一行，其余行保持原有顺序
+    void removeRow(qsizetype row);
+    // 删除多行，从最小行起一次压缩，代价与被移动的尾部成正比；
+    // rows 必须严格升序且不重复，调用方负责排序去重
+    void removeRows(const QList<qsizetype>& rows);
+
+    quint64 id(qsizetype row) const { return m_ids.at(row); }
+    // id 不小于 beforeId 的第一行（id 按行号升序时有效）
+    qsizetype lowerBound(quint64 beforeId) const;
+
+    // [from, to) 中满足条件的行号，升序；to 为 -1 时到末尾
+    QList<qsizetype> select(const Query& query, qsizetype from = 0, qsizetype to = -1) const;
+
+private:
+    QList<quint64> m_ids;
+    QList<quint8> m_types;
+    QList<qint64> m_timestamps;
+    QList<qint64> m_bytes;
+    QList<quint8> m_flags;
+    bool m_timeSorted = true;   // 系统时间回拨后不再有序，退回全范围扫描
+};
+
+#endif // ENTRYCOLUMNS_H
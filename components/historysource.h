@@ -0,0 +1,55 @@
+// historysource.h
+#ifndef HISTORYSOURCE_H
+#define HISTORYSOURCE_H
+
+#include <QObject>
+#include <QPixmap>
+#include <QList>
+#include "storagemanager.h"
+#include "entrycolumns.h"
+
+// 界面访问剪贴板历史的统一接口：
+// 进程内由 ClipboardHistory 实现，连接后台守护进程时由 HistoryClient 实现
+class HistorySource : public QObject {
+    Q_OBJECT
+public:
+    using Entry = StorageManager::ClipboardData;
+
+    explicit HistorySource(QObject *parent = nullptr) : QObject(parent) {}
+    ~HistorySource() override = default;
+
+    // 请求 id 小于 beforeId 的下一页（beforeId 为 0 时从最新一条开始），结果通过 pageLoaded 返回
+    virtual void requestPage(quint64 beforeId, int count) = 0;
+    virtual void copyToClipboard(quint64 id) = 0;
+    virtual void clear() = 0;
+    virtual bool save() = 0;
+    // 条目只带磁盘句柄时按 hash 读取图片
+    virtual QPixmap loadImage(const Entry& entry) = 0;
+    // 图片文件路径（PNG 或块映射），供工作线程用 TileStore::readImageFile 并行解码
+    virtual QString imagePath(const Entry& entry) const = 0;
+    // 完整文本：分块存放的大文本在预览、复制时才从块重组
+    virtual QString loadText(const Entry& entry) = 0;
+    // 块目录，供工作线程用 ChunkStore 逐块读取大文本（导出、保存）
+    virtual QString chunksPath() const = 0;
+    // 同步遍历全部历史（包括尚未分页加载的部分和置顶条目），只带元数据与磁盘句柄；
+    // 回调返回 false 时停止
+    virtual bool forEachEntry(const std::function<bool(const Entry&)>& callback) = 0;
+    // 置顶条目常驻内存，结果通过 pinnedLoaded 返回；分页结果中也带有 pinned 标记
+    virtual void requestPinned() = 0;
+    virtual void setPinned(quint64 id, bool pinned) = 0;
+    // 删除指定条目（包括置顶），或删除所有匹配搜索条件的普通条目；结果通过 entriesRemoved 返回
+    virtual void removeEntries(const QList<quint64>& ids) = 0;
+    virtual void removeMatching(const QString& query, const EntryColumns::Query& filter) = 0;
+
+signals:
+    void pageLoaded(const QList<StorageManager::ClipboardData>& entries, bool finished);
+    void entryAdded(const StorageManager::ClipboardData& entry);
+    void historyCleared();
+    void historyLimitReached();
+    void pinnedLoaded(const QList<StorageManager::ClipboardData>& entries);
+    void entryPinned(const StorageManager::ClipboardData& entry);
+    // 保留策略或用户删除移除的条目
+    void entriesRemoved(const QList<quint64>& ids);
+};
+
+#endif // HISTORYSOURCE_H
@@ -0,0 +1,118 @@
+// imagepyramid.cpp
+#include "imagepyramid.h"
+#include "memoryaccountant.h"
+#include "tilestore.h"
+#include "tracer.h"
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <cmath>
+
+ImagePyramid::ImagePyramid(QObject *parent)
+    : QObject(parent) {}
+
+ImagePyramid::~ImagePyramid() {
+    // 未完成的任务只持有图片副本，结果随 watcher 一起丢弃
+    MemoryAccountant::instance()->release(MemoryAccountant::FullImage, m_chargedBytes);
+}
+
+void ImagePyramid::load(const QString& path) {
+    // 块映射的尺寸在映射文件头中，QImageReader 读不出来
+    m_size = TileStore::imageSize(path);
+    m_busy = true;
+
+    auto *watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, path]() {
+        watcher->deleteLater();
+        m_busy = false;
+        QImage image = watcher->result();
+        if (image.isNull()) {
+            emit failed("无法加载图片: " + path);
+            return;
+        }
+        m_size = image.size();
+        storeLevel(0, image);
+        buildPending();
+    });
+    watcher->setFuture(QtConcurrent::run([path]() {
+        TRACE_SCOPE("preview.decode");
+        QImage image = TileStore::readImageFile(path);
+        // 统一为预乘格式，降采样和绘制都走快速路径
+        return image.isNull() ? image : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }));
+}
+
+void ImagePyramid::setImage(const QImage& image) {
+    if (image.isNull()) return;
+    m_size = image.size();
+    storeLevel(0, image.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    buildPending();
+}
+
+int ImagePyramid::levelCount() const {
+    if (m_size.isEmpty()) return 0;
+    int count = 1;
+    int longSide = qMax(m_size.width(), m_size.height());
+    while (longSide > TILE_SIZE) {
+        longSide = (longSide + 1) / 2;
+        ++count;
+    }
+    return count;
+}
+
+bool ImagePyramid::hasLevel(int level) const {
+    return level >= 0 && level < m_levels.size();
+}
+
+QImage ImagePyramid::level(int level) const {
+    return hasLevel(level) ? m_levels.at(level) : QImage();
+}
+
+void ImagePyramid::requestLevel(int level) {
+    level = qBound(0, level, qMax(0, levelCount() - 1));
+    m_requestedLevel = qMax(m_requestedLevel, level);
+    buildPending();
+}
+
+int ImagePyramid::levelForScale(qreal scale, int levelCount) {
+    if (levelCount <= 1 || scale >= 1.0) return 0;
+    int level = static_cast<int>(std::floor(std::log2(1.0 / scale)));
+    return qBound(0, level, levelCount - 1);
+}
+
+void ImagePyramid::storeLevel(int level, const QImage& image) {
+    Q_ASSERT(level == m_levels.size());
+    m_levels.append(image);
+    qint64 bytes = image.sizeInBytes();
+    m_chargedBytes += bytes;
+    MemoryAccountant::instance()->charge(MemoryAccountant::FullImage, bytes);
+    emit levelReady(level);
+}
+
+void ImagePyramid::buildPending() {
+    if (m_busy || m_levels.isEmpty() || m_levels.size() > m_requestedLevel) return;
+    m_busy = true;
+
+    // 每一层由上一层减半得到，代价依次为前一层的 1/4
+    QImage source = m_levels.last();
+    int count = m_requestedLevel - m_levels.size() + 1;
+
+    auto *watcher = new QFutureWatcher<QList<QImage>>(this);
+    connect(watcher, &QFutureWatcher<QList<QImage>>::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+        m_busy = false;
+        const QList<QImage> levels = watcher->result();
+        for (const auto& image : levels) storeLevel(m_levels.size(), image);
+        buildPending();
+    });
+    watcher->setFuture(QtConcurrent::run([source, count]() {
+        TRACE_SCOPE("preview.downsample");
+        QList<QImage> levels;
+        QImage current = source;
+        for (int i = 0; i < count; ++i) {
+            current = current.scaled((current.width() + 1) / 2, (current.height() + 1) / 2,
+                                     Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            levels.append(current);
+        }
+        return levels;
+    }));
+}
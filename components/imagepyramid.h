@@ -0,0 +1,53 @@
+// imagepyramid.h
+#ifndef IMAGEPYRAMID_H
+#define IMAGEPYRAMID_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+// 大图预览用的图像金字塔：第 k 层是原图的 1/2^k，直到长边不超过 TILE_SIZE。
+// 原图解码和各层降采样都在线程池中进行，只按需生成请求到的层；
+// 层数据只在主线程修改，工作线程拿到的是隐式共享的只读副本。
+class ImagePyramid : public QObject {
+    Q_OBJECT
+public:
+    static const int TILE_SIZE = 256;
+
+    explicit ImagePyramid(QObject *parent = nullptr);
+    ~ImagePyramid() override;
+
+    // 从文件加载：尺寸只读文件头立即可知，像素在工作线程解码
+    void load(const QString& path);
+    // 已在内存中的完整图片，直接作为第 0 层
+    void setImage(const QImage& image);
+
+    QSize size() const { return m_size; }
+    int levelCount() const;
+    bool hasLevel(int level) const;
+    QImage level(int level) const;
+
+    // 请求生成到第 level 层（含），完成后逐层发出 levelReady
+    void requestLevel(int level);
+
+    // 按显示比例（屏幕像素 / 原图像素）选择最合适的层
+    static int levelForScale(qreal scale, int levelCount);
+
+signals:
+    void levelReady(int level);
+    void failed(const QString& error);
+
+private:
+    void storeLevel(int level, const QImage& image);
+    void buildPending();
+
+    QSize m_size;
+    QList<QImage> m_levels;   // 已生成的层，从第 0 层开始连续
+    int m_requestedLevel = 0;
+    bool m_busy = false;      // 同一时刻只有一个解码或降采样任务
+    qint64 m_chargedBytes = 0;
+};
+
+#endif // IMAGEPYRAMID_H
@@ -0,0 +1,237 @@
+// historyclient.cpp
+#include "historyclient.h"
+#include "ipcprotocol.h"
+#include <QLocalSocket>
+#include <QJsonArray>
+#include <QDeadlineTimer>
+#include <QDebug>
+
+HistoryClient::HistoryClient(QObject *parent)
+    : HistorySource(parent)
+    , m_socket(new QLocalSocket(this))
+    , m_storage(new StorageManager(this))
+{
+    connect(m_socket, &QLocalSocket::readyRead, this, &HistoryClient::onReadyRead);
+    connect(m_socket, &QLocalSocket::disconnected, this, &HistoryClient::disconnected);
+}
+
+HistoryClient::~HistoryClient() {
+    m_socket->disconnectFromServer();
+}
+
+bool HistoryClient::connectToDaemon(int timeoutMs) {
+    m_socket->connectToServer(IpcProtocol::serverName());
+    if (!m_socket->waitForConnected(timeoutMs)) {
+        return false;
+    }
+    send({{"op", "subscribe"}});
+    return true;
+}
+
+bool HistoryClient::isConnected() const {
+    return m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+void HistoryClient::requestPage(quint64 beforeId, int count) {
+    send({{"op", "page"}, {"before", static_cast<qint64>(beforeId)}, {"count", count}});
+}
+
+void HistoryClient::copyToClipboard(quint64 id) {
+    send({{"op", "copy"}, {"id", static_cast<qint64>(id)}});
+}
+
+void HistoryClient::requestPinned() {
+    send({{"op", "pinned"}});
+}
+
+void HistoryClient::setPinned(quint64 id, bool pinned) {
+    send({{"op", "pin"}, {"id", static_cast<qint64>(id)}, {"pinned", pinned}});
+}
+
+void HistoryClient::removeEntries(const QList<quint64>& ids) {
+    QJsonArray array;
+    for (quint64 id : ids) array.append(static_cast<qint64>(id));
+    send({{"op", "remove"}, {"ids", array}});
+}
+
+void HistoryClient::removeMatching(const QString& query, const EntryColumns::Query& filter) {
+    QJsonObject request{{"op", "remove"}, {"query", query}};
+    IpcProtocol::queryToJson(filter, request);
+    send(request);
+}
+
+void HistoryClient::clear() {
+    send({{"op", "clear"}});
+}
+
+bool HistoryClient::save() {
+    // 由守护进程负责落盘，这里只是请求其立即保存
+    send({{"op", "save"}});
+    m_socket->flush();
+    return isConnected();
+}
+
+QPixmap HistoryClient::loadImage(const Entry& entry) {
+    if (!entry.image.isNull()) return entry.image;
+    return m_storage->loadImage(entry.hash);
+}
+
+QString HistoryClient::imagePath(const Entry& entry) const {
+    return m_storage->imagePath(entry.hash);
+}
+
+bool HistoryClient::forEachEntry(const std::function<bool(const Entry&)>& callback) {
+    // 直接流式读取守护进程写下的历史文件，不经过连接逐页请求；
+    // 守护进程可能还有未落盘的捕获，先请求保存并等到应答
+    if (!saveAndWait()) qDebug() << "后台保存失败，最近的记录可能未包含在内";
+    return m_storage->readHistory(callback, false);
+}
+
+QString HistoryClient::chunksPath() const {
+    return m_storage->getChunksPath();
+}
+
+QString HistoryClient::loadText(const Entry& entry) {
+    // 分块与图片一样存放在共享目录中，直接读取，不走管道
+    return m_storage->loadText(entry);
+}
+
+void HistoryClient::fetchPayload(quint64 id, int chunkSize) {
+    QJsonObject request{{"op", "fetch"}, {"id", static_cast<qint64>(id)}};
+    if (chunkSize > 0) request["chunk"] = chunkSize;
+    int seq = send(request);
+    if (seq > 0) {
+        PendingFetch fetch;
+        fetch.id = id;
+        m_fetches.insert(seq, fetch);
+    }
+}
+
+void HistoryClient::search(const QString& query, const QString& type, quint64 beforeId, int limit) {
+    send({{"op", "search"}, {"query", query}, {"type", type},
+          {"before", static_cast<qint64>(beforeId)}, {"limit", limit}});
+}
+
+bool HistoryClient::saveAndWait(int timeoutMs) {
+    int seq = send({{"op", "save"}});
+    if (seq == 0) return false;
+    m_awaitSeq = seq;
+    m_awaitOk = false;
+    // 等待期间到达的事件和其他应答照常经 onReadyRead 处理
+    QDeadlineTimer deadline(timeoutMs);
+    m_socket->flush();
+    while (m_awaitSeq != 0 && isConnected() && !deadline.hasExpired()) {
+        m_socket->waitForReadyRead(static_cast<int>(deadline.remainingTime()));
+    }
+    bool ok = m_awaitSeq == 0 && m_awaitOk;
+    m_awaitSeq = 0;
+    return ok;
+}
+
+int HistoryClient::send(QJsonObject request) {
+    if (!isConnected()) return 0;
+    int seq = m_nextSeq++;
+    request["seq"] = seq;
+    m_socket->write(IpcProtocol::encodeMessage(request));
+    return seq;
+}
+
+void HistoryClient::onReadyRead() {
+    while (true) {
+        // 正在接收数据帧的原始字节
+        if (m_frameBytes > 0) {
+            QByteArray data = m_socket->read(m_frameBytes);
+            if (data.isEmpty()) return;
+            m_frameBytes -= data.size();
+
+            auto it = m_fetches.find(m_frameSeq);
+            if (it == m_fetches.end()) continue;
+            emit payloadData(it->id, data);
+            it->remaining -= data.size();
+            if (it->remaining <= 0 && m_frameBytes == 0) {
+                quint64 id = it->id;
+                m_fetches.erase(it);
+                emit payloadFinished(id);
+            }
+            continue;
+        }
+
+        if (!m_socket->canReadLine()) return;
+
+        QJsonObject message;
+        if (!IpcProtocol::decodeMessage(m_socket->readLine(), message)) continue;
+
+        // 数据帧头
+        if (message.contains("chunk") && message.contains("bytes")) {
+            m_frameSeq = message["seq"].toInt();
+            m_frameBytes = message["bytes"].toInteger();
+            continue;
+        }
+        handleMessage(message);
+    }
+}
+
+void HistoryClient::handleMessage(const QJsonObject& message) {
+    QString event = message["event"].toString();
+    if (event == "added") {
+        emit entryAdded(IpcProtocol::entryFromJson(message["entry"].toObject()));
+        return;
+    }
+    if (event == "cleared") {
+        emit historyCleared();
+        return;
+    }
+    if (event == "limit") {
+        emit historyLimitReached();
+        return;
+    }
+    if (event == "removed") {
+        QList<quint64> ids;
+        const QJsonArray array = message["ids"].toArray();
+        for (const auto& value : array) ids.append(static_cast<quint64>(value.toInteger()));
+        emit entriesRemoved(ids);
+        return;
+    }
+    if (event == "pinned") {
+        emit entryPinned(IpcProtocol::entryFromJson(message["entry"].toObject()));
+        return;
+    }
+
+    QString op = message["op"].toString();
+    if (m_awaitSeq != 0 && message["seq"].toInt() == m_awaitSeq) {
+        m_awaitSeq = 0;
+        m_awaitOk = message["ok"].toBool();
+    }
+    if (!message["ok"].toBool()) {
+        qDebug() << "后台请求失败:" << op << message["error"].toString();
+        m_fetches.remove(message["seq"].toInt());
+        emit requestFailed(op, message["error"].toString());
+        return;
+    }
+
+    if (op == "page" || op == "search" || op == "pinned") {
+        QList<Entry> entries;
+        const QJsonArray array = message["entries"].toArray();
+        entries.reserve(array.size());
+        for (const auto& value : array) {
+            entries.append(IpcProtocol::entryFromJson(value.toObject()));
+        }
+        if (op == "page") {
+            emit pageLoaded(entries, message["finished"].toBool());
+        } else if (op == "pinned") {
+            emit pinnedLoaded(entries);
+        } else {
+            emit searchResults(entries, message["finished"].toBool());
+        }
+    } else if (op == "fetch") {
+        auto it = m_fetches.find(message["seq"].toInt());
+        if (it == m_fetches.end()) return;
+        it->remaining = message["size"].toInteger();
+        emit payloadStarted(it->id, message["mime"].toString(), it->remaining);
+        if (it->remaining == 0) {
+            quint64 id = it->id;
+            m_fetches.erase(it);
+            emit payloadFinished(id);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+// historyclient.h
+#ifndef HISTORYCLIENT_H
+#define HISTORYCLIENT_H
+
+#include "../historysource.h"
+#include <QJsonObject>
+#include <QHash>
+
+class QLocalSocket;
+
+// 界面端：连接后台守护进程，通过本地套接字访问历史
+class HistoryClient : public HistorySource {
+    Q_OBJECT
+public:
+    explicit HistoryClient(QObject *parent = nullptr);
+    ~HistoryClient() override;
+
+    bool connectToDaemon(int timeoutMs = 100);
+    bool isConnected() const;
+
+    void requestPage(quint64 beforeId, int count) override;
+    void copyToClipboard(quint64 id) override;
+    void clear() override;
+    bool save() override;
+    QPixmap loadImage(const Entry& entry) override;
+    QString imagePath(const Entry& entry) const override;
+    QString loadText(const Entry& entry) override;
+    QString chunksPath() const override;
+    bool forEachEntry(const std::function<bool(const Entry&)>& callback) override;
+    void requestPinned() override;
+    void setPinned(quint64 id, bool pinned) override;
+    void removeEntries(const QList<quint64>& ids) override;
+    void removeMatching(const QString& query, const EntryColumns::Query& filter) override;
+
+    // 分块获取完整载荷，数据通过 payloadData 逐段返回
+    void fetchPayload(quint64 id, int chunkSize = 0);
+    void search(const QString& query, const QString& type = QString(), quint64 beforeId = 0, int limit = 100);
+
+signals:
+    void disconnected();
+    void searchResults(const QList<StorageManager::ClipboardData>& entries, bool finished);
+    void payloadStarted(quint64 id, const QString& mime, qint64 size);
+    void payloadData(quint64 id, const QByteArray& data);
+    void payloadFinished(quint64 id);
+    void requestFailed(const QString& op, const QString& error);
+
+private slots:
+    void onReadyRead();
+
+private:
+    int send(QJsonObject request);
+    // 同步请求守护进程保存并等待应答，供需要读取完整历史文件的调用方使用
+    bool saveAndWait(int timeoutMs = 5000);
+    void handleMessage(const QJsonObject& message);
+
+    // 分块传输状态：帧头之后的原始字节数
+    struct PendingFetch {
+        quint64 id = 0;
+        qint64 remaining = 0;
+    };
+    QHash<int, PendingFetch> m_fetches;  // seq -> 传输
+    int m_frameSeq = 0;
+    qint64 m_frameBytes = 0;
+
+    QLocalSocket *m_socket;
+    StorageManager *m_storage;  // 只读：按 hash 读取共享目录中的图片
+    int m_nextSeq = 1;
+    int m_awaitSeq = 0;     // saveAndWait 等待中的请求
+    bool m_awaitOk = false;
+};
+
+#endif // HISTORYCLIENT_H
@@ -0,0 +1,435 @@
+// historyserver.cpp
+#include "historyserver.h"
+#include "ipcprotocol.h"
+#include "../clipboardhistory.h"
+#include "../tilestore.h"
+#include "../tracer.h"
+#include "../memoryaccountant.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+HistoryServer::HistoryServer(ClipboardHistory *history, QObject *parent)
+    : QObject(parent)
+    , m_history(history)
+    , m_server(new QLocalServer(this))
+{
+    connect(m_server, &QLocalServer::newConnection, this, &HistoryServer::onNewConnection);
+
+    connect(m_history, &ClipboardHistory::entryAdded, this, [this](const StorageManager::ClipboardData& entry) {
+        QJsonObject event;
+        event["event"] = "added";
+        event["entry"] = IpcProtocol::entryToJson(entry);
+        broadcast(event);
+    });
+    connect(m_history, &ClipboardHistory::historyCleared, this, [this]() {
+        broadcast(QJsonObject{{"event", "cleared"}});
+    });
+    connect(m_history, &ClipboardHistory::entryPinned, this, [this](const StorageManager::ClipboardData& entry) {
+        QJsonObject event;
+        event["event"] = "pinned";
+        event["entry"] = IpcProtocol::entryToJson(entry);
+        broadcast(event);
+    });
+    connect(m_history, &ClipboardHistory::entriesRemoved, this, [this](const QList<quint64>& ids) {
+        QJsonArray array;
+        for (quint64 id : ids) array.append(static_cast<qint64>(id));
+        broadcast(QJsonObject{{"event", "removed"}, {"ids", array}});
+    });
+    connect(m_history, &ClipboardHistory::historyLimitReached, this, [this]() {
+        broadcast(QJsonObject{{"event", "limit"}});
+    });
+}
+
+HistoryServer::~HistoryServer() {
+    m_server->close();
+}
+
+bool HistoryServer::listen() {
+    QString name = IpcProtocol::serverName();
+
+    // 已有实例在运行则不再启动
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(100)) {
+        m_lastError = "已有后台实例在运行";
+        return false;
+    }
+
+    // 清理上次异常退出残留的套接字文件
+    QLocalServer::removeServer(name);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server->listen(name)) {
+        m_lastError = m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void HistoryServer::onNewConnection() {
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        m_connections.insert(socket, Connection());
+        connect(socket, &QLocalSocket::readyRead, this, &HistoryServer::onReadyRead);
+        connect(socket, &QLocalSocket::bytesWritten, this, &HistoryServer::onBytesWritten);
+        connect(socket, &QLocalSocket::disconnected, this, &HistoryServer::onDisconnected);
+    }
+}
+
+void HistoryServer::onDisconnected() {
+    auto *socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) return;
+    m_connections.remove(socket);
+    socket->deleteLater();
+}
+
+void HistoryServer::onReadyRead() {
+    auto *socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket) return;
+
+    // 同一次读取中的所有应答（以及其间产生的事件）合并为一次写入
+    m_reading = socket;
+    while (socket->canReadLine()) {
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(socket->readLine(), &error);
+        if (error.error != QJsonParseError::NoError) {
+            enqueue(socket, IpcProtocol::encodeMessage({{"ok", false}, {"error", "bad request"}}));
+            continue;
+        }
+
+        if (doc.isArray()) {
+            const QJsonArray batch = doc.array();
+            for (const auto& value : batch) respond(socket, value.toObject());
+        } else {
+            respond(socket, doc.object());
+        }
+    }
+    m_reading = nullptr;
+
+    flush(socket);
+    pumpTransfers(socket);
+}
+
+void HistoryServer::respond(QLocalSocket *socket, const QJsonObject& request) {
+    m_handling = true;
+    QJsonObject response = handleRequest(socket, request);
+    m_handling = false;
+    // startFetch 自行排队（应答与数据帧绑定），返回空对象
+    if (!response.isEmpty()) enqueue(socket, IpcProtocol::encodeMessage(response));
+
+    // 请求引起的事件（如 remove 之后的 removed）在应答之后到达
+    const QList<QByteArray> held = std::exchange(m_heldEvents, {});
+    for (const auto& message : held) {
+        for (auto it = m_connections.begin(); it != m_connections.end(); ++it) {
+            if (!it->subscribed) continue;
+            it->outbox.append(Outgoing{message});
+            if (it.key() != m_reading) flush(it.key());
+        }
+    }
+}
+
+void HistoryServer::enqueue(QLocalSocket *socket, const QByteArray& message) {
+    m_connections[socket].outbox.append(Outgoing{message});
+}
+
+void HistoryServer::flush(QLocalSocket *socket) {
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) return;
+    // 数据帧发送期间暂停：fetch 的应答之后必须紧跟它的全部数据帧，由 pumpTransfers 发完后继续
+    if (!it->transfers.isEmpty()) return;
+    // 按顺序写出已就绪的部分，遇到仍在准备的应答或带数据帧的应答停下
+    QByteArray out;
+    qsizetype ready = 0;
+    while (ready < it->outbox.size() && it->outbox.at(ready).ticket == 0) {
+        Outgoing& outgoing = it->outbox[ready++];
+        out += outgoing.message;
+        if (outgoing.hasTransfer) {
+            it->transfers.append(std::move(outgoing.transfer));
+            break;
+        }
+    }
+    it->outbox.remove(0, ready);
+    if (!out.isEmpty()) socket->write(out);
+}
+
+void HistoryServer::onBytesWritten() {
+    if (auto *socket = qobject_cast<QLocalSocket*>(sender())) {
+        pumpTransfers(socket);
+    }
+}
+
+QJsonObject HistoryServer::handleRequest(QLocalSocket *socket, const QJsonObject& request) {
+    QString op = request["op"].toString();
+    QJsonObject response;
+    response["seq"] = request["seq"];
+    response["op"] = op;
+    response["ok"] = true;
+
+    Connection& connection = m_connections[socket];
+    quint64 before = static_cast<quint64>(request["before"].toInteger());
+    int preview = request["preview"].toInt(0);
+
+    if (op == "hello") {
+        response["version"] = IpcProtocol::VERSION;
+    } else if (op == "page" || op == "list") {
+        bool finished = false;
+        auto entries = m_history->page(before, request["count"].toInt(50), &finished);
+        QJsonArray array;
+        for (const auto& entry : entries) {
+            array.append(IpcProtocol::entryToJson(entry, preview));
+        }
+        response["entries"] = array;
+        response["finished"] = finished;
+    } else if (op == "search") {
+        bool finished = false;
+        auto entries = m_history->search(request["query"].toString(), IpcProtocol::queryFromJson(request),
+                                         before, request["limit"].toInt(100), &finished);
+        QJsonArray array;
+        for (const auto& entry : entries) {
+            array.append(IpcProtocol::entryToJson(entry, preview));
+        }
+        response["entries"] = array;
+        response["finished"] = finished;
+    } else if (op == "pinned") {
+        QJsonArray array;
+        for (const auto& entry : m_history->pinnedEntries()) {
+            array.append(IpcProtocol::entryToJson(entry, preview));
+        }
+        response["entries"] = array;
+    } else if (op == "pin") {
+        quint64 id = static_cast<quint64>(request["id"].toInteger());
+        if (!m_history->findEntry(id)) {
+            response["ok"] = false;
+            response["error"] = "not found";
+        } else {
+            m_history->setPinned(id, request["pinned"].toBool(true));
+        }
+    } else if (op == "remove") {
+        qsizetype before = m_history->entries().size();
+        if (request.contains("ids")) {
+            QList<quint64> ids;
+            for (const auto& value : request["ids"].toArray()) ids.append(static_cast<quint64>(value.toInteger()));
+            m_history->removeEntries(ids);
+        } else {
+            m_history->removeMatching(request["query"].toString(), IpcProtocol::queryFromJson(request));
+        }
+        response["removed"] = static_cast<qint64>(before - m_history->entries().size());
+    } else if (op == "fetch") {
+        return startFetch(socket, request, response);
+    } else if (op == "copy") {
+        quint64 id = static_cast<quint64>(request["id"].toInteger());
+        if (!m_history->findEntry(id)) {
+            response["ok"] = false;
+            response["error"] = "not found";
+        } else {
+            m_history->copyToClipboard(id);
+        }
+    } else if (op == "clear") {
+        m_history->clear();
+    } else if (op == "save") {
+        response["ok"] = m_history->save();
+    } else if (op == "trace") {
+        // {"op":"trace","enable":true} 开关追踪；{"op":"trace","export":"/path.json"} 导出
+        if (request.contains("enable")) Tracer::setEnabled(request["enable"].toBool());
+        if (request.contains("export")) {
+            response["ok"] = Tracer::exportChromeTrace(request["export"].toString());
+        }
+        QJsonArray stages;
+        for (const auto& stage : Tracer::stageStats()) {
+            stages.append(QJsonObject{{"name", stage.name}, {"count", stage.count},
+                                      {"p50_ms", stage.p50Ms}, {"p99_ms", stage.p99Ms}});
+        }
+        response["enabled"] = Tracer::isEnabled();
+        response["stages"] = stages;
+    } else if (op == "stats") {
+        // 各类别内存占用（字节）以及总量和预算
+        QJsonObject memory;
+        for (const auto& entry : MemoryAccountant::instance()->stats()) {
+            memory[entry.first] = entry.second;
+        }
+        response["memory"] = memory;
+        QJsonObject capture;
+        for (const auto& entry : m_history->scheduler()->stats()) {
+            capture[entry.first] = entry.second;
+        }
+        response["capture"] = capture;
+        QJsonObject retention;
+        for (const auto& entry : m_history->retentionStats()) {
+            retention[entry.first] = entry.second;
+        }
+        response["retention"] = retention;
+        // 分块存储的去重率与切分吞吐
+        QJsonObject chunks;
+        for (const auto& entry : m_history->storage()->chunkStats()) {
+            chunks[entry.first] = entry.second;
+        }
+        response["chunks"] = chunks;
+        QJsonObject tiles;
+        for (const auto& entry : m_history->storage()->tileStats()) {
+            tiles[entry.first] = entry.second;
+        }
+        response["tiles"] = tiles;
+        if (auto *selection = m_history->selectionScheduler()) {
+            QJsonObject selectionStats;
+            for (const auto& entry : selection->stats()) {
+                selectionStats[entry.first] = entry.second;
+            }
+            response["selection"] = selectionStats;
+        }
+    } else if (op == "subscribe") {
+        connection.subscribed = true;
+    } else if (op == "unsubscribe") {
+        connection.subscribed = false;
+    } else {
+        response["ok"] = false;
+        response["error"] = "unknown op";
+    }
+
+    return response;
+}
+
+QJsonObject HistoryServer::startFetch(QLocalSocket *socket, const QJsonObject& request, QJsonObject response) {
+    const auto *entry = m_history->findEntry(static_cast<quint64>(request["id"].toInteger()));
+    if (!entry) {
+        response["ok"] = false;
+        response["error"] = "not found";
+        return response;
+    }
+
+    Transfer transfer;
+    transfer.seq = request["seq"];
+    transfer.chunkSize = qBound(4096, request["chunk"].toInt(IpcProtocol::DEFAULT_CHUNK_SIZE),
+                                IpcProtocol::MAX_CHUNK_SIZE);
+
+    if (entry->type == StorageManager::ClipboardData::Image &&
+        TileStore::isMapPath(m_history->storage()->imagePath(entry->hash))) {
+        // 分块存放的图片没有现成的 PNG：在线程池中重建并编码，完成后再应答，
+        // 这期间同一连接后续的应答和事件在队列中等待，顺序不变
+        quint64 ticket = m_nextTicket++;
+        Outgoing placeholder;
+        placeholder.ticket = ticket;
+        placeholder.hasTransfer = true;
+        placeholder.transfer = transfer;
+        m_connections[socket].outbox.append(placeholder);
+
+        QPointer<QLocalSocket> target(socket);
+        StorageManager *storage = m_history->storage();
+        auto *watcher = new QFutureWatcher<QByteArray>(this);
+        connect(watcher, &QFutureWatcher<QByteArray>::finished, this, [this, watcher, target, ticket, response]() {
+            watcher->deleteLater();
+            if (target) finishFetch(target, ticket, response, watcher->result());
+        });
+        watcher->setFuture(QtConcurrent::run([storage, hash = entry->hash]() {
+            TRACE_SCOPE("fetch.rebuildTiles");
+            return storage->loadImageData(hash);
+        }));
+        return QJsonObject();
+    } else if (entry->type == StorageManager::ClipboardData::Image) {
+        // 直接映射磁盘上的 PNG，按块写入套接字，不经过解码和中间缓冲
+        auto file = QSharedPointer<QFile>::create(m_history->storage()->imagePath(entry->hash));
+        if (!file->open(QIODevice::ReadOnly)) {
+            response["ok"] = false;
+            response["error"] = "payload missing";
+            return response;
+        }
+        transfer.size = file->size();
+        transfer.data = reinterpret_cast<const char*>(file->map(0, transfer.size));
+        if (!transfer.data && transfer.size > 0) {
+            transfer.buffer = file->readAll();
+            transfer.data = transfer.buffer.constData();
+        }
+        transfer.file = file;
+        response["mime"] = "image/png";
+    } else {
+        // 分块文本的块本身就是 UTF-8 字节，直接拼接
+        transfer.buffer = m_history->storage()->loadTextData(*entry);
+        transfer.data = transfer.buffer.constData();
+        transfer.size = transfer.buffer.size();
+        response["mime"] = "text/plain;charset=utf-8";
+    }
+
+    response["size"] = transfer.size;
+    response["chunks"] = static_cast<qint64>((transfer.size + transfer.chunkSize - 1) / transfer.chunkSize);
+    Outgoing outgoing;
+    outgoing.message = IpcProtocol::encodeMessage(response);
+    outgoing.hasTransfer = true;
+    outgoing.transfer = transfer;
+    m_connections[socket].outbox.append(outgoing);
+    return QJsonObject();
+}
+
+void HistoryServer::finishFetch(QLocalSocket *socket, quint64 ticket, QJsonObject response, const QByteArray& png) {
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) return;
+    auto pending = std::find_if(it->outbox.begin(), it->outbox.end(),
+                                [ticket](const Outgoing& outgoing) { return outgoing.ticket == ticket; });
+    if (pending == it->outbox.end()) return;
+
+    pending->ticket = 0;
+    if (png.isEmpty()) {
+        response["ok"] = false;
+        response["error"] = "payload missing";
+        pending->hasTransfer = false;
+    } else {
+        Transfer& transfer = pending->transfer;
+        transfer.buffer = png;
+        transfer.data = transfer.buffer.constData();
+        transfer.size = transfer.buffer.size();
+        response["mime"] = "image/png";
+        response["size"] = transfer.size;
+        response["chunks"] = static_cast<qint64>((transfer.size + transfer.chunkSize - 1) / transfer.chunkSize);
+    }
+    pending->message = IpcProtocol::encodeMessage(response);
+    flush(socket);
+    pumpTransfers(socket);
+}
+
+void HistoryServer::pumpTransfers(QLocalSocket *socket) {
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) return;
+
+    QList<Transfer>& transfers = it->transfers;
+    while (socket->bytesToWrite() < WRITE_HIGH_WATER) {
+        if (transfers.isEmpty()) {
+            // 当前载荷已发完，写出排在它后面的消息（可能开始下一个载荷）
+            flush(socket);
+            if (transfers.isEmpty()) break;
+            continue;
+        }
+        Transfer& transfer = transfers.first();
+        if (transfer.offset >= transfer.size) {
+            transfers.removeFirst();
+            continue;
+        }
+
+        qint64 bytes = qMin<qint64>(transfer.chunkSize, transfer.size - transfer.offset);
+        QJsonObject header;
+        header["seq"] = transfer.seq;
+        header["chunk"] = transfer.chunkIndex++;
+        header["bytes"] = bytes;
+        socket->write(IpcProtocol::encodeMessage(header));
+        socket->write(transfer.data + transfer.offset, bytes);
+        transfer.offset += bytes;
+    }
+}
+
+void HistoryServer::broadcast(const QJsonObject& event) {
+    QByteArray message = IpcProtocol::encodeMessage(event);
+    if (m_handling) {
+        m_heldEvents.append(message);
+        return;
+    }
+    // 与应答共用每个连接的写出队列，不会越过尚未写出的应答
+    for (auto it = m_connections.begin(); it != m_connections.end(); ++it) {
+        if (!it->subscribed) continue;
+        it->outbox.append(Outgoing{message});
+        if (it.key() != m_reading) flush(it.key());
+    }
+}
@@ -0,0 +1,82 @@
+// historyserver.h
+#ifndef HISTORYSERVER_H
+#define HISTORYSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QJsonObject>
+#include <QSharedPointer>
+
+class QLocalServer;
+class QLocalSocket;
+class QFile;
+class ClipboardHistory;
+
+// 守护进程端：通过 QLocalServer 提供历史查询接口（协议见 ipcprotocol.h）
+class HistoryServer : public QObject {
+    Q_OBJECT
+public:
+    explicit HistoryServer(ClipboardHistory *history, QObject *parent = nullptr);
+    ~HistoryServer() override;
+
+    bool listen();
+    QString getLastError() const { return m_lastError; }
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onBytesWritten();
+    void onDisconnected();
+
+private:
+    // 正在分块发送的载荷：图片直接映射文件，文本只转换一次 UTF-8
+    struct Transfer {
+        QJsonValue seq;
+        QSharedPointer<QFile> file;
+        const char *data = nullptr;
+        QByteArray buffer;
+        qint64 size = 0;
+        qint64 offset = 0;
+        int chunkSize = 0;
+        int chunkIndex = 0;
+    };
+
+    // 写出队列中的一项：ticket 非 0 表示应答还在工作线程中准备，之后的消息都要等它
+    struct Outgoing {
+        QByteArray message;
+        quint64 ticket = 0;
+        bool hasTransfer = false;
+        Transfer transfer;   // 应答写出后才开始发送数据帧
+    };
+
+    struct Connection {
+        bool subscribed = false;
+        QList<Transfer> transfers;  // 至多一个：发送期间 outbox 暂停写出
+        QList<Outgoing> outbox;   // 待写出的应答和事件，按产生顺序写入套接字
+    };
+
+    void respond(QLocalSocket *socket, const QJsonObject& request);
+    QJsonObject handleRequest(QLocalSocket *socket, const QJsonObject& request);
+    QJsonObject startFetch(QLocalSocket *socket, const QJsonObject& request, QJsonObject response);
+    void pumpTransfers(QLocalSocket *socket);
+    void broadcast(const QJsonObject& event);
+    void flush(QLocalSocket *socket);
+    void enqueue(QLocalSocket *socket, const QByteArray& message);
+    void finishFetch(QLocalSocket *socket, quint64 ticket, QJsonObject response, const QByteArray& png);
+
+    ClipboardHistory *m_history;
+    QLocalServer *m_server;
+    QHash<QLocalSocket*, Connection> m_connections;
+    QString m_lastError;
+    // 处理请求期间产生的事件先暂存，排在该请求的应答之后发出
+    bool m_handling = false;
+    QList<QByteArray> m_heldEvents;
+    QLocalSocket *m_reading = nullptr;   // 正在处理的连接，读完后统一写出
+    quint64 m_nextTicket = 1;
+
+    // 写缓冲低于该值时才继续发送下一块，避免大载荷整体堆积在内存中
+    static const qint64 WRITE_HIGH_WATER = 256 * 1024;
+};
+
+#endif // HISTORYSERVER_H
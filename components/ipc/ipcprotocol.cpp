@@ -0,0 +1,108 @@
+// ipcprotocol.cpp
+#include "ipcprotocol.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QCoreApplication>
+
+namespace IpcProtocol {
+
+QString serverName() {
+    // 按应用名区分，同一用户下唯一
+    return QCoreApplication::applicationName() + "_history";
+}
+
+QJsonObject entryToJson(const StorageManager::ClipboardData& entry, int previewLength) {
+    QJsonObject obj;
+    obj["id"] = static_cast<qint64>(entry.id);
+    obj["type"] = (entry.type == StorageManager::ClipboardData::Text) ? "text" : "image";
+    obj["timestamp"] = entry.timestamp.toString(Qt::ISODate);
+    obj["ts"] = entry.timestamp.toMSecsSinceEpoch();
+    if (entry.bytes > 0) obj["bytes"] = entry.bytes;
+    if (entry.pinned) obj["pinned"] = true;
+    if (entry.type == StorageManager::ClipboardData::Text) {
+        if (entry.isChunked()) {
+            // 分块文本只带预览和块列表，客户端从共享的块目录重组
+            obj["text"] = previewLength > 0 ? entry.text.left(previewLength) : entry.text;
+            obj["length"] = entry.textLength;
+            obj["truncated"] = true;
+            obj["chunks"] = QJsonArray::fromStringList(entry.chunks);
+        } else if (previewLength > 0 && entry.text.size() > previewLength) {
+            obj["text"] = entry.text.left(previewLength);
+            obj["length"] = static_cast<qint64>(entry.text.size());
+            obj["truncated"] = true;
+        } else {
+            obj["text"] = entry.text;
+        }
+    } else {
+        // 图片不走管道，客户端按 hash 从共享的图片目录读取
+        obj["hash"] = entry.hash;
+    }
+    return obj;
+}
+
+StorageManager::ClipboardData entryFromJson(const QJsonObject& obj) {
+    StorageManager::ClipboardData entry;
+    entry.id = static_cast<quint64>(obj["id"].toInteger());
+    const QJsonValue ts = obj["ts"];
+    entry.timestamp = ts.isDouble() ? QDateTime::fromMSecsSinceEpoch(ts.toInteger())
+                                    : QDateTime::fromString(obj["timestamp"].toString(), Qt::ISODate);
+    entry.bytes = obj["bytes"].toInteger();
+    entry.pinned = obj["pinned"].toBool();
+    if (obj["type"].toString() == "text") {
+        entry.type = StorageManager::ClipboardData::Text;
+        entry.text = obj["text"].toString();
+        if (obj.contains("chunks")) {
+            const QJsonArray chunks = obj["chunks"].toArray();
+            for (const auto& id : chunks) entry.chunks.append(id.toString());
+            entry.textLength = obj["length"].toInteger();
+        }
+    } else {
+        entry.type = StorageManager::ClipboardData::Image;
+        entry.hash = obj["hash"].toString();
+    }
+    return entry;
+}
+
+int typeFromString(const QString& type) {
+    if (type == "text") return StorageManager::ClipboardData::Text;
+    if (type == "image") return StorageManager::ClipboardData::Image;
+    return -1;
+}
+
+EntryColumns::Query queryFromJson(const QJsonObject& request) {
+    EntryColumns::Query query;
+    query.type = typeFromString(request["type"].toString());
+    if (request.contains("since")) query.sinceMs = request["since"].toInteger();
+    if (request.contains("until")) query.untilMs = request["until"].toInteger();
+    if (request.contains("minBytes")) query.minBytes = request["minBytes"].toInteger();
+    if (request.contains("maxBytes")) query.maxBytes = request["maxBytes"].toInteger();
+    return query;
+}
+
+void queryToJson(const EntryColumns::Query& query, QJsonObject& request) {
+    // 只写出设置过的条件
+    const EntryColumns::Query defaults;
+    if (query.type >= 0) request["type"] = query.type == StorageManager::ClipboardData::Text ? "text" : "image";
+    if (query.sinceMs != defaults.sinceMs) request["since"] = query.sinceMs;
+    if (query.untilMs != defaults.untilMs) request["until"] = query.untilMs;
+    if (query.minBytes != defaults.minBytes) request["minBytes"] = query.minBytes;
+    if (query.maxBytes != defaults.maxBytes) request["maxBytes"] = query.maxBytes;
+}
+
+QByteArray encodeMessage(const QJsonObject& message) {
+    QByteArray line = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    return line;
+}
+
+bool decodeMessage(const QByteArray& line, QJsonObject& message) {
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+    message = doc.object();
+    return true;
+}
+
+}
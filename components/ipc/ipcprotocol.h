@@ -0,0 +1,63 @@
+// ipcprotocol.h
+#ifndef IPCPROTOCOL_H
+#define IPCPROTOCOL_H
+
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+#include "../storagemanager.h"
+#include "../entrycolumns.h"
+
+// 守护进程与客户端（界面、命令行、编辑器插件）之间的本地通信协议。
+// 每条消息为一行紧凑 JSON；一行也可以是请求数组（批量请求），按顺序逐条应答。
+//
+//   {"seq":1,"op":"hello"}                                    -> {"version":1}
+//   {"seq":2,"op":"page","before":0,"count":50,"preview":80}  -> {"entries":[...],"finished":false}
+//   {"seq":3,"op":"search","query":"foo","type":"text","before":0,"limit":100,
+//    "since":<毫秒时间戳>,"until":..,"minBytes":1048576,"maxBytes":..}   // 筛选条件均可省略
+//   {"seq":4,"op":"fetch","id":42,"chunk":65536}              -> {"size":N,"mime":"...","chunks":k}
+//   {"seq":5,"op":"copy","id":42}
+//   {"seq":6,"op":"subscribe"} / {"op":"unsubscribe"} / {"op":"clear"} / {"op":"save"}
+//   {"seq":7,"op":"trace","enable":true,"export":"/tmp/trace.json"}   -> {"enabled":true,"stages":[...]}
+//   {"seq":8,"op":"stats"}   -> {"memory":{"text":..,"total":..,"budget":..},
+//                               "capture":{"captured_per_sec":..,"coalesced_per_sec":..,...},
+//                               "retention":{"entries":..,"total_bytes":..,...},
+//                               "selection":{...}}   // 仅在开启 PRIMARY 选区捕获时出现
+//   {"seq":9,"op":"pinned"}                                   -> {"entries":[...]}   // 置顶条目
+//   {"seq":10,"op":"pin","id":42,"pinned":true}
+//   {"seq":11,"op":"remove","ids":[41,42]}                    -> {"removed":2}
+//   {"seq":12,"op":"remove","query":"foo","since":..}         // 无 ids 时按 search 的条件删除，置顶条目除外
+//
+// fetch 的应答之后紧跟 k 个数据帧：一行帧头 {"seq":4,"chunk":i,"bytes":n}，
+// 其后是 n 字节原始数据（不做 base64），按套接字写缓冲的消耗情况逐块发送；
+// 数据帧发完之前不会插入其他应答或事件。
+// 事件（订阅后推送）: {"event":"added","entry":{...}} / {"event":"cleared"} / {"event":"limit"}
+//                    {"event":"pinned","entry":{...,"pinned":true|false}}
+//                    {"event":"removed","ids":[...]}   // 保留策略或 remove 请求移除
+// 请求引起的事件排在该请求的应答之后发出。
+// 条目带 "pinned":true 表示置顶；置顶条目不计入数量上限，清空历史时保留
+namespace IpcProtocol {
+
+const int VERSION = 1;
+const int DEFAULT_CHUNK_SIZE = 64 * 1024;
+const int MAX_CHUNK_SIZE = 1024 * 1024;
+
+QString serverName();
+
+// previewLength > 0 时截断文本，并附带 length/truncated 字段
+QJsonObject entryToJson(const StorageManager::ClipboardData& entry, int previewLength = 0);
+StorageManager::ClipboardData entryFromJson(const QJsonObject& obj);
+
+// "text" / "image" / 其他 -> -1（不限类型）
+int typeFromString(const QString& type);
+
+// search 请求中的类型、时间和大小条件
+EntryColumns::Query queryFromJson(const QJsonObject& request);
+void queryToJson(const EntryColumns::Query& query, QJsonObject& request);
+
+QByteArray encodeMessage(const QJsonObject& message);
+bool decodeMessage(const QByteArray& line, QJsonObject& message);
+
+}
+
+#endif // IPCPROTOCOL_H
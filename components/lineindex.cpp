@@ -0,0 +1,39 @@
+// lineindex.cpp
+#include "lineindex.h"
+#include "tracer.h"
+#include <algorithm>
+
+LineIndex LineIndex::build(QStringView text) {
+    TRACE_SCOPE("lineIndex.build");
+    LineIndex index;
+    // 按平均 40 字符一行预留，避免频繁扩容
+    index.m_starts.reserve(text.size() / 40 + 1);
+    index.extend(text);
+    return index;
+}
+
+void LineIndex::extend(QStringView text) {
+    // 最后一行可能因追加而变长，从它的起点重新计算长度
+    qsizetype pos = m_starts.last();
+    qsizetype from = m_textLength;
+    while (true) {
+        qsizetype newline = text.indexOf(u'\n', from);
+        if (newline < 0) break;
+        m_maxLineLength = qMax(m_maxLineLength, newline - pos);
+        m_starts.append(newline + 1);
+        pos = from = newline + 1;
+    }
+    m_maxLineLength = qMax(m_maxLineLength, text.size() - pos);
+    m_textLength = text.size();
+}
+
+qsizetype LineIndex::lineLength(int line) const {
+    qsizetype start = m_starts.at(line);
+    qsizetype end = line + 1 < m_starts.size() ? m_starts.at(line + 1) - 1 : m_textLength;
+    return end - start;
+}
+
+int LineIndex::lineForOffset(qsizetype offset) const {
+    auto it = std::upper_bound(m_starts.begin(), m_starts.end(), offset);
+    return qMax(0, static_cast<int>(it - m_starts.begin()) - 1);
+}
@@ -0,0 +1,32 @@
+// lineindex.h
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <QList>
+#include <QStringView>
+
+// 文本的行起始偏移表：建立一次后按行号 O(1) 取行，按偏移二分查行号。
+// 换行扫描使用 QStringView::indexOf，Qt 内部对单字符查找做了 SIMD 加速。
+class LineIndex {
+public:
+    LineIndex() = default;
+
+    static LineIndex build(QStringView text);
+    // text 为原文本追加内容后的全文，只扫描新增部分（流式输出逐段追加时使用）
+    void extend(QStringView text);
+
+    int lineCount() const { return static_cast<int>(m_starts.size()); }
+    qsizetype lineStart(int line) const { return m_starts.at(line); }
+    // 不含换行符
+    qsizetype lineLength(int line) const;
+    int lineForOffset(qsizetype offset) const;
+    qsizetype maxLineLength() const { return m_maxLineLength; }
+    qsizetype textLength() const { return m_textLength; }
+
+private:
+    QList<qsizetype> m_starts{0};
+    qsizetype m_textLength = 0;
+    qsizetype m_maxLineLength = 0;
+};
+
+#endif // LINEINDEX_H
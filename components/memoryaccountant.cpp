@@ -0,0 +1,133 @@
+// memoryaccountant.cpp
+#include "memoryaccountant.h"
+#include <QCoreApplication>
+#include <QSettings>
+#include <QMetaObject>
+#include <QDebug>
+#include <algorithm>
+
+MemoryAccountant* MemoryAccountant::instance() {
+    // 不挂在 QCoreApplication 下：应用对象销毁后，其余静态对象析构时仍可安全记账
+    static MemoryAccountant accountant;
+    return &accountant;
+}
+
+MemoryAccountant::MemoryAccountant() {
+    for (auto& value : m_bytes) value.store(0);
+    // 首次使用可能在工作线程，回收始终排队到主线程执行
+    if (auto *app = QCoreApplication::instance()) moveToThread(app->thread());
+
+    // 预算可在配置文件中调整：[memory] budgetMB=256
+    QSettings settings;
+    m_budget.store(settings.value("memory/budgetMB", 256).toLongLong() * 1024 * 1024);
+}
+
+void MemoryAccountant::charge(Category category, qint64 bytes) {
+    if (bytes == 0) return;
+    m_bytes[category].fetch_add(bytes, std::memory_order_relaxed);
+    if (bytes > 0 && totalBytes() > budget()) {
+        scheduleEnforce();
+    }
+}
+
+void MemoryAccountant::set(Category category, qint64 bytes) {
+    m_bytes[category].store(bytes, std::memory_order_relaxed);
+    if (totalBytes() > budget()) {
+        scheduleEnforce();
+    }
+}
+
+qint64 MemoryAccountant::bytes(Category category) const {
+    return m_bytes[category].load(std::memory_order_relaxed);
+}
+
+qint64 MemoryAccountant::totalBytes() const {
+    qint64 total = 0;
+    for (const auto& value : m_bytes) total += value.load(std::memory_order_relaxed);
+    return total;
+}
+
+void MemoryAccountant::setBudget(qint64 bytes) {
+    m_budget.store(bytes, std::memory_order_relaxed);
+    if (totalBytes() > bytes) scheduleEnforce();
+}
+
+int MemoryAccountant::addReclaimer(int priority, Reclaimer reclaimer) {
+    QMutexLocker locker(&m_reclaimersMutex);
+    int id = m_nextReclaimerId++;
+    auto pos = std::upper_bound(m_reclaimers.begin(), m_reclaimers.end(), priority,
+                                [](int p, const Entry& e) { return p < e.priority; });
+    m_reclaimers.insert(pos, Entry{id, priority, std::move(reclaimer)});
+    return id;
+}
+
+void MemoryAccountant::removeReclaimer(int id) {
+    QMutexLocker locker(&m_reclaimersMutex);
+    m_reclaimers.erase(std::remove_if(m_reclaimers.begin(), m_reclaimers.end(),
+                                      [id](const Entry& e) { return e.id == id; }),
+                       m_reclaimers.end());
+}
+
+void MemoryAccountant::scheduleEnforce() {
+    // 记账可能发生在任意线程，回收统一排队到主线程执行，且同一时刻只排一次
+    bool expected = false;
+    if (m_enforceScheduled.compare_exchange_strong(expected, true)) {
+        QMetaObject::invokeMethod(this, &MemoryAccountant::enforceBudget, Qt::QueuedConnection);
+    }
+}
+
+void MemoryAccountant::enforceBudget() {
+    m_enforceScheduled.store(false);
+    if (m_enforcing) return;
+    m_enforcing = true;
+
+    qint64 over = totalBytes() - budget();
+    if (over > 0) {
+        emit budgetExceeded(totalBytes(), budget());
+        // 先记下 id，逐个在锁内确认仍已注册再调用：其他线程的注销会等到调用结束，
+        // 回收器不会在其所有者析构之后运行
+        QList<int> ids;
+        {
+            QMutexLocker locker(&m_reclaimersMutex);
+            ids.reserve(m_reclaimers.size());
+            for (const auto& entry : std::as_const(m_reclaimers)) ids.append(entry.id);
+        }
+        for (int id : std::as_const(ids)) {
+            QMutexLocker locker(&m_reclaimersMutex);
+            auto it = std::find_if(m_reclaimers.cbegin(), m_reclaimers.cend(),
+                                   [id](const Entry& e) { return e.id == id; });
+            if (it == m_reclaimers.cend()) continue;
+            // 回收器可能注销自己，先复制再调用
+            Reclaimer reclaimer = it->reclaimer;
+            over -= reclaimer(over);
+            if (over <= 0) break;
+        }
+        if (over > 0) {
+            qDebug() << "内存预算仍超出" << over / 1024 << "KB";
+        }
+    }
+
+    m_enforcing = false;
+}
+
+QString MemoryAccountant::categoryName(Category category) {
+    switch (category) {
+    case TextPayload: return "text";
+    case FullImage: return "images";
+    case Thumbnail: return "thumbnails";
+    case WidgetOverhead: return "widgets";
+    case Cache: return "caches";
+    case Pinned: return "pinned";
+    default: return "unknown";
+    }
+}
+
+QList<QPair<QString, qint64>> MemoryAccountant::stats() const {
+    QList<QPair<QString, qint64>> result;
+    for (int i = 0; i < CategoryCount; ++i) {
+        result.append({categoryName(static_cast<Category>(i)), bytes(static_cast<Category>(i))});
+    }
+    result.append({"total", totalBytes()});
+    result.append({"budget", budget()});
+    return result;
+}
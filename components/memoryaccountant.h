@@ -0,0 +1,82 @@
+// memoryaccountant.h
+#ifndef MEMORYACCOUNTANT_H
+#define MEMORYACCOUNTANT_H
+
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+// 进程内统一的内存记账：按类别统计字节数并执行全局预算。
+// 超出预算时在主线程依次调用已注册的回收器，把冷数据降级为仅磁盘句柄。
+class MemoryAccountant : public QObject {
+    Q_OBJECT
+public:
+    enum Category {
+        TextPayload,
+        FullImage,
+        Thumbnail,
+        WidgetOverhead,
+        Cache,
+        Pinned,
+        CategoryCount
+    };
+
+    // 回收器：尝试释放至少 bytesNeeded 字节，返回实际释放的字节数
+    using Reclaimer = std::function<qint64(qint64 bytesNeeded)>;
+
+    static MemoryAccountant* instance();
+
+    void charge(Category category, qint64 bytes);
+    void release(Category category, qint64 bytes) { charge(category, -bytes); }
+    void set(Category category, qint64 bytes);
+
+    qint64 bytes(Category category) const;
+    qint64 totalBytes() const;
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return m_budget.load(std::memory_order_relaxed); }
+
+    // priority 越小越先回收；返回值用于注销
+    int addReclaimer(int priority, Reclaimer reclaimer);
+    void removeReclaimer(int id);
+
+    // (类别名, 字节数) 以及 total / budget
+    QList<QPair<QString, qint64>> stats() const;
+    static QString categoryName(Category category);
+
+    static qint64 pixmapBytes(int width, int height, int depth = 32) {
+        return static_cast<qint64>(width) * height * depth / 8;
+    }
+
+public slots:
+    void enforceBudget();
+
+signals:
+    void budgetExceeded(qint64 totalBytes, qint64 budgetBytes);
+
+private:
+    MemoryAccountant();
+    void scheduleEnforce();
+
+    struct Entry {
+        int id;
+        int priority;
+        Reclaimer reclaimer;
+    };
+
+    std::atomic<qint64> m_bytes[CategoryCount];
+    std::atomic<qint64> m_budget;
+    std::atomic<bool> m_enforceScheduled{false};
+    // 回收器可在工作线程中注册、注销；调用回收器期间持有，注销会等到调用结束。
+    // 回收器自身可能注销（或注册）回收器，因此可重入
+    mutable QRecursiveMutex m_reclaimersMutex;
+    QList<Entry> m_reclaimers;
+    int m_nextReclaimerId = 1;
+    bool m_enforcing = false;
+};
+
+#endif // MEMORYACCOUNTANT_H
@@ -0,0 +1,170 @@
+// mimeextractor.cpp
+#include "mimeextractor.h"
+#include "tracer.h"
+#include <QGuiApplication>
+#include <QMimeData>
+#include <QElapsedTimer>
+#include <QBuffer>
+#include <QImageReader>
+#include <QSettings>
+#include <QTimer>
+
+namespace {
+const int MAX_BACKOFF_MS = 2000;
+}
+
+MimeExtractor::MimeExtractor(QClipboard::Mode mode, QObject *parent)
+    : QObject(parent)
+    , m_mode(mode)
+{
+    // [capture] maxTextKB=4096 maxImageMB=64 imageDeferMs=50 slowFetchMs=300
+    QSettings settings;
+    m_maxTextBytes = settings.value("capture/maxTextKB", 4096).toLongLong() * 1024;
+    m_maxImageBytes = settings.value("capture/maxImageMB", 64).toLongLong() * 1024 * 1024;
+    m_imageDeferMs = settings.value("capture/imageDeferMs", 50).toInt();
+    m_slowFetchMs = settings.value("capture/slowFetchMs", 300).toInt();
+}
+
+void MimeExtractor::start(quint64 generation) {
+    cancel();
+    m_generation = generation;
+    m_running = true;
+    schedule(Formats);
+}
+
+void MimeExtractor::cancel() {
+    ++m_token;
+    m_running = false;
+}
+
+void MimeExtractor::schedule(Stage stage, int delayMs) {
+    int token = m_token;
+    QTimer::singleShot(delayMs, this, [this, stage, token]() { run(stage, token); });
+}
+
+void MimeExtractor::run(Stage stage, int token) {
+    if (token != m_token) return;  // 已被取消或重新开始
+    switch (stage) {
+    case Formats: runFormats(); break;
+    case Image: runImage(); break;
+    case Text: runText(); break;
+    }
+}
+
+void MimeExtractor::runFormats() {
+    TRACE_SCOPE("mime.formats");
+    const QMimeData *mimeData = QGuiApplication::clipboard()->mimeData(m_mode);
+    if (!mimeData) {
+        finish();
+        return;
+    }
+
+    // 只查询格式列表，不传输任何数据
+    m_hasImage = m_imagesEnabled && mimeData->hasImage();
+    m_hasText = mimeData->hasText();
+
+    if (m_hasImage) {
+        // 图片延后读取，给后续变化留出取消的机会
+        schedule(Image, m_imageDeferMs + m_backoffMs);
+    } else if (m_hasText) {
+        schedule(Text);
+    } else {
+        finish();
+    }
+}
+
+void MimeExtractor::runImage() {
+    TRACE_SCOPE("mime.image");
+    const QMimeData *mimeData = QGuiApplication::clipboard()->mimeData(m_mode);
+    if (!mimeData) {
+        finish();
+        return;
+    }
+
+    // 上限按解码后的大小计算。提供 image/png 时只取编码字节、从文件头读出尺寸，
+    // 超限的图片不解码；其他格式只能由平台插件整体读取并解码后才知道大小
+    QElapsedTimer timer;
+    timer.start();
+    QImage image;
+    qint64 oversizedBytes = 0;
+    if (mimeData->hasFormat(QStringLiteral("image/png"))) {
+        QByteArray png = mimeData->data(QStringLiteral("image/png"));
+        noteFetchTime(timer.elapsed());
+        QBuffer buffer(&png);
+        QImageReader reader(&buffer, "PNG");
+        const QSize size = reader.size();
+        const qint64 decodedBytes = static_cast<qint64>(size.width()) * size.height() * 4;
+        if (size.isValid() && decodedBytes > m_maxImageBytes) {
+            oversizedBytes = decodedBytes;
+        } else {
+            image = reader.read();
+        }
+    }
+    if (image.isNull() && oversizedBytes == 0) {
+        timer.restart();
+        image = qvariant_cast<QImage>(mimeData->imageData());
+        noteFetchTime(timer.elapsed());
+        if (image.sizeInBytes() > m_maxImageBytes) {
+            oversizedBytes = image.sizeInBytes();
+            image = QImage();
+        }
+    }
+
+    if (!image.isNull()) {
+        quint64 generation = m_generation;
+        finish();
+        emit imageReady(generation, image);
+        return;
+    }
+
+    if (oversizedBytes > 0) {
+        emit skipped(m_generation, QString("图片过大: %1 MB").arg(oversizedBytes / (1024 * 1024)));
+    }
+    // 图片不可用时退回文本
+    if (m_hasText) {
+        schedule(Text);
+    } else {
+        finish();
+    }
+}
+
+void MimeExtractor::runText() {
+    TRACE_SCOPE("mime.text");
+    const QMimeData *mimeData = QGuiApplication::clipboard()->mimeData(m_mode);
+    if (!mimeData) {
+        finish();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QString text = mimeData->text();
+    noteFetchTime(timer.elapsed());
+
+    quint64 generation = m_generation;
+    finish();
+    if (text.size() * static_cast<qint64>(sizeof(QChar)) > m_maxTextBytes) {
+        emit skipped(generation, QString("文本过大: %1 KB").arg(text.size() * sizeof(QChar) / 1024));
+        return;
+    }
+    if (!text.isEmpty()) emit textReady(generation, text);
+}
+
+void MimeExtractor::finish() {
+    m_running = false;
+}
+
+void MimeExtractor::noteFetchTime(qint64 elapsedMs) {
+    // Qt 的剪贴板读取本身是同步的，无法中途打断；所有者响应慢时拉长后续图片的等待，
+    // 让连续变化在真正读取前被取消
+    if (elapsedMs > m_slowFetchMs) {
+        m_backoffMs = qMin(MAX_BACKOFF_MS, qMax(m_slowFetchMs, m_backoffMs * 2));
+        // 慢读取记入追踪，不再逐次输出调试信息
+        if (Tracer::isEnabled()) {
+            const qint64 durationNs = elapsedMs * 1000000;
+            Tracer::record("clipboard.fetch.slow", Tracer::nowNs() - durationNs, durationNs);
+        }
+    } else {
+        m_backoffMs /= 2;
+    }
+}
@@ -0,0 +1,58 @@
+// mimeextractor.h
+#ifndef MIMEEXTRACTOR_H
+#define MIMEEXTRACTOR_H
+
+#include <QObject>
+#include <QClipboard>
+#include <QImage>
+
+// 分阶段读取剪贴板内容：先记录可用格式，再按代价从低到高逐个读取。
+// 每个阶段之间都回到事件循环，剪贴板再次变化时取消尚未执行的阶段；
+// 图片等昂贵格式延后读取，读取过慢时进一步退避。
+class MimeExtractor : public QObject {
+    Q_OBJECT
+public:
+    explicit MimeExtractor(QClipboard::Mode mode = QClipboard::Clipboard, QObject *parent = nullptr);
+
+    void start(quint64 generation);
+    void cancel();
+    bool isRunning() const { return m_running; }
+
+    QClipboard::Mode mode() const { return m_mode; }
+    void setMaxTextBytes(qint64 bytes) { m_maxTextBytes = bytes; }
+    void setMaxImageBytes(qint64 bytes) { m_maxImageBytes = bytes; }
+    // 关闭后只读取文本（选区捕获使用）
+    void setImagesEnabled(bool enable) { m_imagesEnabled = enable; }
+
+signals:
+    void textReady(quint64 generation, const QString& text);
+    void imageReady(quint64 generation, const QImage& image);
+    void skipped(quint64 generation, const QString& reason);
+
+private:
+    enum Stage { Formats, Image, Text };
+
+    void schedule(Stage stage, int delayMs = 0);
+    void run(Stage stage, int token);
+    void runFormats();
+    void runImage();
+    void runText();
+    void finish();
+    void noteFetchTime(qint64 elapsedMs);
+
+    QClipboard::Mode m_mode;
+    quint64 m_generation = 0;
+    int m_token = 0;          // 取消时递增，已排队的阶段据此失效
+    bool m_running = false;
+    bool m_hasImage = false;
+    bool m_hasText = false;
+    bool m_imagesEnabled = true;
+
+    qint64 m_maxTextBytes;
+    qint64 m_maxImageBytes;
+    int m_imageDeferMs;
+    int m_slowFetchMs;
+    int m_backoffMs = 0;      // 剪贴板所有者响应慢时追加的延迟
+};
+
+#endif // MIMEEXTRACTOR_H
@@ -0,0 +1,65 @@
+// pagedecoder.cpp
+#include "pagedecoder.h"
+#include "tilestore.h"
+#include "tracer.h"
+#include <QtConcurrent>
+#include <QThreadPool>
+
+PageDecoder::PageDecoder(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcher<Item>::resultReadyAt, this, &PageDecoder::onResultReady);
+    connect(&m_watcher, &QFutureWatcher<Item>::finished, this, &PageDecoder::onFinished);
+}
+
+PageDecoder::~PageDecoder() {
+    cancel();
+}
+
+void PageDecoder::start(const QList<Item>& items) {
+    cancel();
+    m_pending.clear();
+    m_next = 0;
+
+    QSize thumbnailSize = m_thumbnailSize;
+    auto decode = [thumbnailSize](Item item) {
+        TRACE_SCOPE("decodeImage");
+        if (!item.imagePath.isEmpty()) {
+            item.image = TileStore::readImageFile(item.imagePath);
+            item.thumbnail = makeThumbnail(item.image, thumbnailSize);
+        }
+        return item;
+    };
+
+    QThreadPool *pool = m_pool ? m_pool : QThreadPool::globalInstance();
+    m_watcher.setFuture(QtConcurrent::mapped(pool, items, decode));
+}
+
+void PageDecoder::cancel() {
+    if (!m_watcher.isRunning()) return;
+    // 断开期间不再发布旧批次的结果
+    QSignalBlocker blocker(&m_watcher);
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+}
+
+void PageDecoder::onResultReady(int index) {
+    m_pending.insert(index, m_watcher.resultAt(index));
+    // 按顺序发布：只要下一条已完成就继续
+    while (!m_pending.isEmpty() && m_pending.firstKey() == m_next) {
+        emit decoded(m_pending.take(m_next));
+        ++m_next;
+    }
+}
+
+void PageDecoder::onFinished() {
+    m_pending.clear();
+    emit finished();
+}
+
+QImage PageDecoder::makeThumbnail(const QImage& image, const QSize& size) {
+    if (image.isNull()) return QImage();
+    // 先缩放到两倍大小再缩到目标大小，与列表中的显示效果一致
+    QImage thumbnail = image.scaled(size * 2, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    return thumbnail.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
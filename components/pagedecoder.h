@@ -0,0 +1,59 @@
+// pagedecoder.h
+#ifndef PAGEDECODER_H
+#define PAGEDECODER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QMap>
+#include <QSize>
+#include "storagemanager.h"
+
+class QThreadPool;
+
+// 并行解码一页历史：图片解码和缩略图生成分发到线程池，
+// 结果按原顺序逐条发布（前面的条目完成后立即发布，不必等整页结束）。
+// 工作线程只接触 QImage 和文件路径，QPixmap 由接收方在主线程创建。
+class PageDecoder : public QObject {
+    Q_OBJECT
+public:
+    using Entry = StorageManager::ClipboardData;
+
+    struct Item {
+        Entry entry;
+        QString imagePath;   // 文本条目为空
+        QImage image;
+        QImage thumbnail;
+    };
+
+    explicit PageDecoder(QObject *parent = nullptr);
+    ~PageDecoder() override;
+
+    // 默认使用全局线程池；基准测试可指定线程数
+    void setThreadPool(QThreadPool *pool) { m_pool = pool; }
+    void setThumbnailSize(const QSize& size) { m_thumbnailSize = size; }
+
+    // items 中已填好 entry 和 imagePath；上一批未完成时会被取消
+    void start(const QList<Item>& items);
+    void cancel();
+    bool isRunning() const { return m_watcher.isRunning(); }
+
+    static QImage makeThumbnail(const QImage& image, const QSize& size);
+
+signals:
+    void decoded(const PageDecoder::Item& item);
+    void finished();
+
+private slots:
+    void onResultReady(int index);
+    void onFinished();
+
+private:
+    QFutureWatcher<Item> m_watcher;
+    QThreadPool *m_pool = nullptr;
+    QSize m_thumbnailSize{200, 150};
+    QMap<int, Item> m_pending;   // 已完成但前面还有未完成的条目
+    int m_next = 0;
+};
+
+#endif // PAGEDECODER_H
@@ -0,0 +1,234 @@
+// prettyprinter.cpp
+#include "prettyprinter.h"
+
+namespace {
+
+const qsizetype DETECT_CHARS = 64 * 1024;
+
+QChar firstNonSpace(QStringView text, qsizetype from) {
+    for (qsizetype i = from; i < text.size(); ++i) {
+        if (!text.at(i).isSpace()) return text.at(i);
+    }
+    return QChar();
+}
+
+} // namespace
+
+PrettyPrinter::Format PrettyPrinter::detect(QStringView text) {
+    QStringView sample = text.left(DETECT_CHARS).trimmed();
+    if (sample.isEmpty()) return Plain;
+
+    QChar first = sample.front();
+    QChar second = firstNonSpace(sample, 1);
+    if (first == u'{') return Json;
+    // "[INFO] ..." 这类日志也以 [ 开头，要求后面是对象、数组或字符串
+    if (first == u'[' && (second == u'{' || second == u'[' || second == u'"' || second == u']')) return Json;
+    if (first == u'<' && (second.isLetter() || second == u'?' || second == u'!')) return Xml;
+
+    // 序列化过的日志/堆栈：字面量 \n 比真实换行多
+    qsizetype escaped = sample.count(u"\\n");
+    if (escaped >= 2 && escaped > sample.count(u'\n')) return Log;
+    return Plain;
+}
+
+QString PrettyPrinter::formatName(Format format) {
+    switch (format) {
+    case Json: return "JSON";
+    case Xml: return "XML";
+    case Log: return "日志";
+    default: return QString();
+    }
+}
+
+PrettyPrinter::PrettyPrinter(Format format, int indent)
+    : m_format(format)
+    , m_indent(indent)
+{
+}
+
+void PrettyPrinter::feed(QStringView chunk, QString& out) {
+    switch (m_format) {
+    case Json: feedJson(chunk, out); break;
+    case Xml: feedXml(chunk, out); break;
+    case Log: feedLog(chunk, out); break;
+    default: out.append(chunk); break;
+    }
+}
+
+void PrettyPrinter::finish(QString& out) {
+    if (m_format == Xml) {
+        if (m_inTag) {
+            newline(out);
+            out.append(m_tag);
+            m_tag.resize(0);
+            m_inTag = false;
+        } else {
+            flushXmlText(out);
+        }
+    } else if (m_format == Log && m_backslash) {
+        out.append(u'\\');
+        m_backslash = false;
+    }
+}
+
+void PrettyPrinter::newline(QString& out) {
+    if (!m_atStart) out.append(u'\n');
+    m_atStart = false;
+    out.resize(out.size() + m_depth * m_indent, u' ');
+}
+
+void PrettyPrinter::feedJson(QStringView chunk, QString& out) {
+    const qsizetype n = chunk.size();
+    qsizetype i = 0;
+    while (i < n) {
+        if (m_inString) {
+            if (m_escape) {
+                out.append(chunk.at(i++));
+                m_escape = false;
+                continue;
+            }
+            // 字符串内容整段复制
+            qsizetype j = i;
+            while (j < n && chunk.at(j) != u'"' && chunk.at(j) != u'\\') ++j;
+            out.append(chunk.mid(i, j - i));
+            if (j == n) break;
+            out.append(chunk.at(j));
+            if (chunk.at(j) == u'\\') {
+                m_escape = true;
+            } else {
+                m_inString = false;
+            }
+            i = j + 1;
+            continue;
+        }
+
+        QChar ch = chunk.at(i++);
+        if (ch.isSpace()) continue;
+        m_atStart = false;
+
+        if (ch == u'}' || ch == u']') {
+            m_depth = qMax(0, m_depth - 1);
+            if (!m_openPending) newline(out);
+            m_openPending = false;
+            out.append(ch);
+            continue;
+        }
+        if (m_openPending) {
+            newline(out);
+            m_openPending = false;
+        }
+        if (ch == u'{' || ch == u'[') {
+            out.append(ch);
+            ++m_depth;
+            m_openPending = true;
+        } else if (ch == u',') {
+            out.append(ch);
+            newline(out);
+        } else if (ch == u':') {
+            out.append(u": ");
+        } else {
+            out.append(ch);
+            if (ch == u'"') m_inString = true;
+        }
+    }
+}
+
+void PrettyPrinter::feedXml(QStringView chunk, QString& out) {
+    const qsizetype n = chunk.size();
+    qsizetype i = 0;
+    while (i < n) {
+        if (!m_inTag) {
+            qsizetype j = chunk.indexOf(u'<', i);
+            if (j < 0) {
+                m_text.append(chunk.mid(i));
+                break;
+            }
+            m_text.append(chunk.mid(i, j - i));
+            flushXmlText(out);
+            m_inTag = true;
+            m_tag.append(u'<');
+            i = j + 1;
+            continue;
+        }
+
+        QChar ch = chunk.at(i++);
+        m_tag.append(ch);
+        bool done = false;
+        if (m_tag.startsWith(u"<!--")) {
+            done = m_tag.size() >= 7 && m_tag.endsWith(u"-->");
+        } else if (m_tag.startsWith(u"<![CDATA[")) {
+            done = m_tag.endsWith(u"]]>");
+        } else if (!m_quote.isNull()) {
+            if (ch == m_quote) m_quote = QChar();
+        } else if (ch == u'"' || ch == u'\'') {
+            m_quote = ch;
+        } else {
+            done = ch == u'>';
+        }
+        if (done) {
+            emitXmlTag(out);
+            m_tag.resize(0);
+            m_inTag = false;
+        }
+    }
+}
+
+void PrettyPrinter::flushXmlText(QString& out) {
+    QStringView text = QStringView(m_text).trimmed();
+    if (!text.isEmpty()) {
+        // 只有文本的元素保持在一行：<name>value</name>
+        if (!m_leaf) newline(out);
+        out.append(text);
+    }
+    m_text.resize(0);
+}
+
+void PrettyPrinter::emitXmlTag(QString& out) {
+    if (m_tag.startsWith(u"</")) {
+        m_depth = qMax(0, m_depth - 1);
+        if (!m_leaf) newline(out);
+        out.append(m_tag);
+        m_leaf = false;
+    } else if (m_tag.endsWith(u"/>") || m_tag.startsWith(u"<?") || m_tag.startsWith(u"<!")) {
+        newline(out);
+        out.append(m_tag);
+        m_leaf = false;
+    } else {
+        newline(out);
+        out.append(m_tag);
+        ++m_depth;
+        m_leaf = true;
+    }
+}
+
+void PrettyPrinter::feedLog(QStringView chunk, QString& out) {
+    const qsizetype n = chunk.size();
+    qsizetype i = 0;
+    while (i < n) {
+        if (m_backslash) {
+            QChar ch = chunk.at(i++);
+            m_backslash = false;
+            if (ch == u'n') {
+                out.append(u'\n');
+            } else if (ch == u't') {
+                out.append(u'\t');
+            } else if (ch == u'r') {
+                // \r\n 只保留换行
+            } else if (ch == u'\\' || ch == u'"') {
+                out.append(ch);
+            } else {
+                out.append(u'\\');
+                out.append(ch);
+            }
+            continue;
+        }
+        qsizetype j = chunk.indexOf(u'\\', i);
+        if (j < 0) {
+            out.append(chunk.mid(i));
+            break;
+        }
+        out.append(chunk.mid(i, j - i));
+        m_backslash = true;
+        i = j + 1;
+    }
+}
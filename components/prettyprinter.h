@@ -0,0 +1,61 @@
+// prettyprinter.h
+#ifndef PRETTYPRINTER_H
+#define PRETTYPRINTER_H
+
+#include <QString>
+#include <QStringView>
+
+// 流式格式化器：输入可以在任意位置切分后逐段送入，每段的结果立即追加到输出，
+// 不建立 DOM，也不回看已经输出的内容。只保存嵌套深度和少量跨段状态，
+// 因此几十 MB 的文档可以边格式化边显示。输入不合法时尽力输出，不报错。
+class PrettyPrinter {
+public:
+    enum Format {
+        Plain,   // 无法识别，不做处理
+        Json,
+        Xml,
+        Log      // 单行日志/堆栈：展开字面量 \n、\t 转义
+    };
+
+    // 只看开头一段内容
+    static Format detect(QStringView text);
+    static QString formatName(Format format);
+
+    explicit PrettyPrinter(Format format, int indent = 2);
+
+    void feed(QStringView chunk, QString& out);
+    // 输入结束，输出尚未写出的缓冲内容
+    void finish(QString& out);
+
+    Format format() const { return m_format; }
+
+private:
+    void feedJson(QStringView chunk, QString& out);
+    void feedXml(QStringView chunk, QString& out);
+    void feedLog(QStringView chunk, QString& out);
+    void flushXmlText(QString& out);
+    void emitXmlTag(QString& out);
+    void newline(QString& out);
+
+    Format m_format;
+    int m_indent;
+    int m_depth = 0;
+    bool m_atStart = true;
+
+    // JSON
+    bool m_inString = false;
+    bool m_escape = false;
+    bool m_openPending = false;   // 刚输出 { 或 [，换行推迟到下一个字符，空容器保持 {} []
+
+    // XML
+    bool m_inTag = false;
+    bool m_leaf = false;          // 上一个开始标签之后还没有子元素
+    QString m_tag;                // 当前标签（含 < >），标签一般很短
+    QString m_text;               // 两个标签之间的文本，遇到 < 时整理输出
+    QChar m_quote;                // 属性值中的引号
+
+    // Log
+    bool m_backslash = false;     // 上一段以反斜杠结尾
+};
+
+#endif // PRETTYPRINTER_H
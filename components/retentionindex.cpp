@@ -0,0 +1,109 @@
+// retentionindex.cpp
+#include "retentionindex.h"
+#include <QSettings>
+
+RetentionIndex::Policy RetentionIndex::Policy::fromSettings() {
+    const qint64 MB = 1024 * 1024;
+    QSettings settings;
+    Policy policy;
+    policy.maxAgeSecs = settings.value("retention/maxAgeDays", 0).toLongLong() * 24 * 3600;
+    policy.maxTotalBytes = settings.value("retention/maxTotalMB", 0).toLongLong() * MB;
+    policy.maxTextBytes = settings.value("retention/maxTextMB", 0).toLongLong() * MB;
+    policy.maxImageBytes = settings.value("retention/maxImageMB", 0).toLongLong() * MB;
+    policy.largeEntryBytes = settings.value("retention/largeEntryMB", 0).toLongLong() * MB;
+    policy.maxLargeEntries = settings.value("retention/maxLargeEntries", 0).toInt();
+    return policy;
+}
+
+bool RetentionIndex::Policy::isEmpty() const {
+    return maxAgeSecs == 0 && maxTotalBytes == 0 && maxTextBytes == 0 &&
+           maxImageBytes == 0 && (largeEntryBytes == 0 || maxLargeEntries == 0);
+}
+
+void RetentionIndex::insert(quint64 id, int type, qint64 bytes, const QDateTime& timestamp) {
+    if (type < 0 || type >= TYPE_COUNT || contains(id)) return;
+
+    bool large = m_policy.largeEntryBytes > 0 && bytes > m_policy.largeEntryBytes;
+    m_byAge.emplace(id, Info{type, bytes, timestamp.toSecsSinceEpoch(), large});
+    m_byType[type].insert(id);
+    if (large) m_large.insert(id);
+    m_totalBytes += bytes;
+    m_typeBytes[type] += bytes;
+}
+
+void RetentionIndex::remove(quint64 id) {
+    auto it = m_byAge.find(id);
+    if (it != m_byAge.end()) erase(it);
+}
+
+void RetentionIndex::erase(std::map<quint64, Info>::iterator it) {
+    const Info& info = it->second;
+    m_byType[info.type].erase(it->first);
+    if (info.large) m_large.erase(it->first);
+    m_totalBytes -= info.bytes;
+    m_typeBytes[info.type] -= info.bytes;
+    m_byAge.erase(it);
+}
+
+void RetentionIndex::clear() {
+    m_byAge.clear();
+    for (auto& ids : m_byType) ids.clear();
+    m_large.clear();
+    m_totalBytes = 0;
+    m_typeBytes[0] = m_typeBytes[1] = 0;
+}
+
+void RetentionIndex::takeOldest(const std::set<quint64>& ids, QList<quint64>& out) {
+    // ids 在 erase 中会被修改，先取出 id 再删除
+    quint64 id = *ids.begin();
+    out.append(id);
+    remove(id);
+}
+
+QList<quint64> RetentionIndex::collectOverLimit() {
+    QList<quint64> removed;
+
+    if (m_policy.largeEntryBytes > 0 && m_policy.maxLargeEntries > 0) {
+        while (static_cast<int>(m_large.size()) > m_policy.maxLargeEntries) {
+            takeOldest(m_large, removed);
+        }
+    }
+
+    const qint64 typeLimits[TYPE_COUNT] = {m_policy.maxTextBytes, m_policy.maxImageBytes};
+    for (int type = 0; type < TYPE_COUNT; ++type) {
+        if (typeLimits[type] <= 0) continue;
+        while (m_typeBytes[type] > typeLimits[type] && !m_byType[type].empty()) {
+            takeOldest(m_byType[type], removed);
+        }
+    }
+
+    if (m_policy.maxTotalBytes > 0) {
+        while (m_totalBytes > m_policy.maxTotalBytes && !m_byAge.empty()) {
+            removed.append(m_byAge.begin()->first);
+            erase(m_byAge.begin());
+        }
+    }
+    return removed;
+}
+
+QList<quint64> RetentionIndex::collectExpired(const QDateTime& now) {
+    QList<quint64> removed;
+    if (m_policy.maxAgeSecs <= 0) return removed;
+
+    qint64 cutoff = now.toSecsSinceEpoch() - m_policy.maxAgeSecs;
+    while (!m_byAge.empty() && m_byAge.begin()->second.timestampSecs < cutoff) {
+        removed.append(m_byAge.begin()->first);
+        erase(m_byAge.begin());
+    }
+    return removed;
+}
+
+QList<QPair<QString, qint64>> RetentionIndex::stats() const {
+    return {
+        {"entries", static_cast<qint64>(m_byAge.size())},
+        {"total_bytes", m_totalBytes},
+        {"text_bytes", m_typeBytes[0]},
+        {"image_bytes", m_typeBytes[1]},
+        {"large_entries", static_cast<qint64>(m_large.size())},
+    };
+}
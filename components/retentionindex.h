@@ -0,0 +1,67 @@
+// retentionindex.h
+#ifndef RETENTIONINDEX_H
+#define RETENTIONINDEX_H
+
+#include <QDateTime>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <map>
+#include <set>
+
+// 按时间排序的保留策略索引：记录每条未置顶条目的大小和时间，
+// 每次插入后只从最旧的一端挑出超限条目，单次操作 O(log n)。
+// 挑出的条目同时从索引中删除，实际移除由调用方分批执行。
+class RetentionIndex {
+public:
+    // 各项为 0 表示不限制
+    struct Policy {
+        qint64 maxAgeSecs = 0;
+        qint64 maxTotalBytes = 0;
+        qint64 maxTextBytes = 0;
+        qint64 maxImageBytes = 0;
+        qint64 largeEntryBytes = 0;  // 超过此大小的条目计为大条目
+        int maxLargeEntries = 0;
+
+        // 配置项 [retention] maxAgeDays maxTotalMB maxTextMB maxImageMB largeEntryMB maxLargeEntries
+        static Policy fromSettings();
+        bool isEmpty() const;
+    };
+
+    void setPolicy(const Policy& policy) { m_policy = policy; }
+    const Policy& policy() const { return m_policy; }
+
+    // type 与 StorageManager::ClipboardData::Type 对应（0 文本，1 图片）
+    void insert(quint64 id, int type, qint64 bytes, const QDateTime& timestamp);
+    void remove(quint64 id);
+    void clear();
+    bool contains(quint64 id) const { return m_byAge.count(id) > 0; }
+
+    // 从最旧的条目开始挑出违反大小/数量限制的条目
+    QList<quint64> collectOverLimit();
+    // 挑出早于 now - maxAge 的条目
+    QList<quint64> collectExpired(const QDateTime& now);
+
+    QList<QPair<QString, qint64>> stats() const;
+
+private:
+    struct Info {
+        int type;
+        qint64 bytes;
+        qint64 timestampSecs;
+        bool large;
+    };
+    static const int TYPE_COUNT = 2;
+
+    void takeOldest(const std::set<quint64>& ids, QList<quint64>& out);
+    void erase(std::map<quint64, Info>::iterator it);
+
+    Policy m_policy;
+    std::map<quint64, Info> m_byAge;        // id 单调递增，即按捕获时间排序
+    std::set<quint64> m_byType[TYPE_COUNT];
+    std::set<quint64> m_large;
+    qint64 m_totalBytes = 0;
+    qint64 m_typeBytes[TYPE_COUNT] = {0, 0};
+};
+
+#endif // RETENTIONINDEX_H
@@ -0,0 +1,61 @@
+// startupprofiler.cpp
+#include "startupprofiler.h"
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+
+namespace {
+QElapsedTimer& processTimer() {
+    static QElapsedTimer timer;
+    return timer;
+}
+
+QList<QPair<QString, qint64>>& recordedPhases() {
+    static QList<QPair<QString, qint64>> list;
+    return list;
+}
+}
+
+void StartupProfiler::markProcessStart() {
+    processTimer().start();
+    recordedPhases().clear();
+    recordedPhases().append({"process_start", 0});
+}
+
+void StartupProfiler::mark(const QString& phase) {
+    if (!processTimer().isValid()) return;
+
+    for (const auto& recorded : recordedPhases()) {
+        if (recorded.first == phase) return;
+    }
+
+    qint64 elapsed = processTimer().elapsed();
+    recordedPhases().append({phase, elapsed});
+}
+
+QList<QPair<QString, qint64>> StartupProfiler::phases() {
+    return recordedPhases();
+}
+
+bool StartupProfiler::writeLog() {
+    QString dirPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir dir(dirPath);
+    if (!dir.exists() && !dir.mkpath(".")) return false;
+
+    QFile file(dirPath + "/startup.log");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        return false;
+    }
+
+    // 每次启动一行：时间戳 + 各阶段耗时(ms)
+    QTextStream stream(&file);
+    stream << QDateTime::currentDateTime().toString(Qt::ISODate);
+    for (const auto& phase : recordedPhases()) {
+        stream << ' ' << phase.first << '=' << phase.second;
+    }
+    stream << '\n';
+    return true;
+}
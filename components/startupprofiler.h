@@ -0,0 +1,25 @@
+// startupprofiler.h
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QString>
+#include <QList>
+#include <QPair>
+
+// 记录启动各阶段耗时（相对进程启动），用于跟踪启动性能回退
+class StartupProfiler {
+public:
+    // 应在 main() 最开始调用
+    static void markProcessStart();
+    // 记录一个阶段，同一阶段只记录第一次
+    static void mark(const QString& phase);
+    // 将本次启动的阶段耗时追加写入 startup.log
+    static bool writeLog();
+
+    static QList<QPair<QString, qint64>> phases();
+
+private:
+    StartupProfiler() = delete;
+};
+
+#endif // STARTUPPROFILER_H
@@ -1,5 +1,9 @@
 // storagemanager.cpp
 #include "storagemanager.h"
+#include "tracer.h"
+#include "memoryaccountant.h"
+#include "chunkstore.h"
+#include "tilestore.h"
 #include <QStandardPaths>
 #include <QDir>
 #include <QFile>
@@ -9,37 +13,82 @@
 #include <QBuffer>
 #include <QCryptographicHash>
 #include <QMutex>
+#include <QFileInfo>
 #include <QMutexLocker>
+#include <QSaveFile>
+#include <QImage>
+#include <QtConcurrent>
 
 struct StorageManager::Private {
     QString lastError;
     QMutex mutex;
     std::unique_ptr<QBuffer> imageBuffer;
+    QJsonArray index;  // 已解析但尚未解码的历史索引
+    QString rootPath;
+    std::unique_ptr<QSaveFile> writer;  // 流式写入历史索引，提交时原子替换
+    qint64 cacheCharged = 0;  // 已计入 MemoryAccountant 的缓存字节数
+    int reclaimerId = -1;
+    ChunkStore chunks;
+    TileStore tiles;
+    quint64 maxRemovedId = 0;  // 最近一次读取删除记录时得到
 };
 
 StorageManager::StorageManager(QObject *parent)
     : QObject(parent)
     , d(std::make_unique<Private>())
 {
+    d->rootPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     ensureDirectoryExists(getStoragePath());
     ensureDirectoryExists(getImagesPath());
+    d->chunks.setRoot(getChunksPath());
+    d->tiles.setRoot(getTilesPath());
     initializeCache();
+
+    // 内存超出预算时最先丢弃解码缓存，图片仍可从磁盘重新读取
+    d->reclaimerId = MemoryAccountant::instance()->addReclaimer(0, [this](qint64) {
+        QMutexLocker locker(&d->mutex);
+        qint64 before = d->cacheCharged;
+        m_imageCache.clear();
+        syncCacheAccounting();
+        return before;
+    });
 }
 
 StorageManager::~StorageManager() {
+    MemoryAccountant::instance()->removeReclaimer(d->reclaimerId);
     clearCache();
 }
 
+void StorageManager::syncCacheAccounting() {
+    qint64 bytes = static_cast<qint64>(m_imageCache.totalCost()) * 1024;
+    MemoryAccountant::instance()->charge(MemoryAccountant::Cache, bytes - d->cacheCharged);
+    d->cacheCharged = bytes;
+}
+
+void StorageManager::setStoragePath(const QString& path) {
+    QMutexLocker locker(&d->mutex);
+    d->rootPath = path;
+    d->index = QJsonArray();
+    m_imageCache.clear();
+    syncCacheAccounting();
+    ensureDirectoryExists(getStoragePath());
+    ensureDirectoryExists(getImagesPath());
+    d->chunks.setRoot(getChunksPath());
+    d->tiles.setRoot(getTilesPath());
+}
+
 void StorageManager::initializeCache() {
     m_imageCache.setMaxCost(DEFAULT_CACHE_SIZE * 1024); // 转换为KB
 }
 
 void StorageManager::setCacheSize(int megabytes) {
     m_imageCache.setMaxCost(megabytes * 1024);
+    syncCacheAccounting();
 }
 
 void StorageManager::clearCache() {
     m_imageCache.clear();
+    syncCacheAccounting();
     if (d->imageBuffer) {
         d->imageBuffer->close();
         d->imageBuffer.reset();
@@ -47,107 +96,239 @@ void StorageManager::clearCache() {
 }
 
 bool StorageManager::saveHistory(const QList<ClipboardData>& items) {
+    TRACE_SCOPE("saveHistory");
     QMutexLocker locker(&d->mutex); // 线程安全
 
-    QJsonArray jsonArray;
-    int count = 0;
-
     try {
+        if (!openWriter()) return false;
+
+        // 数量上限只统计未置顶的条目，置顶条目总是保留
+        int count = 0;
         for (const auto& item : items) {
-            if (count >= m_maxItems) break;
-
-            QJsonObject itemObj;
-            itemObj["type"] = (item.type == ClipboardData::Text) ? "text" : "image";
-            itemObj["timestamp"] = item.timestamp.toString(Qt::ISODate);
-
-            if (item.type == ClipboardData::Text) {
-                itemObj["text"] = item.text;
-            } else {
-                itemObj["hash"] = item.hash;
-                // 检查缓存中是否已有该图片
-                if (!m_imageCache.contains(item.hash)) {
-                    if (!saveImage(item.image, item.hash)) {
-                        continue;
-                    }
-                    // 保存到缓存
-                    auto* cachedImage = new QPixmap(item.image);
-                    m_imageCache.insert(item.hash, cachedImage,
-                                        (item.image.width() * item.image.height() * 4) / 1024); // 预估大小（KB）
-                }
+            if (item.pinned) {
+                appendRecord(item);
+            } else if (count < m_maxItems && appendRecord(item)) {
+                count++;
             }
-
-            jsonArray.append(itemObj);
-            count++;
         }
 
-        QJsonDocument doc(jsonArray);
-        QFile file(getStoragePath() + "/history.json");
+        return commitWriter();
+    } catch (const std::exception& e) {
+        d->writer.reset();
+        d->lastError = QString("保存历史记录时发生错误: %1").arg(e.what());
+        return false;
+    }
+}
+
+bool StorageManager::beginHistoryWrite() {
+    QMutexLocker locker(&d->mutex);
+    return openWriter();
+}
 
-        if (!file.open(QIODevice::WriteOnly)) {
-            d->lastError = "无法打开历史记录文件进行写入";
+bool StorageManager::writeHistoryEntry(const ClipboardData& item) {
+    QMutexLocker locker(&d->mutex);
+    return d->writer && appendRecord(item);
+}
+
+bool StorageManager::commitHistoryWrite() {
+    QMutexLocker locker(&d->mutex);
+    return commitWriter();
+}
+
+bool StorageManager::openWriter() {
+    d->writer = std::make_unique<QSaveFile>(historyFilePath());
+    if (!d->writer->open(QIODevice::WriteOnly)) {
+        d->lastError = "无法打开历史记录文件进行写入";
+        d->writer.reset();
+        return false;
+    }
+    return true;
+}
+
+bool StorageManager::appendRecord(const ClipboardData& item) {
+    if (item.type == ClipboardData::Image && !hasImage(item.hash)) {
+        // 图片文件已存在（捕获时已写入）则无需重新编码
+        if (item.image.isNull() || !saveImage(item.image, item.hash)) {
             return false;
         }
+    }
+
+    // 每行一条记录，读取时可以逐行流式解析
+    QByteArray line = QJsonDocument(toRecord(item)).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    return d->writer->write(line) == line.size();
+}
+
+bool StorageManager::commitWriter() {
+    if (!d->writer) return false;
+    bool ok = d->writer->commit();
+    d->writer.reset();
+    if (!ok) {
+        d->lastError = "写入历史记录文件失败";
+        return false;
+    }
+    // 新格式写入成功后移除旧版本文件；已删除的记录不在新文件中，删除记录一并清空
+    QFile::remove(legacyHistoryFilePath());
+    QFile::remove(tombstonesFilePath());
+    return true;
+}
+
+QJsonObject StorageManager::toRecord(const ClipboardData& item) {
+    QJsonObject itemObj;
+    itemObj["id"] = static_cast<qint64>(item.id);
+    itemObj["type"] = (item.type == ClipboardData::Text) ? "text" : "image";
+    // 读取时优先用毫秒时间戳，ISO 字符串保留给旧版本和外部工具
+    itemObj["timestamp"] = item.timestamp.toString(Qt::ISODate);
+    itemObj["ts"] = item.timestamp.toMSecsSinceEpoch();
+    if (item.bytes > 0) itemObj["bytes"] = item.bytes;
+    if (item.pinned) itemObj["pinned"] = true;
+
+    if (item.type == ClipboardData::Text) {
+        itemObj["text"] = item.text;
+        if (item.isChunked()) {
+            itemObj["chunks"] = QJsonArray::fromStringList(item.chunks);
+            itemObj["length"] = item.textLength;
+        }
+    } else {
+        itemObj["hash"] = item.hash;
+    }
+    return itemObj;
+}
 
-        file.write(doc.toJson(QJsonDocument::Compact)); // 使用压缩格式
+bool StorageManager::appendTombstones(const QList<quint64>& ids) {
+    if (ids.isEmpty()) return true;
+    QMutexLocker locker(&d->mutex);
+    QJsonArray array;
+    for (quint64 id : ids) {
+        array.append(static_cast<qint64>(id));
+        d->maxRemovedId = qMax(d->maxRemovedId, id);
+    }
+    QByteArray line = QJsonDocument(QJsonObject{{"removed", array}}).toJson(QJsonDocument::Compact);
+    line.append('\n');
+
+    QFile file(tombstonesFilePath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append) || file.write(line) != line.size()) {
+        d->lastError = "无法写入删除记录: " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+quint64 StorageManager::maxRemovedId() const {
+    return d->maxRemovedId;
+}
+
+QSet<quint64> StorageManager::readTombstones() const {
+    QSet<quint64> ids;
+    QFile file(tombstonesFilePath());
+    if (!file.open(QIODevice::ReadOnly)) return ids;
+    while (!file.atEnd()) {
+        QJsonDocument doc = QJsonDocument::fromJson(file.readLine());
+        const QJsonArray removed = doc.object()["removed"].toArray();
+        for (const auto& value : removed) {
+            quint64 id = static_cast<quint64>(value.toInteger());
+            ids.insert(id);
+            d->maxRemovedId = qMax(d->maxRemovedId, id);
+        }
+    }
+    return ids;
+}
+
+bool StorageManager::forEachRecord(const std::function<bool(const QJsonObject&)>& rawCallback) {
+    // 跳过已删除（尚未随完整写入清理掉）的记录
+    const QSet<quint64> removed = readTombstones();
+    auto callback = [&](const QJsonObject& obj) {
+        if (!removed.isEmpty() && removed.contains(static_cast<quint64>(obj["id"].toInteger()))) return true;
+        return rawCallback(obj);
+    };
+
+    QFile file(historyFilePath());
+    if (file.open(QIODevice::ReadOnly)) {
+        while (!file.atEnd()) {
+            QByteArray line = file.readLine();
+            if (line.trimmed().isEmpty()) continue;
+
+            QJsonParseError error;
+            QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+            if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+                continue; // 跳过损坏的行，不影响其余记录
+            }
+            if (!callback(doc.object())) break;
+        }
         return true;
-    } catch (const std::exception& e) {
-        d->lastError = QString("保存历史记录时发生错误: %1").arg(e.what());
+    }
+
+    // 兼容旧版本的 history.json（整体为一个 JSON 数组）
+    QFile legacy(legacyHistoryFilePath());
+    if (!legacy.open(QIODevice::ReadOnly)) {
+        d->lastError = "无法打开历史记录文件";
+        return false;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(legacy.readAll());
+    if (doc.isNull()) {
+        d->lastError = "历史记录文件格式错误";
         return false;
     }
+
+    const QJsonArray array = doc.array();
+    for (const auto& value : array) {
+        if (!callback(value.toObject())) break;
+    }
+    return true;
+}
+
+bool StorageManager::readHistory(const std::function<bool(const ClipboardData&)>& callback, bool decodeImages) {
+    QMutexLocker locker(&d->mutex); // 线程安全
+
+    return forEachRecord([&](const QJsonObject& obj) {
+        ClipboardData item;
+        if (!parseItem(obj, item, decodeImages)) return true;
+        return callback(item);
+    });
 }
 
 QList<StorageManager::ClipboardData> StorageManager::loadHistory() {
+    int total = loadIndex();
+    return loadPage(0, total);
+}
+
+int StorageManager::loadIndex() {
+    TRACE_SCOPE("loadHistory.index");
     QMutexLocker locker(&d->mutex); // 线程安全
 
-    QList<ClipboardData> items;
-    QFile file(getStoragePath() + "/history.json");
+    d->index = QJsonArray();
+    forEachRecord([this](const QJsonObject& obj) {
+        d->index.append(obj);
+        return true;
+    });
+    return d->index.size();
+}
 
-    try {
-        if (!file.open(QIODevice::ReadOnly)) {
-            d->lastError = "无法打开历史记录文件";
-            return items;
-        }
+int StorageManager::indexSize() const {
+    return d->index.size();
+}
 
-        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-        if (doc.isNull()) {
-            d->lastError = "历史记录文件格式错误";
-            return items;
-        }
+QList<StorageManager::ClipboardData> StorageManager::loadPage(int offset, int count, bool decodeImages) {
+    TRACE_SCOPE("loadHistory.page");
+    QMutexLocker locker(&d->mutex); // 线程安全
 
-        QJsonArray array = doc.array();
-        items.reserve(array.size()); // 预分配空间
+    QList<ClipboardData> items;
+    int end = qMin(offset + count, static_cast<int>(d->index.size()));
+    if (offset < 0 || offset >= end) return items;
 
-        for (const auto& value : array) {
-            QJsonObject obj = value.toObject();
-            ClipboardData item;
+    try {
+        items.reserve(end - offset); // 预分配空间
 
-            item.timestamp = QDateTime::fromString(obj["timestamp"].toString(), Qt::ISODate);
-            if (obj["type"].toString() == "text") {
-                item.type = ClipboardData::Text;
-                item.text = obj["text"].toString();
-            } else {
-                item.type = ClipboardData::Image;
-                item.hash = obj["hash"].toString();
-
-                // 先从缓存加载
-                if (auto* cachedImage = m_imageCache.object(item.hash)) {
-                    item.image = *cachedImage;
-                } else {
-                    item.image = loadImage(item.hash);
-                    if (!item.image.isNull()) {
-                        // 添加到缓存
-                        auto* newImage = new QPixmap(item.image);
-                        m_imageCache.insert(item.hash, newImage,
-                                            (item.image.width() * item.image.height() * 4) / 1024);
-                    } else {
-                        continue;
-                    }
-                }
+        // 先解析索引，图片统一在后面并行解码
+        for (int i = offset; i < end; ++i) {
+            ClipboardData item;
+            if (parseItem(d->index.at(i).toObject(), item, false)) {
+                items.append(std::move(item)); // 使用移动语义
             }
-
-            items.append(std::move(item)); // 使用移动语义
         }
 
+        if (decodeImages) decodePage(items);
         return items;
     } catch (const std::exception& e) {
         d->lastError = QString("加载历史记录时发生错误: %1").arg(e.what());
@@ -155,6 +336,98 @@ QList<StorageManager::ClipboardData> StorageManager::loadHistory() {
     }
 }
 
+bool StorageManager::parseItem(const QJsonObject& obj, ClipboardData& item, bool decodeImages) {
+    item.id = static_cast<quint64>(obj["id"].toInteger());
+    // 新记录带毫秒时间戳，免去逐条解析 ISO 字符串
+    const QJsonValue ts = obj["ts"];
+    item.timestamp = ts.isDouble() ? QDateTime::fromMSecsSinceEpoch(ts.toInteger())
+                                   : QDateTime::fromString(obj["timestamp"].toString(), Qt::ISODate);
+    item.bytes = obj["bytes"].toInteger();
+    item.pinned = obj["pinned"].toBool();
+    if (obj["type"].toString() == "text") {
+        item.type = ClipboardData::Text;
+        item.text = obj["text"].toString();
+        if (obj.contains("chunks")) {
+            const QJsonArray chunks = obj["chunks"].toArray();
+            for (const auto& id : chunks) item.chunks.append(id.toString());
+            item.textLength = obj["length"].toInteger();
+        }
+        return true;
+    }
+
+    item.type = ClipboardData::Image;
+    item.hash = obj["hash"].toString();
+
+    // 只解析索引时保留磁盘句柄，图片在需要显示时再解码
+    if (!decodeImages) {
+        return hasImage(item.hash);
+    }
+
+    // 先从缓存加载
+    if (auto* cachedImage = m_imageCache.object(item.hash)) {
+        item.image = *cachedImage;
+        return true;
+    }
+
+    item.image = loadImage(item.hash);
+    if (item.image.isNull()) {
+        return false;
+    }
+
+    // 添加到缓存
+    auto* newImage = new QPixmap(item.image);
+    m_imageCache.insert(item.hash, newImage,
+                        (item.image.width() * item.image.height() * 4) / 1024);
+    syncCacheAccounting();
+    return true;
+}
+
+void StorageManager::decodePage(QList<ClipboardData>& items) {
+    // 缓存未命中的图片分发到线程池解码（工作线程只处理 QImage），
+    // 再回到当前线程转换为 QPixmap 并写入缓存
+    QList<int> misses;
+    for (int i = 0; i < items.size(); ++i) {
+        ClipboardData& item = items[i];
+        if (item.type != ClipboardData::Image) continue;
+        if (auto* cachedImage = m_imageCache.object(item.hash)) {
+            item.image = *cachedImage;
+        } else {
+            misses.append(i);
+        }
+    }
+
+    QStringList paths;
+    paths.reserve(misses.size());
+    for (int i : misses) paths.append(imagePath(items.at(i).hash));
+    const QList<QImage> decoded = QtConcurrent::blockingMapped(paths, [](const QString& path) {
+        TRACE_SCOPE("decodeImage");
+        return TileStore::readImageFile(path);
+    });
+
+    QList<bool> failed(items.size(), false);
+    for (int k = 0; k < misses.size(); ++k) {
+        ClipboardData& item = items[misses.at(k)];
+        if (decoded.at(k).isNull()) {
+            failed[misses.at(k)] = true;
+            continue;
+        }
+        item.image = QPixmap::fromImage(decoded.at(k));
+        m_imageCache.insert(item.hash, new QPixmap(item.image),
+                            (item.image.width() * item.image.height() * 4) / 1024);
+    }
+    syncCacheAccounting();
+
+    // 解码失败的图片条目与之前一样跳过
+    if (failed.contains(true)) {
+        QList<ClipboardData> kept;
+        kept.reserve(items.size());
+        for (int i = 0; i < items.size(); ++i) {
+            if (!failed.at(i)) kept.append(std::move(items[i]));
+        }
+        items = std::move(kept);
+    }
+}
+
 bool StorageManager::saveImage(const QPixmap& image, const QString& hash) const {
     if (!d->imageBuffer) {
         d->imageBuffer = std::make_unique<QBuffer>();
@@ -167,7 +440,7 @@ bool StorageManager::saveImage(const QPixmap& image, const QString& hash) const
         return false;
     }
 
-    QFile file(getImagesPath() + "/" + hash + ".png");
+    QFile file(pngPath(hash));
     if (!file.open(QIODevice::WriteOnly)) {
         return false;
     }
@@ -177,14 +450,96 @@ bool StorageManager::saveImage(const QPixmap& image, const QString& hash) const
     return true;
 }
 
+bool StorageManager::saveImageData(const QString& hash, const QByteArray& pngData) {
+    QFile file(pngPath(hash));
+    if (!file.open(QIODevice::WriteOnly)) {
+        d->lastError = "无法写入图片文件: " + file.errorString();
+        return false;
+    }
+    return file.write(pngData) == pngData.size();
+}
+
+bool StorageManager::hasImage(const QString& hash) const {
+    return !hash.isEmpty() && QFile::exists(imagePath(hash));
+}
+
+QString StorageManager::pngPath(const QString& hash) const {
+    return getImagesPath() + "/" + hash + ".png";
+}
+
+QString StorageManager::tileMapPath(const QString& hash) const {
+    return getImagesPath() + "/" + hash + ".tiles";
+}
+
+QString StorageManager::imagePath(const QString& hash) const {
+    QString path = pngPath(hash);
+    if (QFile::exists(path)) return path;
+    QString mapPath = tileMapPath(hash);
+    return QFile::exists(mapPath) ? mapPath : path;
+}
+
 QPixmap StorageManager::loadImage(const QString& hash) const {
-    QPixmap image;
-    QString path = getImagesPath() + "/" + hash + ".png";
+    return QPixmap::fromImage(readImage(hash));
+}
+
+QImage StorageManager::readImage(const QString& hash) const {
+    QString path = imagePath(hash);
+    return QFile::exists(path) ? TileStore::readImageFile(path) : QImage();
+}
+
+QByteArray StorageManager::loadImageData(const QString& hash) const {
+    QString path = imagePath(hash);
+    if (!TileStore::isMapPath(path)) {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+    // 分块存放的图片重建后再编码
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    QImage image = TileStore::load(path);
+    if (image.isNull() || !image.save(&buffer, "PNG")) return QByteArray();
+    return png;
+}
+
+qint64 StorageManager::imageBytes(const QString& hash) const {
+    QString path = imagePath(hash);
+    if (!TileStore::isMapPath(path)) return QFileInfo(path).size();
+    qint64 bytes = 0;
+    TileStore::tiles(path, &bytes);
+    return bytes;
+}
+
+bool StorageManager::shouldTile(const QImage& image) const {
+    return m_tileImages && qint64(image.width()) * image.height() >= TILE_MIN_PIXELS;
+}
+
+QStringList StorageManager::tileImage(const QString& hash, const QImage& image, QString *error) {
+    return d->tiles.store(tileMapPath(hash), image, error);
+}
 
-    if (QFile::exists(path)) {
-        image.load(path, "PNG");
+void StorageManager::releaseTiles(const QStringList& ids) {
+    d->tiles.release(ids);
+}
+
+void StorageManager::removeImages(const QSet<QString>& hashes, const QSet<QString>& keep) {
+    QSet<QString> tiles;
+    for (const auto& hash : hashes) {
+        QString mapPath = tileMapPath(hash);
+        for (const auto& id : TileStore::tiles(mapPath)) tiles.insert(id);
+        QFile::remove(mapPath);
+        QFile::remove(pngPath(hash));
+    }
+    if (tiles.isEmpty()) return;
+    // 块可能被其他截图共用，仍有图片引用的保留
+    for (const auto& hash : keep) {
+        for (const auto& id : TileStore::tiles(tileMapPath(hash))) tiles.remove(id);
     }
-    return image;
+    d->tiles.remove(tiles);
+}
+
+QList<QPair<QString, qint64>> StorageManager::tileStats() const {
+    return d->tiles.stats();
 }
 
 QString StorageManager::getLastError() const {
@@ -192,13 +547,102 @@ QString StorageManager::getLastError() const {
 }
 
 QString StorageManager::getStoragePath() const {
-    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return d->rootPath;
+}
+
+QString StorageManager::historyFilePath() const {
+    return getStoragePath() + "/history.jsonl";
+}
+
+QString StorageManager::tombstonesFilePath() const {
+    return getStoragePath() + "/history.tombstones";
+}
+
+QString StorageManager::legacyHistoryFilePath() const {
+    return getStoragePath() + "/history.json";
+}
+
+bool StorageManager::importImage(const StorageManager& source, const QString& hash) {
+    if (hasImage(hash)) return true;
+    QString sourcePath = source.imagePath(hash);
+    if (TileStore::isMapPath(sourcePath)) {
+        // 先复制块再复制映射，映射存在即说明图片完整
+        if (!d->tiles.import(source.d->tiles, TileStore::tiles(sourcePath)) ||
+            !QFile::copy(sourcePath, tileMapPath(hash))) {
+            d->lastError = "无法复制图片块: " + sourcePath;
+            return false;
+        }
+        return true;
+    }
+    if (!QFile::copy(sourcePath, pngPath(hash))) {
+        d->lastError = "无法复制图片文件: " + sourcePath;
+        return false;
+    }
+    return true;
 }
 
 QString StorageManager::getImagesPath() const {
     return getStoragePath() + "/images";
 }
 
+QString StorageManager::getChunksPath() const {
+    return getStoragePath() + "/chunks";
+}
+
+QString StorageManager::getTilesPath() const {
+    return getStoragePath() + "/tiles";
+}
+
+bool StorageManager::shouldChunk(const ClipboardData& item) const {
+    return item.type == ClipboardData::Text && !item.isChunked() &&
+           m_chunkThreshold > 0 && item.text.size() >= m_chunkThreshold;
+}
+
+bool StorageManager::chunkText(ClipboardData& item, QString *error) {
+    QStringList ids = d->chunks.store(item.text.toUtf8(), error);
+    if (ids.isEmpty()) return false;
+    item.chunks = ids;
+    item.textLength = item.text.size();
+    item.text = item.text.left(TEXT_PREVIEW_CHARS);
+    return true;
+}
+
+void StorageManager::releaseChunks(const QStringList& ids) {
+    d->chunks.release(ids);
+}
+
+void StorageManager::removeChunks(const QSet<QString>& ids) {
+    d->chunks.remove(ids);
+}
+
+bool StorageManager::importChunks(const StorageManager& source, const QStringList& ids) {
+    if (!d->chunks.import(source.d->chunks, ids)) {
+        d->lastError = "无法复制数据块";
+        return false;
+    }
+    return true;
+}
+
+QByteArray StorageManager::loadTextData(const ClipboardData& item) const {
+    if (!item.isChunked()) return item.text.toUtf8();
+    // 块按字节切分，拼接后就是完整的 UTF-8
+    bool ok = false;
+    QByteArray data = d->chunks.load(item.chunks, &ok);
+    return ok ? data : item.text.toUtf8();
+}
+
+QString StorageManager::loadText(const ClipboardData& item) const {
+    if (!item.isChunked()) return item.text;
+    bool ok = false;
+    QByteArray data = d->chunks.load(item.chunks, &ok);
+    // 块缺失时退回预览，不返回空文本
+    return ok ? QString::fromUtf8(data) : item.text;
+}
+
+QList<QPair<QString, qint64>> StorageManager::chunkStats() const {
+    return d->chunks.stats();
+}
+
 bool StorageManager::ensureDirectoryExists(const QString& path) const {
     QDir dir(path);
     return dir.exists() || dir.mkpath(".");
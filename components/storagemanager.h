@@ -6,19 +6,39 @@
 #include <QPixmap>
 #include <QDateTime>
 #include <QList>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
 #include <memory>
 #include <QCache>
+#include <functional>
+
+class QJsonObject;
 
 
 class StorageManager : public QObject {
     Q_OBJECT
 public:
     struct ClipboardData {
-        enum Type { Text, Image } type;
+        enum Type { Text, Image } type = Text;
+        quint64 id = 0;  // 单调递增，越新越大
         QString text;
-        QPixmap image;
+        QPixmap image;   // 为空时表示仅有磁盘句柄（按 hash 读取）
         QDateTime timestamp;
         QString hash;  // For images only
+        bool pinned = false;  // 置顶条目不受数量上限裁剪
+        // 大文本按内容分块存放（ChunkStore），text 只保留开头的预览，完整内容用 loadText 读取
+        QStringList chunks;
+        qint64 textLength = 0;  // 分块文本的完整字符数
+        qint64 bytes = 0;       // 载荷大小：文本按 UTF-16 计，图片为磁盘占用；0 表示未知
+
+        bool isChunked() const { return !chunks.isEmpty(); }
+        // 搜索匹配：文本按子串（不区分大小写），分块文本只匹配预览，不从磁盘重组；
+        // 图片按 hash 前缀。后台搜索与命令行直接读取共用，结果一致
+        bool matchesQuery(const QString& query) const {
+            if (type != Text) return hash.startsWith(query);
+            return text.contains(query, Qt::CaseInsensitive);
+        }
     };
 
     explicit StorageManager(QObject *parent = nullptr);
@@ -28,8 +48,70 @@ public:
     StorageManager(const StorageManager&) = delete;
     StorageManager& operator=(const StorageManager&) = delete;
 
+    // 存储目录，默认为 AppDataLocation
+    void setStoragePath(const QString& path);
+    QString getStoragePath() const;
+    QString getChunksPath() const;  // 分块文本目录，工作线程可用 ChunkStore 直接读取
+    QString historyFilePath() const;
+
     bool saveHistory(const QList<ClipboardData>& items);
     QList<ClipboardData> loadHistory();
+
+    // 流式读取：逐条回调，内存占用与历史条数无关；回调返回 false 时停止。
+    // 回调期间持有内部锁，不要在回调中访问同一个实例
+    bool readHistory(const std::function<bool(const ClipboardData&)>& callback, bool decodeImages = false);
+
+    // 删除记录：只向 history.tombstones 追加一行被删除的 id，不重写历史文件；
+    // 读取时跳过这些 id，下次完整写入历史文件后清空
+    bool appendTombstones(const QList<quint64>& ids);
+    // 已删除记录中最大的 id，分配新 id 时要越过它，避免被旧的删除记录遮住
+    quint64 maxRemovedId() const;
+
+    // 流式写入：begin 之后逐条写入，commit 时原子替换历史文件
+    bool beginHistoryWrite();
+    bool writeHistoryEntry(const ClipboardData& item);
+    bool commitHistoryWrite();
+
+    // 分段加载：先解析索引（不解码图片），再按页解码条目
+    int loadIndex();
+    QList<ClipboardData> loadPage(int offset, int count, bool decodeImages = true);
+    int indexSize() const;
+
+    // 图片文件按 hash 存放在 images/ 下：PNG，或分块存放时的块映射（.tiles）
+    bool hasImage(const QString& hash) const;
+    bool saveImageData(const QString& hash, const QByteArray& pngData);
+    QPixmap loadImage(const QString& hash) const;
+    QImage readImage(const QString& hash) const;  // 可在工作线程中调用
+    // 两种形式之一的路径，用 TileStore::readImageFile 读取
+    QString imagePath(const QString& hash) const;
+    QByteArray loadImageData(const QString& hash) const;  // PNG 字节
+    qint64 imageBytes(const QString& hash) const;         // 磁盘占用
+    bool importImage(const StorageManager& source, const QString& hash);
+    // 删除图片及不再被 keep 中图片引用的块
+    void removeImages(const QSet<QString>& hashes, const QSet<QString>& keep);
+
+    // 大图（配置项 storage/tileImages）按像素块去重存放在 tiles/ 下
+    void setTileImages(bool enable) { m_tileImages = enable; }
+    bool shouldTile(const QImage& image) const;
+    // 可在工作线程中调用；返回的块在 releaseTiles 之前不会被删除
+    QStringList tileImage(const QString& hash, const QImage& image, QString *error = nullptr);
+    void releaseTiles(const QStringList& ids);
+    QList<QPair<QString, qint64>> tileStats() const;
+
+    // 超过阈值（字符数，0 为关闭）的文本写入 chunks/ 下的分块存储
+    void setChunkThreshold(qsizetype chars) { m_chunkThreshold = chars; }
+    bool shouldChunk(const ClipboardData& item) const;
+    // 可在工作线程中调用。成功后 item.text 只保留预览；
+    // 返回的块在 releaseChunks 之前不会被 removeChunks 删除
+    bool chunkText(ClipboardData& item, QString *error = nullptr);
+    void releaseChunks(const QStringList& ids);
+    void removeChunks(const QSet<QString>& ids);
+    bool importChunks(const StorageManager& source, const QStringList& ids);
+    // 完整文本：未分块时即为 item.text
+    QString loadText(const ClipboardData& item) const;
+    QByteArray loadTextData(const ClipboardData& item) const;  // UTF-8
+    QList<QPair<QString, qint64>> chunkStats() const;
+
     QString getLastError() const;
     void setStorageLimit(int maxItems) { m_maxItems = maxItems; }
     void setCacheSize(int megabytes);
@@ -39,17 +121,38 @@ private:
     struct Private;
     std::unique_ptr<Private> d;  // PIMPL模式
 
-    QString getStoragePath() const;
+    QString legacyHistoryFilePath() const;
+    QString tombstonesFilePath() const;
+    QSet<quint64> readTombstones() const;
     QString getImagesPath() const;
+    QString getTilesPath() const;
+    QString pngPath(const QString& hash) const;
+    QString tileMapPath(const QString& hash) const;
     bool ensureDirectoryExists(const QString& path) const;
     bool saveImage(const QPixmap& image, const QString& hash) const;
-    QPixmap loadImage(const QString& hash) const;
+    bool parseItem(const QJsonObject& obj, ClipboardData& item, bool decodeImages);
+    bool forEachRecord(const std::function<bool(const QJsonObject&)>& callback);
+    static QJsonObject toRecord(const ClipboardData& item);
+    bool openWriter();
+    bool appendRecord(const ClipboardData& item);
+    bool commitWriter();
     void initializeCache();
+    void syncCacheAccounting();
+    void decodePage(QList<ClipboardData>& items);
 
     // 缓存相关
     static const int DEFAULT_CACHE_SIZE = 50; // MB
     QCache<QString, QPixmap> m_imageCache;
     int m_maxItems = 100;
+
+    // 分块存储
+    static const int TEXT_PREVIEW_CHARS = 4096;  // 记录和内存中保留的预览长度
+    qsizetype m_chunkThreshold = 64 * 1024;
+    static const int TILE_MIN_PIXELS = 256 * 256;  // 更小的图片直接存 PNG
+    bool m_tileImages = true;
 };
 
+// 成员均可按位移动，QList 中间删除时直接搬移内存
+Q_DECLARE_TYPEINFO(StorageManager::ClipboardData, Q_RELOCATABLE_TYPE);
+
 #endif // STORAGEMANAGER_H
@@ -0,0 +1,73 @@
+// storedmimedata.cpp
+#include "storedmimedata.h"
+#include "tilestore.h"
+#include "tracer.h"
+#include <QBuffer>
+#include <QFile>
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace {
+const char *PNG_MIME = "image/png";
+const char *QT_IMAGE_MIME = "application/x-qt-image";
+const qint64 SLOW_PASTE_MS = 50;
+}
+
+StoredMimeData::StoredMimeData(const QString& path, const QByteArray& png)
+    : m_path(path)
+    , m_png(png)
+{
+}
+
+QStringList StoredMimeData::formats() const {
+    // PNG 放在最前，支持 PNG 的程序直接拿到原始字节
+    return {PNG_MIME, QT_IMAGE_MIME};
+}
+
+bool StoredMimeData::hasFormat(const QString& mimeType) const {
+    return mimeType == QLatin1String(PNG_MIME) || mimeType == QLatin1String(QT_IMAGE_MIME);
+}
+
+QByteArray StoredMimeData::pngBytes() const {
+    if (!m_png.isEmpty()) return m_png;
+    if (TileStore::isMapPath(m_path)) {
+        // 重建出的图片同时留作 QImage 请求的结果，不必再从 PNG 解码
+        if (m_image.isNull()) m_image = TileStore::load(m_path);
+        QBuffer buffer(&m_png);
+        if (m_image.isNull() || !buffer.open(QIODevice::WriteOnly) || !m_image.save(&buffer, "PNG")) {
+            m_png.clear();
+            qDebug() << "无法重建分块图片:" << m_path;
+        }
+        return m_png;
+    }
+    QFile file(m_path);
+    if (file.open(QIODevice::ReadOnly)) {
+        m_png = file.readAll();
+    } else {
+        qDebug() << "无法读取图片文件:" << m_path;
+    }
+    return m_png;
+}
+
+QVariant StoredMimeData::retrieveData(const QString& mimeType, QMetaType type) const {
+    // 粘贴延迟：从其他程序请求数据到返回字节的耗时
+    qint64 start = Tracer::nowNs();
+    QMutexLocker locker(&m_mutex);
+
+    QVariant result;
+    if (mimeType == QLatin1String(PNG_MIME) && type.id() != QMetaType::QImage) {
+        result = pngBytes();
+    } else if (mimeType == QLatin1String(QT_IMAGE_MIME) || mimeType == QLatin1String(PNG_MIME)) {
+        // 请求其他图片格式时平台插件会走 QImage 转换，只解码一次
+        if (m_image.isNull() && TileStore::isMapPath(m_path) && m_png.isEmpty()) m_image = TileStore::load(m_path);
+        if (m_image.isNull()) m_image = QImage::fromData(pngBytes(), "PNG");
+        result = m_image;
+    }
+
+    qint64 durationNs = Tracer::nowNs() - start;
+    if (Tracer::isEnabled()) Tracer::record("paste.retrieve", start, durationNs);
+    if (durationNs / 1000000 > SLOW_PASTE_MS) {
+        qDebug() << "粘贴数据准备耗时" << durationNs / 1000000 << "ms:" << mimeType;
+    }
+    return result;
+}
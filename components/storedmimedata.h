@@ -0,0 +1,35 @@
+// storedmimedata.h
+#ifndef STOREDMIMEDATA_H
+#define STOREDMIMEDATA_H
+
+#include <QMimeData>
+#include <QImage>
+#include <QMutex>
+
+// 复制回剪贴板时使用：直接提供存储中已编码好的 PNG，其他程序粘贴时
+// 按需读取文件字节，不再解码后重新编码。只有请求非 PNG 格式时才解码一次并缓存。
+// 分块存放的图片（.tiles 块映射）在首次粘贴时重建并编码一次，之后同样直接返回。
+class StoredMimeData : public QMimeData {
+    Q_OBJECT
+public:
+    // path 为 PNG 文件或块映射；png 非空时直接使用已读入内存的字节（置顶条目）
+    explicit StoredMimeData(const QString& path, const QByteArray& png = QByteArray());
+
+    QStringList formats() const override;
+    bool hasFormat(const QString& mimeType) const override;
+
+    QString path() const { return m_path; }
+
+protected:
+    QVariant retrieveData(const QString& mimeType, QMetaType type) const override;
+
+private:
+    QByteArray pngBytes() const;
+
+    QString m_path;
+    mutable QMutex m_mutex;     // 平台插件可能在其他线程请求数据
+    mutable QByteArray m_png;   // 首次请求时读入，之后重复粘贴直接返回
+    mutable QImage m_image;
+};
+
+#endif // STOREDMIMEDATA_H
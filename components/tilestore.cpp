@@ -0,0 +1,339 @@
+// tilestore.cpp
+#include "tilestore.h"
+#include "tracer.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+const quint32 MAP_MAGIC = 0x4354494C;  // "CTIL"
+const quint8 MAP_VERSION = 1;
+
+const quint64 P1 = 0x9E3779B185EBCA87ULL;
+const quint64 P2 = 0xC2B2AE3D27D4EB4FULL;
+const quint64 P3 = 0x165667B19E3779F9ULL;
+const quint64 P4 = 0x85EBCA77C2B2AE63ULL;
+
+inline quint64 rotl(quint64 x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline quint64 mixRound(quint64 acc, quint64 input) {
+    acc += input * P2;
+    return rotl(acc, 31) * P1;
+}
+
+inline quint64 avalanche(quint64 h) {
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    return h ^ (h >> 32);
+}
+
+struct TileMap {
+    QSize size;
+    QImage::Format format = QImage::Format_Invalid;
+    int tileSize = 0;
+    qint64 bytes = 0;      // 引用的块压缩后的总大小（去重后）
+    QStringList tiles;     // 按行优先排列，每个位置一项
+};
+
+bool readMap(const QString& path, TileMap& map) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint8 version = 0;
+    qint32 width = 0, height = 0, format = 0, tileSize = 0;
+    in >> magic >> version;
+    if (magic != MAP_MAGIC || version != MAP_VERSION) return false;
+    in >> width >> height >> format >> tileSize >> map.bytes >> map.tiles;
+    if (in.status() != QDataStream::Ok || tileSize <= 0) return false;
+    map.size = QSize(width, height);
+    map.format = static_cast<QImage::Format>(format);
+    map.tileSize = tileSize;
+    return true;
+}
+
+QList<QRect> tileRects(const QSize& size, int tileSize) {
+    QList<QRect> rects;
+    for (int y = 0; y < size.height(); y += tileSize) {
+        for (int x = 0; x < size.width(); x += tileSize) {
+            rects.append(QRect(x, y, qMin(tileSize, size.width() - x), qMin(tileSize, size.height() - y)));
+        }
+    }
+    return rects;
+}
+
+} // namespace
+
+TileStore::TileStore(const QString& root)
+    : m_root(root)
+{
+}
+
+void TileStore::setRoot(const QString& root) {
+    QMutexLocker locker(&m_mutex);
+    m_root = root;
+}
+
+QString TileStore::root() const {
+    QMutexLocker locker(&m_mutex);
+    return m_root;
+}
+
+QString TileStore::tilePath(const QString& id) const {
+    return root() + "/" + id.left(2) + "/" + id;
+}
+
+QString TileStore::rootForMap(const QString& mapPath) {
+    // 块映射在 images/ 下，块在同级的 tiles/ 下
+    return QDir::cleanPath(QFileInfo(mapPath).absolutePath() + "/../tiles");
+}
+
+QString TileStore::tileId(const QImage& image, const QRect& rect) {
+    // 每行按 32 字节一组分给四条独立的累加链，互不依赖，可以交错执行；
+    // 两组不同的合并方式得到 128 位结果
+    const quint64 seed = (quint64(rect.width()) << 40) ^ (quint64(rect.height()) << 20) ^ quint64(image.format());
+    quint64 acc[4] = {seed + P1 + P2, seed + P2, seed, seed - P1};
+    const qsizetype rowBytes = qsizetype(rect.width()) * 4;
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        const uchar *p = image.constScanLine(y) + qsizetype(rect.left()) * 4;
+        qsizetype i = 0;
+        for (; i + 32 <= rowBytes; i += 32) {
+            quint64 words[4];
+            std::memcpy(words, p + i, sizeof(words));
+            acc[0] = mixRound(acc[0], words[0]);
+            acc[1] = mixRound(acc[1], words[1]);
+            acc[2] = mixRound(acc[2], words[2]);
+            acc[3] = mixRound(acc[3], words[3]);
+        }
+        for (; i + 4 <= rowBytes; i += 4) {
+            quint32 word;
+            std::memcpy(&word, p + i, sizeof(word));
+            acc[0] = mixRound(acc[0], word);
+        }
+    }
+
+    quint64 high = avalanche(rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18));
+    quint64 low = avalanche((acc[0] * P3) ^ rotl(acc[1], 29) ^ (acc[2] * P4) ^ rotl(acc[3], 43) ^ seed);
+    return QString::asprintf("%016llx%016llx", static_cast<unsigned long long>(high),
+                             static_cast<unsigned long long>(low));
+}
+
+QStringList TileStore::store(const QString& mapPath, const QImage& image, QString *error) {
+    TRACE_SCOPE("tileStore.store");
+    if (image.isNull()) {
+        if (error) *error = "图片为空";
+        return QStringList();
+    }
+    const QImage source = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32
+                                                                        : QImage::Format_RGB32);
+    const QList<QRect> rects = tileRects(source.size(), TILE_SIZE);
+
+    qint64 hashStart = Tracer::nowNs();
+    const QList<QString> ids = QtConcurrent::blockingMapped(rects, [&source](const QRect& rect) {
+        return tileId(source, rect);
+    });
+    qint64 hashNs = Tracer::nowNs() - hashStart;
+
+    // 相同的块（例如大片纯色背景）只写一次
+    QList<int> unique;
+    QSet<QString> seen;
+    for (int i = 0; i < ids.size(); ++i) {
+        if (!seen.contains(ids.at(i))) {
+            seen.insert(ids.at(i));
+            unique.append(i);
+        }
+    }
+    QStringList held;
+    held.reserve(unique.size());
+    {
+        // 先登记再检查文件：remove 在同一把锁内判断和删除，登记之后不会再删掉这些块
+        QMutexLocker locker(&m_mutex);
+        for (int i : unique) {
+            m_held[ids.at(i)]++;
+            held.append(ids.at(i));
+        }
+    }
+
+    struct Written {
+        qint64 bytes = 0;
+        bool created = false;
+        QString error;
+    };
+    const QList<Written> written = QtConcurrent::blockingMapped(unique, [&](int index) {
+        Written result;
+        const QString path = tilePath(ids.at(index));
+        QFileInfo info(path);
+        if (info.exists()) {
+            result.bytes = info.size();
+            return result;
+        }
+        const QRect& rect = rects.at(index);
+        const qsizetype rowBytes = qsizetype(rect.width()) * 4;
+        QByteArray raw(rowBytes * rect.height(), Qt::Uninitialized);
+        for (int y = 0; y < rect.height(); ++y) {
+            std::memcpy(raw.data() + y * rowBytes,
+                        source.constScanLine(rect.top() + y) + qsizetype(rect.left()) * 4, rowBytes);
+        }
+        const QByteArray compressed = qCompress(raw);
+        QDir().mkpath(info.path());
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(compressed) != compressed.size() || !file.commit()) {
+            result.error = "无法写入图片块: " + file.errorString();
+            return result;
+        }
+        result.bytes = compressed.size();
+        result.created = true;
+        return result;
+    });
+
+    qint64 storedBytes = 0;
+    qint64 newBytes = 0;
+    int created = 0;
+    for (const auto& result : written) {
+        if (!result.error.isEmpty()) {
+            if (error) *error = result.error;
+            release(held);
+            return QStringList();
+        }
+        storedBytes += result.bytes;
+        if (result.created) {
+            newBytes += result.bytes;
+            created++;
+        }
+    }
+
+    // 块都写好之后才写映射，映射存在即说明图片完整
+    QSaveFile mapFile(mapPath);
+    if (mapFile.open(QIODevice::WriteOnly)) {
+        QDataStream out(&mapFile);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << MAP_MAGIC << MAP_VERSION
+            << qint32(source.width()) << qint32(source.height()) << qint32(source.format())
+            << qint32(TILE_SIZE) << storedBytes << QStringList(ids);
+    }
+    if (!mapFile.commit()) {
+        if (error) *error = "无法写入图片块映射: " + mapFile.errorString();
+        release(held);
+        return QStringList();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_logicalBytes += source.sizeInBytes();
+    m_writtenBytes += newBytes;
+    m_tiles += ids.size();
+    m_newTiles += created;
+    m_hashBytes += source.sizeInBytes();
+    m_hashNs += hashNs;
+    return held;
+}
+
+void TileStore::release(const QStringList& ids) {
+    QMutexLocker locker(&m_mutex);
+    for (const auto& id : ids) {
+        auto it = m_held.find(id);
+        if (it != m_held.end() && --it.value() <= 0) m_held.erase(it);
+    }
+}
+
+QImage TileStore::load(const QString& mapPath) {
+    TRACE_SCOPE("tileStore.load");
+    TileMap map;
+    if (!readMap(mapPath, map)) return QImage();
+    const QList<QRect> rects = tileRects(map.size, map.tileSize);
+    if (rects.size() != map.tiles.size()) return QImage();
+
+    QImage image(map.size, map.format);
+    if (image.isNull()) return QImage();
+    // 各块写入互不重叠的区域；先取出指针，避免在工作线程中触发 detach
+    uchar *bits = image.bits();
+    const qsizetype bytesPerLine = image.bytesPerLine();
+    const QString root = rootForMap(mapPath);
+
+    std::atomic<bool> ok{true};
+    QList<int> indexes(rects.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    QtConcurrent::blockingMap(indexes, [&](int index) {
+        const QString& id = map.tiles.at(index);
+        const QRect& rect = rects.at(index);
+        QFile file(root + "/" + id.left(2) + "/" + id);
+        const qsizetype rowBytes = qsizetype(rect.width()) * 4;
+        QByteArray raw = file.open(QIODevice::ReadOnly) ? qUncompress(file.readAll()) : QByteArray();
+        if (raw.size() != rowBytes * rect.height()) {
+            qDebug() << "图片块缺失或损坏:" << id;
+            ok = false;
+            return;
+        }
+        for (int y = 0; y < rect.height(); ++y) {
+            std::memcpy(bits + (rect.top() + y) * bytesPerLine + qsizetype(rect.left()) * 4,
+                        raw.constData() + y * rowBytes, rowBytes);
+        }
+    });
+    return ok ? image : QImage();
+}
+
+QStringList TileStore::tiles(const QString& mapPath, qint64 *bytes) {
+    TileMap map;
+    if (!readMap(mapPath, map)) return QStringList();
+    if (bytes) *bytes = map.bytes;
+    return map.tiles;
+}
+
+bool TileStore::import(const TileStore& source, const QStringList& ids) {
+    for (const auto& id : ids) {
+        QString path = tilePath(id);
+        if (QFile::exists(path)) continue;
+        QDir().mkpath(QFileInfo(path).path());
+        if (!QFile::copy(source.tilePath(id), path)) return false;
+    }
+    return true;
+}
+
+void TileStore::remove(const QSet<QString>& ids) {
+    QMutexLocker locker(&m_mutex);
+    for (const auto& id : ids) {
+        if (m_held.contains(id)) continue;
+        QFile::remove(m_root + "/" + id.left(2) + "/" + id);
+    }
+}
+
+bool TileStore::isMapPath(const QString& path) {
+    return path.endsWith(".tiles");
+}
+
+QImage TileStore::readImageFile(const QString& path) {
+    return isMapPath(path) ? load(path) : QImage(path);
+}
+
+QSize TileStore::imageSize(const QString& path) {
+    if (!isMapPath(path)) return QImageReader(path).size();
+    TileMap map;
+    return readMap(path, map) ? map.size : QSize();
+}
+
+QList<QPair<QString, qint64>> TileStore::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return {
+        {"logicalBytes", m_logicalBytes},
+        {"storedBytes", m_writtenBytes},
+        {"tiles", m_tiles},
+        {"newTiles", m_newTiles},
+        {"dedupePercent", m_logicalBytes > 0 ? (m_logicalBytes - m_writtenBytes) * 100 / m_logicalBytes : 0},
+        {"hashMBps", m_hashNs > 0 ? m_hashBytes * 1000 / m_hashNs : 0},
+    };
+}
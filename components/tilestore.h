@@ -0,0 +1,66 @@
+// tilestore.h
+#ifndef TILESTORE_H
+#define TILESTORE_H
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// 图片分块存储：截图按固定大小的像素块切分，每块按内容哈希压缩后存为
+// tiles/<前两位>/<哈希> 一个文件，图片本身只保存一份块映射（images/<hash>.tiles）。
+// 连续截取的相似画面只有变化区域的块不同，其余块只存一份。线程安全。
+class TileStore {
+public:
+    static const int TILE_SIZE = 128;
+
+    explicit TileStore(const QString& root = QString());
+
+    void setRoot(const QString& root);
+    QString root() const;
+
+    // 块的内容哈希（128 位十六进制），包含尺寸和像素格式
+    static QString tileId(const QImage& image, const QRect& rect);
+
+    // 切分并写入缺失的块和块映射，返回映射引用的块（去重后），失败时返回空列表。
+    // 返回的块在 release 之前不会被 remove 删除（引用它的条目可能尚未登记）
+    QStringList store(const QString& mapPath, const QImage& image, QString *error = nullptr);
+    void release(const QStringList& ids);
+
+    // 并行读取各块重建图片，块目录由映射所在位置推出（images/ 同级的 tiles/）
+    static QImage load(const QString& mapPath);
+    // 映射中每个位置引用的块（可能重复）；bytes 为去重后的块压缩总大小
+    static QStringList tiles(const QString& mapPath, qint64 *bytes = nullptr);
+    bool import(const TileStore& source, const QStringList& ids);
+    // 删除不再被引用的块，调用方负责确认引用关系
+    void remove(const QSet<QString>& ids);
+
+    // 块映射文件（.tiles）或普通图片文件，供只知道路径的工作线程使用
+    static bool isMapPath(const QString& path);
+    static QImage readImageFile(const QString& path);
+    // 只读文件头得到尺寸，不解码像素
+    static QSize imageSize(const QString& path);
+
+    // 本进程内的累计统计：原始像素字节、实际写入字节、去重率、哈希吞吐
+    QList<QPair<QString, qint64>> stats() const;
+
+private:
+    QString tilePath(const QString& id) const;
+    static QString rootForMap(const QString& mapPath);
+
+    mutable QMutex m_mutex;
+    QString m_root;
+    QHash<QString, int> m_held;
+    qint64 m_logicalBytes = 0;
+    qint64 m_writtenBytes = 0;
+    qint64 m_tiles = 0;
+    qint64 m_newTiles = 0;
+    qint64 m_hashBytes = 0;
+    qint64 m_hashNs = 0;
+};
+
+#endif // TILESTORE_H
@@ -0,0 +1,141 @@
+// tracer.cpp
+#include "tracer.h"
+#include <QElapsedTimer>
+#include <QThread>
+#include <QHash>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QCoreApplication>
+#include <algorithm>
+
+std::atomic<bool> Tracer::s_enabled{false};
+
+namespace {
+struct TraceEvent {
+    const char *name = nullptr;
+    qint64 startNs = 0;
+    qint64 durationNs = 0;
+    quintptr threadId = 0;
+};
+
+// 容量为 2 的幂，写入位置按掩码回绕；读取时可能与写入并发，仅用于诊断
+const quint64 RING_CAPACITY = 1 << 16;
+const quint64 RING_MASK = RING_CAPACITY - 1;
+
+TraceEvent g_ring[RING_CAPACITY];
+std::atomic<quint64> g_writeIndex{0};
+
+QElapsedTimer& traceClock() {
+    static QElapsedTimer timer;
+    return timer;
+}
+
+QList<TraceEvent> snapshot() {
+    quint64 end = g_writeIndex.load(std::memory_order_acquire);
+    quint64 begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+
+    QList<TraceEvent> events;
+    events.reserve(static_cast<int>(end - begin));
+    for (quint64 i = begin; i < end; ++i) {
+        const TraceEvent& event = g_ring[i & RING_MASK];
+        if (event.name) events.append(event);
+    }
+    return events;
+}
+
+double percentile(QList<qint64>& sorted, double p) {
+    if (sorted.isEmpty()) return 0;
+    int index = qBound(0, static_cast<int>(p * (sorted.size() - 1) + 0.5), static_cast<int>(sorted.size() - 1));
+    return sorted.at(index) / 1e6;
+}
+}
+
+void Tracer::setEnabled(bool enable) {
+    if (enable && !traceClock().isValid()) traceClock().start();
+    s_enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Tracer::initFromEnvironment() {
+    if (qEnvironmentVariableIntValue("CLIPBOARD_TRACE") != 0) {
+        setEnabled(true);
+    }
+}
+
+qint64 Tracer::nowNs() {
+    return traceClock().nsecsElapsed();
+}
+
+void Tracer::record(const char *name, qint64 startNs, qint64 durationNs) {
+    quint64 index = g_writeIndex.fetch_add(1, std::memory_order_acq_rel);
+    TraceEvent& event = g_ring[index & RING_MASK];
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = durationNs;
+    event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+}
+
+void Tracer::clear() {
+    // 只回绕写入位置，快照只读取此后写入的槽位；缓冲区在开启追踪前不会被触碰
+    g_writeIndex.store(0, std::memory_order_release);
+}
+
+bool Tracer::exportChromeTrace(const QString& path) {
+    const QList<TraceEvent> events = snapshot();
+
+    // 线程 id 映射为较小的整数，便于在查看器中阅读
+    QHash<quintptr, int> threads;
+    QJsonArray traceEvents;
+    for (const auto& event : events) {
+        int tid = threads.value(event.threadId, -1);
+        if (tid < 0) {
+            tid = threads.size() + 1;
+            threads.insert(event.threadId, tid);
+        }
+
+        QJsonObject obj;
+        obj["name"] = QString::fromLatin1(event.name);
+        obj["ph"] = "X";
+        obj["ts"] = event.startNs / 1000.0;   // 微秒
+        obj["dur"] = event.durationNs / 1000.0;
+        obj["pid"] = static_cast<qint64>(QCoreApplication::applicationPid());
+        obj["tid"] = tid;
+        traceEvents.append(obj);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+QList<Tracer::StageStats> Tracer::stageStats() {
+    QHash<QString, QList<qint64>> durations;
+    for (const auto& event : snapshot()) {
+        durations[QString::fromLatin1(event.name)].append(event.durationNs);
+    }
+
+    QList<StageStats> stats;
+    for (auto it = durations.begin(); it != durations.end(); ++it) {
+        QList<qint64>& values = it.value();
+        std::sort(values.begin(), values.end());
+
+        StageStats stage;
+        stage.name = it.key();
+        stage.count = static_cast<int>(values.size());
+        stage.p50Ms = percentile(values, 0.50);
+        stage.p99Ms = percentile(values, 0.99);
+        stage.maxMs = values.last() / 1e6;
+        stats.append(stage);
+    }
+
+    std::sort(stats.begin(), stats.end(), [](const StageStats& a, const StageStats& b) {
+        return a.name < b.name;
+    });
+    return stats;
+}
@@ -0,0 +1,63 @@
+// tracer.h
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QList>
+#include <atomic>
+
+// 热路径埋点：定长环形缓冲区记录耗时，可导出 Chrome trace / Perfetto JSON。
+// 关闭时每个探针只有一次原子读取加一次分支。
+class Tracer {
+public:
+    struct StageStats {
+        QString name;
+        int count = 0;
+        double p50Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+    };
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enable);
+    // 环境变量 CLIPBOARD_TRACE=1 时启动即开启
+    static void initFromEnvironment();
+
+    static qint64 nowNs();
+    // name 必须是静态字符串（字面量），缓冲区只保存指针
+    static void record(const char *name, qint64 startNs, qint64 durationNs);
+    static void clear();
+
+    static bool exportChromeTrace(const QString& path);
+    static QList<StageStats> stageStats();
+
+private:
+    Tracer() = delete;
+    static std::atomic<bool> s_enabled;
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char *name)
+        : m_name(Tracer::isEnabled() ? name : nullptr)
+    {
+        if (m_name) m_start = Tracer::nowNs();
+    }
+
+    ~TraceScope() {
+        if (m_name) Tracer::record(m_name, m_start, Tracer::nowNs() - m_start);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_start = 0;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+#endif // TRACER_H
@@ -1,4 +1,5 @@
 #include "customdialog.h"
+#include "theme.h"
 #include <QMouseEvent>
 #include <QApplication>
 #include <QScreen>
@@ -25,51 +26,13 @@ QPushButton* CustomDialog::createStyledButton(const QString& text, const QString
     auto* button = new QPushButton(text);
     button->setFixedHeight(32);
 
+    // 样式在应用级主题中按 objectName 匹配
     if (baseColor == "blue") {
-        button->setStyleSheet(R"(
-            QPushButton {
-                background-color: #4B8BF4;
-                color: white;
-                border: none;
-                border-radius: 4px;
-                padding: 5px 15px;
-                min-width: 80px;
-                font-size: 13px;
-            }
-            QPushButton:hover {
-                background-color: #357ABD;
-            }
-        )");
+        button->setObjectName(Theme::DialogPrimaryButton);
     } else if (baseColor == "red") {
-        button->setStyleSheet(R"(
-            QPushButton {
-                background-color: #E34133;
-                color: white;
-                border: none;
-                border-radius: 4px;
-                padding: 5px 15px;
-                min-width: 80px;
-                font-size: 13px;
-            }
-            QPushButton:hover {
-                background-color: #D03126;
-            }
-        )");
+        button->setObjectName(Theme::DialogDangerButton);
     } else {
-        button->setStyleSheet(R"(
-            QPushButton {
-                background-color: #F5F5F5;
-                color: #333333;
-                border: 1px solid #DDDDDD;
-                border-radius: 4px;
-                padding: 5px 15px;
-                min-width: 80px;
-                font-size: 13px;
-            }
-            QPushButton:hover {
-                background-color: #EBEBEB;
-            }
-        )");
+        button->setObjectName(Theme::DialogSecondaryButton);
     }
     return button;
 }
@@ -77,49 +40,6 @@ QPushButton* CustomDialog::createStyledButton(const QString& text, const QString
 
 
 void CustomDialog::setupCloseConfirmDialog() {
-    // 设置整体对话框样式
-    setStyleSheet(R"(
-        QDialog {
-            background-color: white;
-            border: 1px solid #CCCCCC;
-            border-radius: 8px;
-        }
-        QPushButton {
-            height: 32px;
-            min-width: 90px;
-            border-radius: 4px;
-            font-size: 13px;
-            font-family: "Microsoft YaHei";
-        }
-        QPushButton#saveButton {
-            background-color: #4B8BF4;
-            color: white;
-            border: none;
-        }
-        QPushButton#saveButton:hover {
-            background-color: #357ABD;
-        }
-        QPushButton#noSaveButton {
-            background-color: #E34133;
-            color: white;
-            border: none;
-        }
-        QPushButton#noSaveButton:hover {
-            background-color: #D03126;
-        }
-        QPushButton#cancelButton {
-            background-color: #F5F5F5;
-            color: #333333;
-            border: 1px solid #DDDDDD;
-        }
-        QPushButton#cancelButton:hover {
-            background-color: #EBEBEB;
-        }
-        QLabel {
-            color: #333333;
-        }
-    )");
-
     auto* mainLayout = new QVBoxLayout(this);
     mainLayout->setSpacing(0);
     mainLayout->setContentsMargins(0, 0, 0, 0);
@@ -127,13 +47,13 @@ void CustomDialog::setupCloseConfirmDialog() {
     // 标题栏
     auto* titleBar = new QWidget;
     titleBar->setFixedHeight(45);
-    titleBar->setStyleSheet("background: #4B8BF4; border-top-left-radius: 8px; border-top-right-radius: 8px;");
+    titleBar->setObjectName(Theme::DialogTitleBar);
 
     auto* titleLayout = new QHBoxLayout(titleBar);
     titleLayout->setContentsMargins(20, 0, 20, 0);
 
     auto* titleLabel = new QLabel("关闭确认");
-    titleLabel->setStyleSheet("color: white; font-size: 14px; font-weight: bold;");
+    titleLabel->setObjectName(Theme::DialogTitle);
     titleLayout->addWidget(titleLabel);
 
     mainLayout->addWidget(titleBar);
@@ -146,7 +66,7 @@ void CustomDialog::setupCloseConfirmDialog() {
 
     auto* messageLabel = new QLabel("是否要关闭剪贴板历史？\n当前记录将保存到本地。");
     messageLabel->setAlignment(Qt::AlignCenter);
-    messageLabel->setStyleSheet("font-size: 13px; line-height: 1.5;");
+    messageLabel->setObjectName(Theme::DialogMessage);
     contentLayout->addWidget(messageLabel);
 
     // 按钮区域
@@ -181,17 +101,6 @@ void CustomDialog::setupCloseConfirmDialog() {
     setFixedSize(360, 180);
 }
 void CustomDialog::setupHistoryLimitDialog() {
-    setStyleSheet(R"(
-        QDialog {
-            background: white;
-            border-radius: 8px;
-            border: 1px solid #CCCCCC;
-        }
-        QLabel {
-            color: #333333;
-        }
-    )");
-
     auto* mainLayout = new QVBoxLayout(this);
     mainLayout->setSpacing(0);
     mainLayout->setContentsMargins(0, 0, 0, 0);
@@ -199,27 +108,26 @@ void CustomDialog::setupHistoryLimitDialog() {
     // 标题栏
     auto* titleBar = new QWidget;
     titleBar->setFixedHeight(45);
-    titleBar->setStyleSheet("background: #4B8BF4; border-top-left-radius: 8px; border-top-right-radius: 8px;");
+    titleBar->setObjectName(Theme::DialogTitleBar);
 
     auto* titleLayout = new QHBoxLayout(titleBar);
     titleLayout->setContentsMargins(20, 0, 20, 0);
 
     auto* titleLabel = new QLabel("历史记录数量提醒");
-    titleLabel->setStyleSheet("color: white; font-size: 14px; font-weight: bold;");
+    titleLabel->setObjectName(Theme::DialogTitle);
     titleLayout->addWidget(titleLabel);
 
     mainLayout->addWidget(titleBar);
 
     // 内容区域
     auto* contentWidget = new QWidget;
-    contentWidget->setStyleSheet("background: transparent;");
     auto* contentLayout = new QVBoxLayout(contentWidget);
     contentLayout->setSpacing(20);
     contentLayout->setContentsMargins(20, 20, 20, 20);
 
     auto* messageLabel = new QLabel("历史记录数量已超过100条，\n较早的记录将会被自动清除。");
     messageLabel->setAlignment(Qt::AlignCenter);
-    messageLabel->setStyleSheet("font-size: 13px; line-height: 1.5;");
+    messageLabel->setObjectName(Theme::DialogMessage);
     contentLayout->addWidget(messageLabel);
 
     auto* okButton = createStyledButton("确定", "blue");
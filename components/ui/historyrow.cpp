@@ -0,0 +1,28 @@
+// historyrow.cpp
+#include "historyrow.h"
+#include "theme.h"
+#include <QPainter>
+
+HistoryRow::HistoryRow(bool pinned, QWidget *parent)
+    : QWidget(parent)
+    , m_pinned(pinned)
+{
+    // 圆角外的区域保持透明，露出列表项背景
+    setAttribute(Qt::WA_NoSystemBackground);
+}
+
+void HistoryRow::setPinned(bool pinned) {
+    if (m_pinned == pinned) return;
+    m_pinned = pinned;
+    update();
+}
+
+void HistoryRow::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(Theme::rowBackground(m_pinned));
+    // 与原样式表的 margin: 5px; border-radius: 6px 一致
+    painter.drawRoundedRect(QRectF(rect()).adjusted(5, 5, -5, -5), 6, 6);
+}
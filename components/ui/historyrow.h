@@ -0,0 +1,25 @@
+// historyrow.h
+#ifndef HISTORYROW_H
+#define HISTORYROW_H
+
+#include <QWidget>
+
+// 历史列表中的一行：圆角背景直接绘制，颜色取自 Theme，
+// 创建行时不解析样式表，置顶状态切换也只需重绘
+class HistoryRow : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit HistoryRow(bool pinned = false, QWidget *parent = nullptr);
+
+    void setPinned(bool pinned);
+    bool isPinned() const { return m_pinned; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    bool m_pinned;
+};
+
+#endif // HISTORYROW_H
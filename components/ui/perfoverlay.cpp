@@ -0,0 +1,82 @@
+// perfoverlay.cpp
+#include "perfoverlay.h"
+#include <QPainter>
+#include <QFontDatabase>
+
+PerfOverlay::PerfOverlay(QWidget *parent)
+    : QWidget(parent)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setInterval(500);
+    connect(refreshTimer, &QTimer::timeout, this, &PerfOverlay::refresh);
+    hide();
+}
+
+void PerfOverlay::setMemoryProvider(MemoryProvider provider) {
+    memoryProvider = std::move(provider);
+}
+
+void PerfOverlay::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    refresh();
+    refreshTimer->start();
+}
+
+void PerfOverlay::hideEvent(QHideEvent *event) {
+    QWidget::hideEvent(event);
+    refreshTimer->stop();
+}
+
+void PerfOverlay::refresh() {
+    stats = Tracer::stageStats();
+    memory = memoryProvider ? memoryProvider() : QList<QPair<QString, qint64>>();
+
+    // 按内容调整大小并贴在父窗口右上角
+    QFontMetrics metrics(font());
+    int lines = stats.size() + memory.size() + 3;
+    int width = metrics.horizontalAdvance(QString(52, QLatin1Char('0'))) + 20;
+    int height = lines * metrics.height() + 20;
+    if (parentWidget()) {
+        setGeometry(parentWidget()->width() - width - 10, 10, width, height);
+    }
+    raise();
+    update();
+}
+
+void PerfOverlay::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(0, 0, 0, 180));
+    painter.drawRoundedRect(rect(), 6, 6);
+
+    QFontMetrics metrics(font());
+    int y = 10 + metrics.ascent();
+    auto drawLine = [&](const QString& text, const QColor& color) {
+        painter.setPen(color);
+        painter.drawText(10, y, text);
+        y += metrics.height();
+    };
+
+    drawLine(QString("%1 %2 %3 %4").arg("stage", -26).arg("n", 6).arg("p50", 8).arg("p99", 8),
+             QColor("#4B8BF4"));
+    for (const auto& stage : stats) {
+        drawLine(QString("%1 %2 %3 %4")
+                     .arg(stage.name, -26)
+                     .arg(stage.count, 6)
+                     .arg(stage.p50Ms, 8, 'f', 2)
+                     .arg(stage.p99Ms, 8, 'f', 2),
+                 Qt::white);
+    }
+
+    y += metrics.height() / 2;
+    drawLine("memory", QColor("#4B8BF4"));
+    for (const auto& entry : memory) {
+        drawLine(QString("%1 %2 KB").arg(entry.first, -26).arg(entry.second / 1024, 10), Qt::white);
+    }
+}
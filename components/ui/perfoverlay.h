@@ -0,0 +1,37 @@
+// perfoverlay.h
+#ifndef PERFOVERLAY_H
+#define PERFOVERLAY_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QList>
+#include <QPair>
+#include <functional>
+#include "../tracer.h"
+
+// 性能浮层：显示各阶段 p50/p99 耗时和当前缓存内存占用
+class PerfOverlay : public QWidget {
+    Q_OBJECT
+
+public:
+    // 返回 (名称, 字节数) 列表
+    using MemoryProvider = std::function<QList<QPair<QString, qint64>>()>;
+
+    explicit PerfOverlay(QWidget *parent);
+    void setMemoryProvider(MemoryProvider provider);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void refresh();
+
+    QTimer *refreshTimer;
+    MemoryProvider memoryProvider;
+    QList<Tracer::StageStats> stats;
+    QList<QPair<QString, qint64>> memory;
+};
+
+#endif // PERFOVERLAY_H
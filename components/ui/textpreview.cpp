@@ -0,0 +1,602 @@
+// textpreview.cpp
+#include "textpreview.h"
+#include "theme.h"
+#include "../tracer.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QFontDatabase>
+#include <QGuiApplication>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSettings>
+#include <QShortcut>
+#include <QVBoxLayout>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace {
+
+const QColor STRING_COLOR("#0B7A0B");
+const QColor KEY_COLOR("#0451A5");
+const QColor NUMBER_COLOR("#1A1AA6");
+const QColor KEYWORD_COLOR("#A626A4");
+const QColor COMMENT_COLOR("#8E908C");
+const QColor MATCH_COLOR("#FFF59D");
+const QColor CURRENT_MATCH_COLOR("#FFB74D");
+const QColor SELECTION_COLOR("#BBDEFB");
+
+const char *const KEYWORDS[] = {
+    "true", "false", "null", "None", "True", "False", "nil", "undefined",
+    "if", "else", "for", "while", "return", "function", "class", "def",
+    "import", "from", "const", "let", "var", "struct", "public", "private",
+};
+
+bool isKeyword(QStringView word) {
+    return std::any_of(std::begin(KEYWORDS), std::end(KEYWORDS),
+                       [word](const char *keyword) { return word == QLatin1String(keyword); });
+}
+
+} // namespace
+
+VirtualTextView::VirtualTextView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+    , m_highlightCache(4096)
+{
+    setFrameShape(QFrame::NoFrame);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    QFontMetrics metrics(font());
+    m_charWidth = qMax(1, metrics.horizontalAdvance(QLatin1Char('M')));
+    m_lineHeight = qMax(1, metrics.height());
+    viewport()->setCursor(Qt::IBeamCursor);
+
+    m_searchDebounce.setSingleShot(true);
+    m_searchDebounce.setInterval(150);
+    connect(&m_searchDebounce, &QTimer::timeout, this, &VirtualTextView::startSearch);
+
+    connect(&m_indexWatcher, &QFutureWatcher<LineIndex>::finished, this, [this]() {
+        if (m_indexGeneration == m_generation) onIndexed(m_indexWatcher.result());
+    });
+    connect(&m_searchWatcher, &QFutureWatcher<QList<qsizetype>>::finished, this, [this]() {
+        if (m_searchGeneration != m_generation || m_query.isEmpty()) return;
+        m_matches = m_searchWatcher.result();
+        // 当前匹配取可见区域内（或之后）的第一个
+        qsizetype top = m_indexed ? m_index.lineStart(verticalScrollBar()->value()) : 0;
+        auto it = std::lower_bound(m_matches.begin(), m_matches.end(), top);
+        m_currentMatch = m_matches.isEmpty() ? -1 :
+                             static_cast<int>(it == m_matches.end() ? 0 : it - m_matches.begin());
+        emit matchesChanged(m_currentMatch, m_matches.size());
+        viewport()->update();
+    });
+}
+
+void VirtualTextView::setText(const QString& text) {
+    ++m_generation;
+    m_text = text;
+    m_indexed = false;
+    m_index = LineIndex();
+    m_highlightCache.clear();
+    m_matches.clear();
+    m_currentMatch = -1;
+    m_anchor = m_cursor = -1;
+
+    if (text.size() <= SYNC_INDEX_CHARS) {
+        onIndexed(LineIndex::build(m_text));
+    } else {
+        // 大文本在工作线程中扫描换行，期间显示提示
+        m_indexGeneration = m_generation;
+        m_indexWatcher.setFuture(QtConcurrent::run([text]() { return LineIndex::build(text); }));
+        viewport()->update();
+    }
+}
+
+void VirtualTextView::appendText(QStringView text) {
+    if (text.isEmpty()) return;
+    m_text.append(text);
+    // 后台索引尚未完成时，onIndexed 会补上追加的部分
+    if (!m_indexed) return;
+
+    // 原最后一行可能被接长，丢弃它的高亮缓存
+    m_highlightCache.remove(m_index.lineCount() - 1);
+    m_index.extend(m_text);
+    updateScrollBars();
+    if (!m_query.isEmpty()) m_searchDebounce.start();
+    viewport()->update();
+}
+
+void VirtualTextView::onIndexed(const LineIndex& index) {
+    m_index = index;
+    m_index.extend(m_text);
+    m_indexed = true;
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    updateScrollBars();
+    if (!m_query.isEmpty()) startSearch();
+    viewport()->update();
+}
+
+void VirtualTextView::setHighlighting(bool enabled) {
+    m_highlighting = enabled;
+    m_highlightCache.clear();
+    viewport()->update();
+}
+
+void VirtualTextView::setSearchQuery(const QString& query) {
+    m_query = query;
+    m_matches.clear();
+    m_currentMatch = -1;
+    // 可见行在绘制时直接查找，立即生效；全文匹配稍后在工作线程中收集
+    viewport()->update();
+    if (query.isEmpty()) {
+        m_searchDebounce.stop();
+        emit matchesChanged(-1, 0);
+        return;
+    }
+    m_searchDebounce.start();
+}
+
+void VirtualTextView::startSearch() {
+    if (m_query.isEmpty() || !m_indexed) return;
+    QString text = m_text;
+    QString query = m_query;
+    m_searchGeneration = m_generation;
+    // 只保留最新一次请求的结果：setFuture 会断开旧任务
+    m_searchWatcher.setFuture(QtConcurrent::run([text, query]() {
+        TRACE_SCOPE("textPreview.search");
+        QList<qsizetype> matches;
+        qsizetype pos = 0;
+        while (matches.size() < MAX_MATCHES) {
+            pos = text.indexOf(query, pos, Qt::CaseInsensitive);
+            if (pos < 0) break;
+            matches.append(pos);
+            pos += query.size();
+        }
+        return matches;
+    }));
+}
+
+void VirtualTextView::findNext(bool backward) {
+    if (m_matches.isEmpty()) return;
+    int count = m_matches.size();
+    if (m_currentMatch < 0) {
+        m_currentMatch = backward ? count - 1 : 0;
+    } else {
+        m_currentMatch = (m_currentMatch + (backward ? count - 1 : 1)) % count;
+    }
+    scrollToOffset(m_matches.at(m_currentMatch));
+    emit matchesChanged(m_currentMatch, count);
+    viewport()->update();
+}
+
+QString VirtualTextView::selectedText() const {
+    if (m_anchor < 0 || m_cursor < 0 || m_anchor == m_cursor) return QString();
+    return m_text.mid(qMin(m_anchor, m_cursor), qAbs(m_cursor - m_anchor));
+}
+
+void VirtualTextView::selectAll() {
+    m_anchor = 0;
+    m_cursor = m_text.size();
+    viewport()->update();
+}
+
+int VirtualTextView::gutterWidth() const {
+    int digits = QString::number(qMax(1, m_index.lineCount())).size();
+    return digits * m_charWidth + 16;
+}
+
+int VirtualTextView::visibleLineCount() const {
+    return viewport()->height() / m_lineHeight + 1;
+}
+
+void VirtualTextView::updateScrollBars() {
+    if (!m_indexed) return;
+    int fullLines = qMax(1, viewport()->height() / m_lineHeight);
+    verticalScrollBar()->setRange(0, qMax(0, m_index.lineCount() - fullLines));
+    verticalScrollBar()->setPageStep(fullLines);
+
+    int textWidth = qMax(1, viewport()->width() - gutterWidth());
+    qint64 contentWidth = (m_index.maxLineLength() + 2) * static_cast<qint64>(m_charWidth);
+    horizontalScrollBar()->setRange(0, static_cast<int>(qBound<qint64>(0, contentWidth - textWidth, INT_MAX)));
+    horizontalScrollBar()->setPageStep(textWidth);
+    horizontalScrollBar()->setSingleStep(m_charWidth);
+}
+
+VirtualTextView::VisualLine VirtualTextView::visualLine(int line, int firstColumn, int columnCount) const {
+    VisualLine visual;
+    qsizetype start = m_index.lineStart(line);
+    qsizetype length = m_index.lineLength(line);
+    if (length > 0 && m_text.at(start + length - 1) == u'\r') --length;
+    QStringView raw = QStringView(m_text).mid(start, length);
+
+    if (length > MAX_EXPAND_LENGTH) {
+        // 超长行（如压缩过的 JSON）按等宽近似，只取可见片段
+        visual.base = qMin<qsizetype>(firstColumn, length);
+        visual.text = raw.mid(visual.base, qMin<qsizetype>(columnCount, length - visual.base));
+        visual.x.resize(visual.text.size() + 1);
+        for (int i = 0; i <= visual.text.size(); ++i) visual.x[i] = (visual.base + i) * m_charWidth;
+        return visual;
+    }
+
+    // 按实际字宽累加：中文等全角字符在等宽字体中也占两列左右
+    QFontMetricsF metrics(font());
+    const qreal tabWidth = TAB_WIDTH * m_charWidth;
+    visual.text = raw;
+    visual.x.resize(length + 1);
+    qreal x = 0;
+    for (qsizetype i = 0; i < length; ++i) {
+        visual.x[i] = x;
+        QChar ch = raw.at(i);
+        if (ch == u'\t') {
+            x = (std::floor(x / tabWidth) + 1) * tabWidth;
+        } else if (ch.isHighSurrogate() && i + 1 < length) {
+            x += metrics.horizontalAdvance(raw.mid(i, 2).toString());
+        } else if (!ch.isLowSurrogate()) {
+            x += metrics.horizontalAdvance(ch);
+        }
+    }
+    visual.x[length] = x;
+    return visual;
+}
+
+qreal VirtualTextView::VisualLine::xFor(qsizetype offset) const {
+    qsizetype index = qBound<qsizetype>(0, offset - base, x.size() - 1);
+    return x.at(index);
+}
+
+QVector<VirtualTextView::Span> VirtualTextView::highlightLine(int line) {
+    if (QVector<Span> *cached = m_highlightCache.object(line)) return *cached;
+
+    TRACE_SCOPE("textPreview.highlight");
+    QVector<Span> spans;
+    qsizetype length = m_index.lineLength(line);
+    QStringView raw = QStringView(m_text).mid(m_index.lineStart(line), length);
+
+    qsizetype i = 0;
+    while (i < length) {
+        QChar ch = raw.at(i);
+        if (ch == u'"' || ch == u'\'') {
+            qsizetype j = i + 1;
+            while (j < length && raw.at(j) != ch) j += (raw.at(j) == u'\\') ? 2 : 1;
+            j = qMin(j + 1, length);
+            // 后面紧跟冒号的字符串视为 JSON 键
+            qsizetype k = j;
+            while (k < length && raw.at(k).isSpace()) ++k;
+            bool key = k < length && raw.at(k) == u':';
+            spans.append({static_cast<int>(i), static_cast<int>(j - i), key ? KEY_COLOR : STRING_COLOR});
+            i = j;
+        } else if ((ch == u'/' && i + 1 < length && raw.at(i + 1) == u'/') ||
+                   (ch == u'#' && (i == 0 || raw.at(i - 1).isSpace()))) {
+            spans.append({static_cast<int>(i), static_cast<int>(length - i), COMMENT_COLOR});
+            break;
+        } else if (ch.isDigit() || (ch == u'-' && i + 1 < length && raw.at(i + 1).isDigit())) {
+            qsizetype j = i + 1;
+            while (j < length && (raw.at(j).isLetterOrNumber() || raw.at(j) == u'.')) ++j;
+            spans.append({static_cast<int>(i), static_cast<int>(j - i), NUMBER_COLOR});
+            i = j;
+        } else if (ch.isLetter() || ch == u'_') {
+            qsizetype j = i + 1;
+            while (j < length && (raw.at(j).isLetterOrNumber() || raw.at(j) == u'_')) ++j;
+            if (isKeyword(raw.mid(i, j - i))) {
+                spans.append({static_cast<int>(i), static_cast<int>(j - i), KEYWORD_COLOR});
+            }
+            i = j;
+        } else {
+            ++i;
+        }
+    }
+
+    m_highlightCache.insert(line, new QVector<Span>(spans));
+    return spans;
+}
+
+void VirtualTextView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    TRACE_SCOPE("textPreview.paint");
+    QPainter painter(viewport());
+    painter.fillRect(viewport()->rect(), Qt::white);
+
+    if (!m_indexed) {
+        painter.setPen(QColor("#666666"));
+        painter.drawText(viewport()->rect(), Qt::AlignCenter, "正在建立索引...");
+        return;
+    }
+
+    const int gutter = gutterWidth();
+    const int width = viewport()->width();
+    const int hScroll = horizontalScrollBar()->value();
+    const int firstLine = verticalScrollBar()->value();
+    const int lastLine = qMin(m_index.lineCount() - 1, firstLine + visibleLineCount());
+    const int firstColumn = hScroll / m_charWidth;
+    const int columnCount = (width - gutter) / m_charWidth + 2;
+    const qreal originX = gutter - hScroll;
+    const int ascent = QFontMetrics(font()).ascent();
+    const qsizetype selStart = qMin(m_anchor, m_cursor);
+    const qsizetype selEnd = qMax(m_anchor, m_cursor);
+    const qsizetype currentMatch = m_currentMatch >= 0 ? m_matches.at(m_currentMatch) : -1;
+
+    painter.save();
+    painter.setClipRect(gutter, 0, width - gutter, viewport()->height());
+
+    for (int line = firstLine; line <= lastLine; ++line) {
+        const int y = (line - firstLine) * m_lineHeight;
+        const qsizetype lineStart = m_index.lineStart(line);
+        VisualLine visual = visualLine(line, firstColumn, columnCount);
+        auto spanRect = [&](qsizetype from, qsizetype to) {
+            qreal x0 = originX + visual.xFor(from);
+            qreal x1 = originX + visual.xFor(to);
+            return QRectF(x0, y, qMax<qreal>(x1 - x0, 2), m_lineHeight);
+        };
+
+        // 选区
+        if (selStart >= 0 && selStart != selEnd) {
+            qsizetype lineEnd = lineStart + m_index.lineLength(line);
+            if (selStart <= lineEnd && selEnd >= lineStart) {
+                painter.fillRect(spanRect(qMax(selStart, lineStart) - lineStart,
+                                          qMin(selEnd, lineEnd) - lineStart), SELECTION_COLOR);
+            }
+        }
+
+        // 可见行内的搜索匹配
+        if (!m_query.isEmpty()) {
+            qsizetype pos = 0;
+            while ((pos = visual.text.indexOf(m_query, pos, Qt::CaseInsensitive)) >= 0) {
+                qsizetype offset = visual.base + pos;
+                bool current = lineStart + offset == currentMatch;
+                painter.fillRect(spanRect(offset, offset + m_query.size()),
+                                 current ? CURRENT_MATCH_COLOR : MATCH_COLOR);
+                pos += m_query.size();
+            }
+        }
+
+        // 文本按颜色分段绘制，遇到制表符断开，每段定位到实际横坐标
+        QVector<Span> spans;
+        if (m_highlighting && m_index.lineLength(line) <= MAX_EXPAND_LENGTH) {
+            spans = highlightLine(line);
+        }
+        auto drawRun = [&](qsizetype from, qsizetype to, const QColor& color) {
+            from = qMax<qsizetype>(from - visual.base, 0);
+            to = qMin<qsizetype>(to - visual.base, visual.text.size());
+            painter.setPen(color);
+            qsizetype runStart = from;
+            for (qsizetype i = from; i <= to; ++i) {
+                if (i < to && visual.text.at(i) != u'\t') continue;
+                if (i > runStart && originX + visual.x.at(i) >= gutter && originX + visual.x.at(runStart) <= width) {
+                    painter.drawText(QPointF(originX + visual.x.at(runStart), y + ascent),
+                                     visual.text.mid(runStart, i - runStart).toString());
+                }
+                runStart = i + 1;
+            }
+        };
+        qsizetype pos = visual.base;
+        const qsizetype end = visual.base + visual.text.size();
+        for (const auto& span : spans) {
+            if (span.start > pos) drawRun(pos, span.start, Qt::black);
+            drawRun(span.start, span.start + span.length, span.color);
+            pos = span.start + span.length;
+        }
+        if (pos < end) drawRun(pos, end, Qt::black);
+    }
+    painter.restore();
+
+    // 行号栏
+    painter.fillRect(0, 0, gutter, viewport()->height(), QColor("#F5F5F5"));
+    painter.setPen(QColor("#9E9E9E"));
+    for (int line = firstLine; line <= lastLine; ++line) {
+        int y = (line - firstLine) * m_lineHeight;
+        painter.drawText(QRect(0, y, gutter - 8, m_lineHeight), Qt::AlignRight | Qt::AlignVCenter,
+                         QString::number(line + 1));
+    }
+}
+
+void VirtualTextView::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+qsizetype VirtualTextView::offsetAt(const QPoint& point) const {
+    if (!m_indexed) return 0;
+    int line = qBound(0, verticalScrollBar()->value() + point.y() / m_lineHeight, m_index.lineCount() - 1);
+    const int gutter = gutterWidth();
+    const int hScroll = horizontalScrollBar()->value();
+    VisualLine visual = visualLine(line, hScroll / m_charWidth, (viewport()->width() - gutter) / m_charWidth + 2);
+
+    // 取离点击位置最近的字符边界
+    qreal x = point.x() - gutter + hScroll;
+    auto it = std::lower_bound(visual.x.begin(), visual.x.end(), x);
+    qsizetype index = it - visual.x.begin();
+    if (index >= visual.x.size()) {
+        index = visual.x.size() - 1;
+    } else if (index > 0 && x - visual.x.at(index - 1) < visual.x.at(index) - x) {
+        --index;
+    }
+    return m_index.lineStart(line) + visual.base + index;
+}
+
+void VirtualTextView::scrollToOffset(qsizetype offset) {
+    if (!m_indexed) return;
+    int line = m_index.lineForOffset(offset);
+    int first = verticalScrollBar()->value();
+    int fullLines = qMax(1, viewport()->height() / m_lineHeight);
+    if (line < first || line >= first + fullLines) {
+        verticalScrollBar()->setValue(line - fullLines / 2);
+    }
+
+    // 超长行按等宽换算，避免为整行计算字宽
+    qsizetype inLine = offset - m_index.lineStart(line);
+    int x = m_index.lineLength(line) > MAX_EXPAND_LENGTH ?
+                static_cast<int>(qMin<qsizetype>(inLine * m_charWidth, INT_MAX)) :
+                static_cast<int>(visualLine(line, 0, 0).xFor(inLine));
+    int textWidth = viewport()->width() - gutterWidth();
+    int hScroll = horizontalScrollBar()->value();
+    if (x < hScroll || x > hScroll + textWidth - 4 * m_charWidth) {
+        horizontalScrollBar()->setValue(x - textWidth / 3);
+    }
+}
+
+void VirtualTextView::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    m_anchor = m_cursor = offsetAt(event->position().toPoint());
+    viewport()->update();
+}
+
+void VirtualTextView::mouseMoveEvent(QMouseEvent *event) {
+    if (!(event->buttons() & Qt::LeftButton) || m_anchor < 0) return;
+    m_cursor = offsetAt(event->position().toPoint());
+    viewport()->update();
+}
+
+void VirtualTextView::keyPressEvent(QKeyEvent *event) {
+    if (event->matches(QKeySequence::Copy)) {
+        QString selected = selectedText();
+        if (!selected.isEmpty()) QApplication::clipboard()->setText(selected);
+        return;
+    }
+    if (event->matches(QKeySequence::SelectAll)) {
+        selectAll();
+        return;
+    }
+    if (event->matches(QKeySequence::MoveToStartOfDocument)) {
+        verticalScrollBar()->setValue(0);
+        return;
+    }
+    if (event->matches(QKeySequence::MoveToEndOfDocument)) {
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+        return;
+    }
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+TextPreview::TextPreview(QWidget *parent)
+    : QWidget(parent)
+    , m_search(new QLineEdit)
+    , m_count(new QLabel)
+    , m_formatButton(new QPushButton)
+    , m_copyFormatted(new QPushButton("复制格式化结果"))
+    , m_view(new VirtualTextView)
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(20, 10, 20, 20);
+    layout->setSpacing(8);
+
+    auto *searchBar = new QHBoxLayout;
+    m_search->setObjectName(Theme::PreviewSearch);
+    m_search->setPlaceholderText("搜索（Enter 下一个，Shift+Enter 上一个）");
+    m_search->setClearButtonEnabled(true);
+    m_count->setObjectName(Theme::PreviewSearchCount);
+    m_formatButton->setObjectName(Theme::PreviewToolButton);
+    m_formatButton->setCheckable(true);
+    m_formatButton->hide();
+    m_copyFormatted->setObjectName(Theme::PreviewToolButton);
+    m_copyFormatted->hide();
+    searchBar->addWidget(m_search);
+    searchBar->addWidget(m_count);
+    searchBar->addWidget(m_formatButton);
+    searchBar->addWidget(m_copyFormatted);
+
+    layout->addLayout(searchBar);
+    layout->addWidget(m_view);
+
+    connect(m_search, &QLineEdit::textChanged, m_view, &VirtualTextView::setSearchQuery);
+    connect(m_search, &QLineEdit::returnPressed, this, [this]() {
+        m_view->findNext(QGuiApplication::keyboardModifiers() & Qt::ShiftModifier);
+    });
+    connect(m_view, &VirtualTextView::matchesChanged, this, [this](int current, int total) {
+        if (m_search->text().isEmpty()) {
+            m_count->clear();
+        } else if (total == 0) {
+            m_count->setText("无匹配");
+        } else {
+            m_count->setText(QString("%1/%2").arg(current + 1).arg(total));
+        }
+    });
+
+    connect(m_formatButton, &QPushButton::toggled, this, [this](bool checked) {
+        QSettings settings;
+        settings.setValue("preview/prettyPrint", checked);
+        setFormatted(checked);
+    });
+    connect(m_copyFormatted, &QPushButton::clicked, this, [this]() {
+        QGuiApplication::clipboard()->setText(m_view->text());
+        emit formattedCopied();
+    });
+
+    auto *findShortcut = new QShortcut(QKeySequence::Find, this);
+    connect(findShortcut, &QShortcut::activated, this, [this]() {
+        m_search->setFocus();
+        m_search->selectAll();
+    });
+}
+
+TextPreview::~TextPreview() {
+    // 工作线程向 this 投递结果，析构前等它退出（最多再处理一段）
+    cancelFormatting();
+}
+
+void TextPreview::setText(const QString& text) {
+    m_original = text;
+    m_format = PrettyPrinter::detect(text);
+    m_formatButton->setVisible(m_format != PrettyPrinter::Plain);
+    m_formatButton->setText("格式化 " + PrettyPrinter::formatName(m_format));
+
+    QSettings settings;
+    bool formatted = m_format != PrettyPrinter::Plain && settings.value("preview/prettyPrint", false).toBool();
+    {
+        QSignalBlocker blocker(m_formatButton);
+        m_formatButton->setChecked(formatted);
+    }
+    setFormatted(formatted);
+}
+
+void TextPreview::setFormatted(bool formatted) {
+    cancelFormatting();
+    m_formatted = formatted && m_format != PrettyPrinter::Plain;
+    m_copyFormatted->setVisible(m_formatted);
+    m_copyFormatted->setEnabled(false);
+    emit formattedChanged(m_formatted);
+
+    if (!m_formatted) {
+        m_view->setText(m_original);
+        return;
+    }
+
+    m_view->setText(QString());
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    m_formatCancelled = cancelled;
+    m_formatFuture = QtConcurrent::run([this, source = m_original, format = m_format, cancelled]() {
+        PrettyPrinter printer(format);
+        qsizetype pos = 0;
+        bool done = false;
+        while (!done && !cancelled->load()) {
+            QString out;
+            {
+                TRACE_SCOPE("prettyPrinter.chunk");
+                QStringView chunk = QStringView(source).mid(pos, pos == 0 ? FIRST_CHUNK_CHARS : CHUNK_CHARS);
+                out.reserve(chunk.size() + chunk.size() / 2);
+                printer.feed(chunk, out);
+                pos += chunk.size();
+                done = pos >= source.size();
+                if (done) printer.finish(out);
+            }
+            QMetaObject::invokeMethod(this, [this, out, done, cancelled]() {
+                if (cancelled->load()) return;
+                m_view->appendText(out);
+                if (done) m_copyFormatted->setEnabled(true);
+            }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void TextPreview::cancelFormatting() {
+    if (m_formatCancelled) m_formatCancelled->store(true);
+    m_formatFuture.waitForFinished();
+}
@@ -0,0 +1,150 @@
+// textpreview.h
+#ifndef TEXTPREVIEW_H
+#define TEXTPREVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QCache>
+#include <QColor>
+#include <QFutureWatcher>
+#include <QList>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+#include <atomic>
+#include <memory>
+#include "../lineindex.h"
+#include "../prettyprinter.h"
+
+class QLineEdit;
+class QLabel;
+class QPushButton;
+
+// 只读的虚拟化文本视图：行偏移表建立一次（大文本在工作线程中建立），
+// 绘制时只处理可见行。等宽字体下列号与像素位置直接换算，不做整篇排版。
+class VirtualTextView : public QAbstractScrollArea {
+    Q_OBJECT
+public:
+    explicit VirtualTextView(QWidget *parent = nullptr);
+
+    void setText(const QString& text);
+    // 在末尾追加，保持滚动位置和选区；格式化结果逐段输出时使用
+    void appendText(QStringView text);
+    QString text() const { return m_text; }
+
+    // 语法高亮只作用于可见行，按行独立着色（不跨行追踪字符串或注释状态）
+    void setHighlighting(bool enabled);
+    bool highlighting() const { return m_highlighting; }
+
+    // 可见行立即高亮；全文匹配位置在工作线程中收集，用于计数和跳转
+    void setSearchQuery(const QString& query);
+    void findNext(bool backward = false);
+    int matchCount() const { return m_matches.size(); }
+
+    QString selectedText() const;
+    void selectAll();
+
+signals:
+    void matchesChanged(int current, int total);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    struct Span {
+        int start;
+        int length;
+        QColor color;
+    };
+
+    // 一行的显示形式：text 为行内从 base 开始的字符（超长行只取可见片段），
+    // x[i] 为 text[i] 左边缘相对行首的横坐标，制表符和全角字符按实际宽度计算
+    struct VisualLine {
+        QStringView text;
+        qsizetype base = 0;
+        QVector<qreal> x;
+        qreal xFor(qsizetype offset) const;
+    };
+
+    void onIndexed(const LineIndex& index);
+    void updateScrollBars();
+    void startSearch();
+    void scrollToOffset(qsizetype offset);
+    VisualLine visualLine(int line, int firstColumn, int columnCount) const;
+    QVector<Span> highlightLine(int line);
+    qsizetype offsetAt(const QPoint& point) const;
+    int gutterWidth() const;
+    int visibleLineCount() const;
+
+    QString m_text;
+    LineIndex m_index;
+    bool m_indexed = false;
+    quint64 m_generation = 0;   // 每次 setText 递增，丢弃过期的索引和搜索结果
+    quint64 m_indexGeneration = 0;
+    quint64 m_searchGeneration = 0;
+    QFutureWatcher<LineIndex> m_indexWatcher;
+
+    bool m_highlighting = true;
+    QCache<int, QVector<Span>> m_highlightCache;
+
+    QString m_query;
+    QList<qsizetype> m_matches;
+    int m_currentMatch = -1;
+    QTimer m_searchDebounce;
+    QFutureWatcher<QList<qsizetype>> m_searchWatcher;
+
+    qsizetype m_anchor = -1;     // 选区
+    qsizetype m_cursor = -1;
+
+    int m_charWidth = 8;
+    int m_lineHeight = 16;
+
+    static const int TAB_WIDTH = 4;
+    static const int MAX_EXPAND_LENGTH = 4096;       // 超长行不展开制表符、不做高亮
+    static const qsizetype SYNC_INDEX_CHARS = 256 * 1024;
+    static const int MAX_MATCHES = 100000;
+};
+
+// 预览窗口的文本区：搜索框 + 匹配计数 + VirtualTextView。
+// 识别出 JSON/XML/转义日志时可切换到格式化视图：PrettyPrinter 在工作线程中
+// 分段处理，每段结果立即追加到视图，首屏不必等整篇格式化完成。
+class TextPreview : public QWidget {
+    Q_OBJECT
+public:
+    explicit TextPreview(QWidget *parent = nullptr);
+    ~TextPreview() override;
+
+    void setText(const QString& text);
+    VirtualTextView* view() const { return m_view; }
+
+    PrettyPrinter::Format detectedFormat() const { return m_format; }
+    bool isFormatted() const { return m_formatted; }
+    void setFormatted(bool formatted);
+
+signals:
+    void formattedChanged(bool formatted);
+    void formattedCopied();
+
+private:
+    void cancelFormatting();
+
+    QLineEdit *m_search;
+    QLabel *m_count;
+    QPushButton *m_formatButton;
+    QPushButton *m_copyFormatted;   // 原文由标题栏的复制按钮复制
+    VirtualTextView *m_view;
+
+    QString m_original;
+    PrettyPrinter::Format m_format = PrettyPrinter::Plain;
+    bool m_formatted = false;
+    QFuture<void> m_formatFuture;
+    std::shared_ptr<std::atomic<bool>> m_formatCancelled;
+
+    static const qsizetype FIRST_CHUNK_CHARS = 16 * 1024;   // 首段小一些，尽快出首屏
+    static const qsizetype CHUNK_CHARS = 256 * 1024;
+};
+
+#endif // TEXTPREVIEW_H
@@ -0,0 +1,243 @@
+// theme.cpp
+#include "theme.h"
+#include "../tracer.h"
+#include <QApplication>
+
+void Theme::install(QApplication *app) {
+    TRACE_SCOPE("theme.install");
+    app->setStyleSheet(styleSheet());
+}
+
+QColor Theme::rowBackground(bool pinned) {
+    return pinned ? QColor("#FFF8E1") : QColor("#F8F9FA");
+}
+
+QString Theme::styleSheet() {
+    return QStringLiteral(R"(
+        /* 左侧面板 */
+        QWidget#leftPanel {
+            background-color: #4B8BF4;
+        }
+        QLabel#panelTitle {
+            color: white;
+            font-size: 16px;
+            font-weight: bold;
+        }
+        QLabel#panelDescription {
+            color: rgba(255,255,255,0.8);
+            font-size: 12px;
+        }
+        QLabel#panelIcon {
+            margin-bottom: 10px;
+        }
+        QPushButton#categoryButton {
+            color: white;
+            border: none;
+            text-align: left;
+            padding: 15px 20px;
+            font-size: 14px;
+        }
+        QPushButton#categoryButton:hover {
+            background-color: rgba(255,255,255,0.1);
+        }
+        QPushButton#categoryButton:checked {
+            background-color: rgba(255,255,255,0.2);
+        }
+        QComboBox#filterCombo {
+            color: white;
+            background-color: rgba(255,255,255,0.1);
+            border: none;
+            border-radius: 4px;
+            padding: 6px 10px;
+            margin: 4px 20px;
+        }
+        QCheckBox#autoStartCheck {
+            color: white;
+            padding: 10px 20px;
+        }
+        QPushButton#clearButton, QPushButton#exportButton, QPushButton#deleteButton {
+            color: white;
+            border: none;
+            padding: 10px;
+            border-radius: 4px;
+        }
+        QPushButton#clearButton {
+            background-color: #E34133;
+            margin: 10px 20px;
+        }
+        QPushButton#clearButton:hover {
+            background-color: #D03126;
+        }
+        QPushButton#exportButton {
+            background-color: #1A73E8;
+            margin: 0px 20px;
+        }
+        QPushButton#exportButton:hover {
+            background-color: #1765CC;
+        }
+        QPushButton#deleteButton {
+            background-color: #5F6368;
+            margin: 10px 20px 0px 20px;
+        }
+        QPushButton#deleteButton:hover {
+            background-color: #4A4E52;
+        }
+
+        /* 历史列表 */
+        QListWidget#historyList {
+            background-color: white;
+            border: none;
+        }
+        QListWidget#historyList::item {
+            background-color: #F8F9FA;
+            border-radius: 6px;
+            margin-bottom: 10px;
+        }
+        QListWidget#historyList::item:hover {
+            background-color: #E9ECEF;
+        }
+        QListWidget#historyList::item:selected {
+            background-color: #E2E6EA;
+        }
+        QPushButton#rowButton, QPushButton#rowPinButton {
+            color: white;
+            border: none;
+            padding: 5px 10px;
+            border-radius: 4px;
+        }
+        QPushButton#rowButton {
+            background-color: #4B8BF4;
+        }
+        QPushButton#rowButton:hover {
+            background-color: #357ABD;
+        }
+        QPushButton#rowPinButton {
+            background-color: #F4B400;
+        }
+        QPushButton#rowPinButton:hover {
+            background-color: #DB9F00;
+        }
+
+        /* 预览窗口 */
+        QWidget#previewContainer {
+            background: white;
+            border-radius: 8px;
+        }
+        QWidget#previewTitleBar {
+            background: #4B8BF4;
+            border-radius: 8px 8px 0 0;
+        }
+        QLabel#previewTitle {
+            color: white;
+            font-size: 14px;
+        }
+        QPushButton#previewCopyButton {
+            background: rgba(255,255,255,0.2);
+            color: white;
+            border: none;
+            padding: 5px 15px;
+            border-radius: 4px;
+        }
+        QPushButton#previewCopyButton:hover {
+            background: rgba(255,255,255,0.3);
+        }
+        QPushButton#previewCloseButton {
+            color: white;
+            border: none;
+            font-size: 20px;
+            padding: 5px 15px;
+        }
+        QPushButton#previewCloseButton:hover {
+            background: rgba(255,255,255,0.1);
+        }
+        #previewContent {
+            background: white;
+            padding: 20px;
+        }
+        QLineEdit#previewSearch {
+            background: white;
+            border: 1px solid #DDDDDD;
+            border-radius: 4px;
+            padding: 4px 8px;
+        }
+        QLineEdit#previewSearch:focus {
+            border-color: #4B8BF4;
+        }
+        QLabel#previewSearchCount {
+            color: #666666;
+            padding: 0 4px;
+        }
+        QPushButton#previewToolButton {
+            background-color: #F5F5F5;
+            color: #333333;
+            border: 1px solid #DDDDDD;
+            border-radius: 4px;
+            padding: 4px 12px;
+        }
+        QPushButton#previewToolButton:hover {
+            background-color: #EBEBEB;
+        }
+        QPushButton#previewToolButton:checked {
+            background-color: #4B8BF4;
+            color: white;
+            border-color: #4B8BF4;
+        }
+        QPushButton#previewToolButton:disabled {
+            color: #AAAAAA;
+        }
+
+        /* 提示对话框 */
+        CustomDialog {
+            background-color: white;
+            border: 1px solid #CCCCCC;
+            border-radius: 8px;
+        }
+        CustomDialog QLabel {
+            color: #333333;
+        }
+        QWidget#dialogTitleBar {
+            background: #4B8BF4;
+            border-top-left-radius: 8px;
+            border-top-right-radius: 8px;
+        }
+        QLabel#dialogTitle {
+            color: white;
+            font-size: 14px;
+            font-weight: bold;
+        }
+        QLabel#dialogMessage {
+            font-size: 13px;
+            line-height: 1.5;
+        }
+        QPushButton#dialogPrimaryButton, QPushButton#dialogDangerButton, QPushButton#dialogSecondaryButton {
+            border-radius: 4px;
+            padding: 5px 15px;
+            min-width: 80px;
+            font-size: 13px;
+        }
+        QPushButton#dialogPrimaryButton {
+            background-color: #4B8BF4;
+            color: white;
+            border: none;
+        }
+        QPushButton#dialogPrimaryButton:hover {
+            background-color: #357ABD;
+        }
+        QPushButton#dialogDangerButton {
+            background-color: #E34133;
+            color: white;
+            border: none;
+        }
+        QPushButton#dialogDangerButton:hover {
+            background-color: #D03126;
+        }
+        QPushButton#dialogSecondaryButton {
+            background-color: #F5F5F5;
+            color: #333333;
+            border: 1px solid #DDDDDD;
+        }
+        QPushButton#dialogSecondaryButton:hover {
+            background-color: #EBEBEB;
+        }
+    )");
+}
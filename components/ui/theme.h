@@ -0,0 +1,55 @@
+// theme.h
+#ifndef THEME_H
+#define THEME_H
+
+#include <QColor>
+#include <QString>
+
+class QApplication;
+
+// 应用级主题：所有控件样式集中在一份样式表中，启动时解析一次。
+// 控件只设置 objectName 由选择器匹配，创建时不再调用 setStyleSheet；
+// 列表行由 HistoryRow 直接绘制背景，不经过样式表。
+class Theme {
+public:
+    static void install(QApplication *app);
+    static QString styleSheet();
+
+    // 列表行颜色
+    static QColor rowBackground(bool pinned);
+
+    // 各控件使用的 objectName
+    static constexpr const char *LeftPanel = "leftPanel";
+    static constexpr const char *PanelTitle = "panelTitle";
+    static constexpr const char *PanelDescription = "panelDescription";
+    static constexpr const char *PanelIcon = "panelIcon";
+    static constexpr const char *CategoryButton = "categoryButton";
+    static constexpr const char *FilterCombo = "filterCombo";
+    static constexpr const char *AutoStartCheck = "autoStartCheck";
+    static constexpr const char *ClearButton = "clearButton";
+    static constexpr const char *ExportButton = "exportButton";
+    static constexpr const char *DeleteButton = "deleteButton";
+    static constexpr const char *HistoryList = "historyList";
+    static constexpr const char *RowButton = "rowButton";
+    static constexpr const char *RowPinButton = "rowPinButton";
+    static constexpr const char *PreviewContainer = "previewContainer";
+    static constexpr const char *PreviewTitleBar = "previewTitleBar";
+    static constexpr const char *PreviewTitle = "previewTitle";
+    static constexpr const char *PreviewCopyButton = "previewCopyButton";
+    static constexpr const char *PreviewCloseButton = "previewCloseButton";
+    static constexpr const char *PreviewContent = "previewContent";
+    static constexpr const char *PreviewSearch = "previewSearch";
+    static constexpr const char *PreviewSearchCount = "previewSearchCount";
+    static constexpr const char *PreviewToolButton = "previewToolButton";
+    static constexpr const char *DialogTitleBar = "dialogTitleBar";
+    static constexpr const char *DialogTitle = "dialogTitle";
+    static constexpr const char *DialogMessage = "dialogMessage";
+    static constexpr const char *DialogPrimaryButton = "dialogPrimaryButton";
+    static constexpr const char *DialogDangerButton = "dialogDangerButton";
+    static constexpr const char *DialogSecondaryButton = "dialogSecondaryButton";
+
+private:
+    Theme() = delete;
+};
+
+#endif // THEME_H
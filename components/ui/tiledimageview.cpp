@@ -0,0 +1,238 @@
+// tiledimageview.cpp
+#include "tiledimageview.h"
+#include "../imagepyramid.h"
+#include "../tracer.h"
+#include <QPainter>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QKeyEvent>
+#include <QDebug>
+#include <cmath>
+
+TiledImageView::TiledImageView(QWidget *parent)
+    : QWidget(parent)
+    , m_tiles(TILE_CACHE_KB)
+{
+    setFocusPolicy(Qt::StrongFocus);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(200, 150);
+}
+
+void TiledImageView::resetPyramid() {
+    delete m_pyramid;
+    m_tiles.clear();
+    m_pyramid = new ImagePyramid(this);
+    connect(m_pyramid, &ImagePyramid::levelReady, this, [this](int level) {
+        // 加载前尺寸未知时按 1.0 显示，第 0 层就绪后重新适应窗口
+        if (level == 0 && m_fit) {
+            fitToView();
+        } else {
+            update();
+        }
+    });
+    connect(m_pyramid, &ImagePyramid::failed, this, [this](const QString& error) {
+        qDebug() << error;
+        update();
+    });
+}
+
+void TiledImageView::setSource(const QString& path, const QPixmap& placeholder) {
+    resetPyramid();
+    m_placeholder = placeholder;
+    m_pyramid->load(path);
+    fitToView();
+}
+
+void TiledImageView::setImage(const QImage& image, const QPixmap& placeholder) {
+    resetPyramid();
+    m_placeholder = placeholder;
+    m_pyramid->setImage(image);
+    fitToView();
+}
+
+qreal TiledImageView::fitScale() const {
+    if (!m_pyramid || m_pyramid->size().isEmpty()) return 1.0;
+    QSize size = m_pyramid->size();
+    // 小图不放大，保持像素清晰
+    return qMin<qreal>(1.0, qMin(static_cast<qreal>(width()) / size.width(),
+                                 static_cast<qreal>(height()) / size.height()));
+}
+
+void TiledImageView::fitToView() {
+    m_fit = true;
+    m_scale = fitScale();
+    clampOffset();
+    update();
+}
+
+void TiledImageView::setZoom(qreal scale, const QPointF& anchor) {
+    if (!m_pyramid || m_pyramid->size().isEmpty()) return;
+    scale = qBound(fitScale(), scale, MAX_ZOOM);
+    // 保持锚点下的图像位置不动
+    QPointF imagePoint = (anchor - m_offset) / m_scale;
+    m_scale = scale;
+    m_offset = anchor - imagePoint * m_scale;
+    m_fit = false;
+    clampOffset();
+    update();
+}
+
+void TiledImageView::clampOffset() {
+    if (!m_pyramid) return;
+    QSizeF shown = QSizeF(m_pyramid->size()) * m_scale;
+    auto clampAxis = [](qreal offset, qreal shownLength, qreal viewLength) {
+        // 图片比视口小时居中，否则不允许拖出边界
+        if (shownLength <= viewLength) return (viewLength - shownLength) / 2;
+        return qBound(viewLength - shownLength, offset, 0.0);
+    };
+    m_offset.setX(clampAxis(m_offset.x(), shown.width(), width()));
+    m_offset.setY(clampAxis(m_offset.y(), shown.height(), height()));
+}
+
+int TiledImageView::drawLevel(int wanted) const {
+    // 层从第 0 层开始连续生成，缺少时只可能有更精细的层
+    for (int level = wanted; level >= 0; --level) {
+        if (m_pyramid->hasLevel(level)) return level;
+    }
+    return -1;
+}
+
+void TiledImageView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    TRACE_SCOPE("preview.paint");
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+    if (!m_pyramid || m_pyramid->size().isEmpty()) return;
+
+    QRectF imageRect(m_offset, QSizeF(m_pyramid->size()) * m_scale);
+    int wanted = ImagePyramid::levelForScale(m_scale, m_pyramid->levelCount());
+    int level = drawLevel(wanted);
+    if (level != wanted) m_pyramid->requestLevel(wanted);
+
+    // 放大查看时显示原始像素
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, m_scale < 2.0);
+
+    // 只有比目标精细很多的层时，转换大量分块不划算，先用缩略图顶替
+    bool usePlaceholder = level < 0 || (wanted - level > 1 && !m_placeholder.isNull());
+    if (usePlaceholder) {
+        if (!m_placeholder.isNull()) painter.drawPixmap(imageRect, m_placeholder, m_placeholder.rect());
+        return;
+    }
+    drawTiles(painter, level, imageRect);
+}
+
+void TiledImageView::drawTiles(QPainter& painter, int level, const QRectF& imageRect) {
+    const QImage source = m_pyramid->level(level);
+    if (source.isNull()) return;
+
+    QRectF visible = imageRect.intersected(QRectF(rect()));
+    if (visible.isEmpty()) return;
+
+    // 屏幕像素 / 层像素
+    const qreal fx = imageRect.width() / source.width();
+    const qreal fy = imageRect.height() / source.height();
+    const int tile = ImagePyramid::TILE_SIZE;
+    const int columns = (source.width() + tile - 1) / tile;
+    const int rows = (source.height() + tile - 1) / tile;
+
+    int c0 = qBound(0, static_cast<int>((visible.left() - imageRect.left()) / fx) / tile, columns - 1);
+    int c1 = qBound(0, static_cast<int>((visible.right() - imageRect.left()) / fx) / tile, columns - 1);
+    int r0 = qBound(0, static_cast<int>((visible.top() - imageRect.top()) / fy) / tile, rows - 1);
+    int r1 = qBound(0, static_cast<int>((visible.bottom() - imageRect.top()) / fy) / tile, rows - 1);
+
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            QRect tileRect = QRect(c * tile, r * tile, tile, tile) & source.rect();
+            quint64 key = (static_cast<quint64>(level) << 48) | (static_cast<quint64>(r) << 24) | c;
+
+            QPixmap *pixmap = m_tiles.object(key);
+            if (!pixmap) {
+                pixmap = new QPixmap(QPixmap::fromImage(source.copy(tileRect)));
+                int costKB = qMax(1, pixmap->width() * pixmap->height() * 4 / 1024);
+                if (!m_tiles.insert(key, pixmap, costKB)) continue;
+            }
+
+            // 边缘按整数像素对齐，避免分块之间出现缝隙
+            int x0 = qRound(imageRect.left() + tileRect.left() * fx);
+            int x1 = qRound(imageRect.left() + (tileRect.left() + tileRect.width()) * fx);
+            int y0 = qRound(imageRect.top() + tileRect.top() * fy);
+            int y1 = qRound(imageRect.top() + (tileRect.top() + tileRect.height()) * fy);
+            painter.drawPixmap(QRect(x0, y0, x1 - x0, y1 - y0), *pixmap);
+        }
+    }
+}
+
+void TiledImageView::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    if (m_fit) {
+        fitToView();
+    } else {
+        clampOffset();
+    }
+}
+
+void TiledImageView::wheelEvent(QWheelEvent *event) {
+    int delta = event->angleDelta().y();
+    if (delta == 0) {
+        QWidget::wheelEvent(event);
+        return;
+    }
+    // 触控板的细小增量同样按比例缩放，缩放是连续的
+    setZoom(m_scale * std::pow(WHEEL_STEP, delta), event->position());
+    event->accept();
+}
+
+void TiledImageView::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    m_dragging = true;
+    m_dragStart = event->position();
+    m_dragOffset = m_offset;
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void TiledImageView::mouseMoveEvent(QMouseEvent *event) {
+    if (!m_dragging) return;
+    m_offset = m_dragOffset + (event->position() - m_dragStart);
+    m_fit = false;
+    clampOffset();
+    update();
+}
+
+void TiledImageView::mouseReleaseEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton && m_dragging) {
+        m_dragging = false;
+        unsetCursor();
+    }
+}
+
+void TiledImageView::mouseDoubleClickEvent(QMouseEvent *event) {
+    if (m_fit) {
+        setZoom(1.0, event->position());
+    } else {
+        fitToView();
+    }
+}
+
+void TiledImageView::keyPressEvent(QKeyEvent *event) {
+    QPointF center = rect().center();
+    switch (event->key()) {
+    case Qt::Key_Plus:
+    case Qt::Key_Equal:
+        setZoom(m_scale * 1.25, center);
+        break;
+    case Qt::Key_Minus:
+        setZoom(m_scale / 1.25, center);
+        break;
+    case Qt::Key_0:
+        fitToView();
+        break;
+    case Qt::Key_1:
+        setZoom(1.0, center);
+        break;
+    default:
+        QWidget::keyPressEvent(event);
+    }
+}
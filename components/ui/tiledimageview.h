@@ -0,0 +1,62 @@
+// tiledimageview.h
+#ifndef TILEDIMAGEVIEW_H
+#define TILEDIMAGEVIEW_H
+
+#include <QWidget>
+#include <QCache>
+#include <QPixmap>
+#include <QPointF>
+
+class ImagePyramid;
+
+// 可缩放的大图预览：按当前缩放比例选择金字塔层，只把可见的分块转换为 QPixmap 绘制。
+// 打开时先显示列表缩略图，对应层生成后逐步替换为清晰版本。
+// 滚轮缩放（以光标为中心）、拖动平移、双击在适应窗口与 100% 之间切换。
+class TiledImageView : public QWidget {
+    Q_OBJECT
+public:
+    explicit TiledImageView(QWidget *parent = nullptr);
+
+    // placeholder 为已在内存中的缩略图，在解码完成前拉伸显示
+    void setSource(const QString& path, const QPixmap& placeholder = QPixmap());
+    void setImage(const QImage& image, const QPixmap& placeholder = QPixmap());
+
+    qreal zoom() const { return m_scale; }
+    void setZoom(qreal scale, const QPointF& anchor);
+    void fitToView();
+
+    QSize sizeHint() const override { return QSize(800, 600); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    void resetPyramid();
+    qreal fitScale() const;
+    void clampOffset();
+    int drawLevel(int wanted) const;
+    void drawTiles(QPainter& painter, int level, const QRectF& imageRect);
+
+    ImagePyramid *m_pyramid = nullptr;
+    QPixmap m_placeholder;
+    qreal m_scale = 1.0;
+    QPointF m_offset;          // 原图左上角在控件中的位置
+    bool m_fit = true;         // 随窗口大小自动适应
+    bool m_dragging = false;
+    QPointF m_dragStart;
+    QPointF m_dragOffset;
+    QCache<quint64, QPixmap> m_tiles;   // 键为 (层, 行, 列)，代价为 KB
+
+    static constexpr qreal MAX_ZOOM = 16.0;
+    static constexpr qreal WHEEL_STEP = 1.0015;   // 每 1/8 度的缩放倍数
+    static const int TILE_CACHE_KB = 64 * 1024;
+};
+
+#endif // TILEDIMAGEVIEW_H
@@ -0,0 +1,40 @@
+// toastsurface.cpp
+#include "toastsurface.h"
+#include <QPainter>
+
+ToastSurface::ToastSurface(QWidget *parent)
+    : QWidget(parent)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+    hide();
+}
+
+void ToastSurface::setText(const QString& text) {
+    m_text = text;
+    resize(sizeHint());
+    update();
+}
+
+void ToastSurface::setOpacity(qreal opacity) {
+    if (qFuzzyCompare(m_opacity, opacity)) return;
+    m_opacity = opacity;
+    update();
+}
+
+QSize ToastSurface::sizeHint() const {
+    QFontMetrics metrics(font());
+    return QSize(metrics.horizontalAdvance(m_text) + 40, metrics.height() + 20);
+}
+
+void ToastSurface::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setOpacity(m_opacity);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor("#4B8BF4"));
+    painter.drawRoundedRect(rect(), 4, 4);
+    painter.setPen(Qt::white);
+    painter.drawText(rect(), Qt::AlignCenter, m_text);
+}
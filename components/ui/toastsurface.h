@@ -0,0 +1,33 @@
+// toastsurface.h
+#ifndef TOASTSURFACE_H
+#define TOASTSURFACE_H
+
+#include <QWidget>
+#include <QString>
+
+// 窗口内复用的提示浮层：作为子控件绘制，不创建顶层窗口，
+// 透明度在 paintEvent 中直接应用，不依赖 QGraphicsOpacityEffect
+class ToastSurface : public QWidget {
+    Q_OBJECT
+    Q_PROPERTY(qreal opacity READ opacity WRITE setOpacity)
+
+public:
+    explicit ToastSurface(QWidget *parent);
+
+    void setText(const QString& text);
+    QString text() const { return m_text; }
+
+    qreal opacity() const { return m_opacity; }
+    void setOpacity(qreal opacity);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QString m_text;
+    qreal m_opacity = 1.0;
+};
+
+#endif // TOASTSURFACE_H
@@ -0,0 +1,36 @@
+// main.cpp - 后台捕获进程：只运行捕获核心和本地通信服务，不加载任何窗口组件
+#include "../components/clipboardhistory.h"
+#include "../components/ipc/historyserver.h"
+#include "../components/tracer.h"
+#include <QGuiApplication>
+#include <QDebug>
+
+int main(int argc, char *argv[]) {
+    Tracer::initFromEnvironment();
+    try {
+        QGuiApplication app(argc, argv);
+        // 与界面使用相同的应用名，共享数据目录和套接字名
+        app.setApplicationName("clipboard_manager");
+        app.setQuitOnLastWindowClosed(false);
+
+        ClipboardHistory history;
+        history.setAutoSave(true);
+
+        HistoryServer server(&history);
+        if (!server.listen()) {
+            qDebug() << "后台服务启动失败:" << server.getLastError();
+            return 1;
+        }
+
+        history.startMonitoring();
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, &history, [&history]() {
+            history.save();
+        });
+
+        qDebug() << "Capture daemon running";
+        return app.exec();
+    } catch (const std::exception& e) {
+        qDebug() << "Exception:" << e.what();
+        return 1;
+    }
+}
@@ -1,12 +1,21 @@
 // main.cpp
 #include "mainwindow.h"
+#include "../components/startupprofiler.h"
+#include "../components/tracer.h"
+#include "../components/ui/theme.h"
 #include <QApplication>
 #include <QIcon>
 
 int main(int argc, char *argv[]) {
+    StartupProfiler::markProcessStart();
+    Tracer::initFromEnvironment();
     try {
         QApplication app(argc, argv);
+        // 与后台捕获进程使用相同的应用名，共享数据目录和套接字名
+        app.setApplicationName("clipboard_manager");
         app.setWindowIcon(QIcon(":/icons/icon.ico"));
+        // 全部控件样式只在这里解析一次
+        Theme::install(&app);
         MainWindow w;
         w.show();
         qDebug() << "Window shown";
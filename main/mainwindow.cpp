@@ -13,47 +13,56 @@
 #include <QClipboard>
 #include <QMenu>
 #include <QDialog>
-#include <QTextEdit>
 #include <QApplication>
 #include <QDir>
 #include <QCoreApplication>
 #include <QScreen>
 #include <QTimer>
+#include <QFile>
 #include <QFileDialog>
+#include <QProgressDialog>
+#include <QShortcut>
+#include <QComboBox>
+#include <QStandardPaths>
+#include <QSet>
+#include <algorithm>
+#include "../components/startupprofiler.h"
+#include "../components/tracer.h"
+#include "../components/memoryaccountant.h"
+#include "../components/clipboardhistory.h"
+#include "../components/ipc/historyclient.h"
+#include "../components/ui/historyrow.h"
+#include "../components/ui/tiledimageview.h"
+#include "../components/ui/textpreview.h"
+#include "../components/ui/theme.h"
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     setWindowTitle("剪贴板历史");
     shouldSaveHistory = true;
     animationManager = new AnimationManager(this);
-    storageManager = new StorageManager(this);
-    storageManager->setCacheSize(100);
     setupUI();
-    loadHistoryFromStorage();
-    clipboard = QApplication::clipboard();
-    connect(clipboard, &QClipboard::dataChanged, this, &MainWindow::clipboardChanged);
-
-    autoStartManager = new AutoStartManager(this);
-    loadAutoStartStatus();
-
-    downloadManager = new DownloadManager(this);
+    setupHistorySource();
+    setupDiagnostics();
 
+    // 历史记录、自启动状态和下载管理器都推迟到窗口显示之后（见 showEvent）
     qDebug() << "MainWindow constructor end";
 }
 
 // mainwindow.cpp - Add to destructor
 MainWindow::~MainWindow() {
     saveHistoryToStorage();
-    clearCache();  // 先清理缓存
-    storageManager->clearCache();
+    MemoryAccountant::instance()->removeReclaimer(imageReclaimerId);
+    for (const auto& item : items) accountItem(item, -1);
+    for (const auto& item : pinnedItems) accountItem(item, -1);
     items.clear(); // 清理剪贴板项目
+    pinnedItems.clear();
+    clearRows();
 
     // 停止所有动画
     if(animationManager) {
         delete animationManager;
         animationManager = nullptr;
     }
-    // Clear clipboard history first
-    clearHistory();
 
     // Delete managers
     delete autoStartManager;
@@ -82,7 +91,7 @@ void MainWindow::setupUI() {
     leftPanel = new QWidget;
     qDebug() << "Left panel created";
     leftPanel->setFixedWidth(200);
-    leftPanel->setStyleSheet("background-color: #4B8BF4;");
+    leftPanel->setObjectName(Theme::LeftPanel);
 
     qDebug() << "Left panel styled";
 
@@ -96,11 +105,11 @@ void MainWindow::setupUI() {
     titleLayout->setContentsMargins(20, 20, 20, 10);
 
     titleLabel = new QLabel("剪贴板历史");
-    titleLabel->setStyleSheet("color: white; font-size: 16px; font-weight: bold;");
+    titleLabel->setObjectName(Theme::PanelTitle);
     titleLabel->setAlignment(Qt::AlignCenter);
 
     descLabel = new QLabel("你就尽管Ctrl+C\n我就负责记录");
-    descLabel->setStyleSheet("color: rgba(255,255,255,0.8); font-size: 12px;");
+    descLabel->setObjectName(Theme::PanelDescription);
     descLabel->setAlignment(Qt::AlignCenter);
     descLabel->setWordWrap(true);
 
@@ -108,7 +117,7 @@ void MainWindow::setupUI() {
     QPixmap icon(":/icons/header.ico");
     iconLabel->setPixmap(icon.scaled(256, 256, Qt::KeepAspectRatio, Qt::SmoothTransformation));
     iconLabel->setAlignment(Qt::AlignCenter);
-    iconLabel->setStyleSheet("margin-bottom: 10px;");
+    iconLabel->setObjectName(Theme::PanelIcon);
 
     titleLayout->addWidget(iconLabel);
     titleLayout->addWidget(titleLabel);
@@ -121,57 +130,58 @@ void MainWindow::setupUI() {
     struct BtnInfo {
         QString name;
         QString icon;
+        Category category;
     };
 
     QVector<BtnInfo> buttons = {
-        {"全部", ":/icons/startup_icon.svg"},
-        {"文本", ":/icons/text_icon.svg"},
-        {"图片", ":/icons/image_icon.svg"}
+        {"全部", ":/icons/startup_icon.svg", AllCategory},
+        {"文本", ":/icons/text_icon.svg", TextCategory},
+        {"图片", ":/icons/image_icon.svg", ImageCategory}
     };
 
     for(const auto &btn : buttons) {
         auto *button = new QPushButton(btn.name);
         button->setIcon(QIcon(btn.icon));
         button->setCheckable(true);
-        button->setStyleSheet(R"(
-            QPushButton {
-                color: white;
-                border: none;
-                text-align: left;
-                padding: 15px 20px;
-                font-size: 14px;
-            }
-            QPushButton:hover {
-                background-color: rgba(255,255,255,0.1);
-            }
-            QPushButton:checked {
-                background-color: rgba(255,255,255,0.2);
-            }
-        )");
-        categoryBtns->addButton(button);
+        button->setObjectName(Theme::CategoryButton);
+        categoryBtns->addButton(button, btn.category);
         leftLayout->addWidget(button);
     }
 
+    // 时间和大小筛选，与分类一起作用于列表和导出
+    timeFilter = new QComboBox;
+    timeFilter->setObjectName(Theme::FilterCombo);
+    timeFilter->addItem("全部时间", 0);
+    timeFilter->addItem("最近一小时", 3600);
+    timeFilter->addItem("最近一天", 24 * 3600);
+    timeFilter->addItem("最近一周", 7 * 24 * 3600);
+    leftLayout->addWidget(timeFilter);
+
+    sizeFilter = new QComboBox;
+    sizeFilter->setObjectName(Theme::FilterCombo);
+    sizeFilter->addItem("任意大小", 0);
+    sizeFilter->addItem("大于 100 KB", 100 * 1024);
+    sizeFilter->addItem("大于 1 MB", 1024 * 1024);
+    leftLayout->addWidget(sizeFilter);
+    leftLayout->addStretch();
+
     // Bottom controls
     autoStart = new QCheckBox("开机自启");
-    autoStart->setStyleSheet("QCheckBox {color: white; padding: 10px 20px;}");
+    autoStart->setObjectName(Theme::AutoStartCheck);
+    autoStart->setEnabled(false); // 自启动状态读取完成前禁用
     leftLayout->addWidget(autoStart);
 
     clearBtn = new QPushButton("清空历史");
-    clearBtn->setStyleSheet(R"(
-        QPushButton {
-            background-color: #E34133;
-            color: white;
-            border: none;
-            padding: 10px;
-            margin: 10px 20px;
-            border-radius: 4px;
-        }
-        QPushButton:hover {
-            background-color: #D03126;
-        }
-    )");
+    clearBtn->setObjectName(Theme::ClearButton);
+
+    exportBtn = new QPushButton("导出历史");
+    exportBtn->setObjectName(Theme::ExportButton);
 
+    deleteBtn = new QPushButton("删除所选");
+    deleteBtn->setObjectName(Theme::DeleteButton);
+
+    leftLayout->addWidget(deleteBtn);
+    leftLayout->addWidget(exportBtn);
     leftLayout->addWidget(clearBtn);
 
     // Content Area
@@ -180,23 +190,9 @@ void MainWindow::setupUI() {
     contentLayout->setContentsMargins(20,20,20,20);
 
     contentList = new QListWidget;
-    contentList->setStyleSheet(R"(
-        QListWidget {
-            background-color: white;
-            border: none;
-        }
-        QListWidget::item {
-            background-color: #F8F9FA;
-            border-radius: 6px;
-            margin-bottom: 10px;
-        }
-        QListWidget::item:hover {
-            background-color: #E9ECEF;
-        }
-        QListWidget::item:selected {
-            background-color: #E2E6EA;
-        }
-    )");
+    contentList->setObjectName(Theme::HistoryList);
+    // Ctrl/Shift 多选，Delete 键或“删除所选”批量删除
+    contentList->setSelectionMode(QAbstractItemView::ExtendedSelection);
     // 添加事件过滤器处理窗口状态变化
     installEventFilter(this);
 
@@ -212,8 +208,15 @@ void MainWindow::setupUI() {
 
     // Connections
     connect(categoryBtns, &QButtonGroup::buttonClicked, this, &MainWindow::onCategoryChanged);
+    connect(timeFilter, &QComboBox::currentIndexChanged, this, &MainWindow::updateList);
+    connect(sizeFilter, &QComboBox::currentIndexChanged, this, &MainWindow::updateList);
     connect(contentList, &QListWidget::itemDoubleClicked, this, &MainWindow::showPreview);
     connect(clearBtn, &QPushButton::clicked, this, &MainWindow::clearHistory);
+    connect(exportBtn, &QPushButton::clicked, this, &MainWindow::exportHistory);
+    connect(deleteBtn, &QPushButton::clicked, this, &MainWindow::deleteSelected);
+    auto *deleteShortcut = new QShortcut(QKeySequence::Delete, contentList);
+    deleteShortcut->setContext(Qt::WidgetShortcut);
+    connect(deleteShortcut, &QShortcut::activated, this, &MainWindow::deleteSelected);
     connect(autoStart, &QCheckBox::toggled, this, &MainWindow::setAutoStart);
 
     // Set default category
@@ -242,52 +245,76 @@ void MainWindow::setupButtonAnimations() {
     });
 }
 
-void MainWindow::clipboardChanged() {
-    const QMimeData *mimeData = clipboard->mimeData();
-    if(!mimeData) return;
-
-    if(mimeData->hasImage()) {
-        QPixmap image = qvariant_cast<QPixmap>(mimeData->imageData());
-        if(image.isNull()) return;
-
-        QString hash = getImageHash(image);
+void MainWindow::setupHistorySource() {
+    // 后台守护进程在运行则只作为界面连接上去，否则在进程内运行捕获核心
+    auto *client = new HistoryClient(this);
+    if (client->connectToDaemon()) {
+        qDebug() << "Attached to capture daemon";
+        // 排队处理：不在客户端自身的信号中删除它
+        connect(client, &HistoryClient::disconnected, this, &MainWindow::onDaemonDisconnected, Qt::QueuedConnection);
+        history = client;
+    } else {
+        delete client;
+        history = createLocalHistory();
+    }
 
-        // 检查是否重复
-        if(!items.isEmpty() && items.first().type == ClipboardItem::Image) {
-            if(hash == getImageHash(items.first().image)) return;
-        }
+    pageDecoder = new PageDecoder(this);
+    pageDecoder->setThumbnailSize(QSize(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT));
+    connect(pageDecoder, &PageDecoder::decoded, this, &MainWindow::onPageItemDecoded);
+    connect(pageDecoder, &PageDecoder::finished, this, &MainWindow::onPageDecoded);
+    connectHistorySignals();
+}
 
-        // 添加到缓存
-        addToCache(hash, image);
+HistorySource* MainWindow::createLocalHistory() {
+    auto *local = new ClipboardHistory(this);
+    local->setMaxItems(MAX_HISTORY_ITEMS);
+    // 与守护进程一致：只在保存时重写文件的改动（旧格式历史、删除记录追加失败）也能及时落盘
+    local->setAutoSave(true);
+    local->startMonitoring();
+    return local;
+}
 
-        ClipboardItem item;
-        item.type = ClipboardItem::Image;
-        item.image = image;
-        item.timestamp = QDateTime::currentDateTime();
-        items.prepend(item);
-        updateList();
-    } else if(mimeData->hasText()) {
-        if(!items.isEmpty() && items.first().type == ClipboardItem::Text &&
-            items.first().text == mimeData->text()) {
-            return;
+void MainWindow::onDaemonDisconnected() {
+    // 守护进程退出：改为在进程内运行捕获核心。两者共用同一存储目录，
+    // 已显示条目的 id 不变，列表无需重建
+    auto *client = qobject_cast<HistoryClient*>(history);
+    if (!client) return;
+    qDebug() << "Capture daemon disconnected, falling back to in-process history";
+    client->disconnect(this);
+    client->deleteLater();
+    history = createLocalHistory();
+    connectHistorySignals();
+    showToast("后台服务已断开，已切换为本地记录");
+
+    // 断开时仍在途的分页请求已丢失，向新来源重新发出
+    if (pageRequestPending) {
+        if (firstPageLoaded) {
+            history->requestPage(pageCursor, DEFERRED_PAGE_SIZE);
+        } else {
+            loadFirstHistoryPage();
         }
-        ClipboardItem item;
-        item.type = ClipboardItem::Text;
-        item.text = mimeData->text();
-        item.timestamp = QDateTime::currentDateTime();
-        items.prepend(item);
-        updateList();
     }
 }
 
-QString MainWindow::getImageHash(const QPixmap& image) {
-    QByteArray byteArray;
-    QBuffer buffer(&byteArray);
-    buffer.open(QIODevice::WriteOnly);
-    image.save(&buffer, "PNG");
-    return QString(QCryptographicHash::hash(byteArray, QCryptographicHash::Md5).toHex());
+void MainWindow::connectHistorySignals() {
+    connect(history, &HistorySource::pageLoaded, this, &MainWindow::onHistoryPage);
+    connect(history, &HistorySource::entryAdded, this, &MainWindow::onEntryAdded);
+    connect(history, &HistorySource::historyCleared, this, &MainWindow::onHistoryCleared);
+    connect(history, &HistorySource::pinnedLoaded, this, &MainWindow::onPinnedLoaded);
+    connect(history, &HistorySource::entryPinned, this, &MainWindow::onEntryPinned);
+    connect(history, &HistorySource::entriesRemoved, this, &MainWindow::onEntriesRemoved);
+    connect(history, &HistorySource::historyLimitReached, this, &MainWindow::showHistoryLimitWarning);
 }
 
+void MainWindow::onEntryAdded(const StorageManager::ClipboardData& entry) {
+    ClipboardItem item;
+    if (!convertFromStorageItem(entry, item)) return;
+
+    if (firstCapturedId == 0) firstCapturedId = entry.id;
+    items.prepend(item);
+    insertColumn(columns.size(), item);
+    updateList();
+}
 
 // mainwindow.cpp - Add new dialog creation method
 QDialog* MainWindow::createStyledDialog(const ClipboardItem& item) {
@@ -302,8 +329,7 @@ QDialog* MainWindow::createStyledDialog(const ClipboardItem& item) {
 
     // 创建内容容器
     QWidget* container = new QWidget;
-    container->setObjectName("container");
-    container->setStyleSheet("#container { background:white; border-radius:8px; }");
+    container->setObjectName(Theme::PreviewContainer);
 
     QVBoxLayout* containerLayout = new QVBoxLayout(container);
     containerLayout->setContentsMargins(0, 0, 0, 0);
@@ -311,38 +337,17 @@ QDialog* MainWindow::createStyledDialog(const ClipboardItem& item) {
     // 添加标题栏
     QWidget* titleBar = new QWidget;
     titleBar->setFixedHeight(50);
-    titleBar->setStyleSheet("background:#4B8BF4; border-radius:8px 8px 0 0;");
+    titleBar->setObjectName(Theme::PreviewTitleBar);
 
     QHBoxLayout* titleLayout = new QHBoxLayout(titleBar);
     QLabel* titleLabel = new QLabel("预览");
-    titleLabel->setStyleSheet("color:white; font-size:14px;");
+    titleLabel->setObjectName(Theme::PreviewTitle);
 
     QPushButton* copyBtn = new QPushButton("复制");
-    copyBtn->setStyleSheet(R"(
-        QPushButton {
-            background:rgba(255,255,255,0.2);
-            color:white;
-            border:none;
-            padding:5px 15px;
-            border-radius:4px;
-        }
-        QPushButton:hover {
-            background:rgba(255,255,255,0.3);
-        }
-    )");
+    copyBtn->setObjectName(Theme::PreviewCopyButton);
 
     QPushButton* closeBtn = new QPushButton("×");
-    closeBtn->setStyleSheet(R"(
-        QPushButton {
-            color:white;
-            border:none;
-            font-size:20px;
-            padding:5px 15px;
-        }
-        QPushButton:hover {
-            background:rgba(255,255,255,0.1);
-        }
-    )");
+    closeBtn->setObjectName(Theme::PreviewCloseButton);
 
     titleLayout->addWidget(titleLabel);
     titleLayout->addWidget(copyBtn);
@@ -351,16 +356,33 @@ QDialog* MainWindow::createStyledDialog(const ClipboardItem& item) {
 
     // 添加内容
     if(item.type == ClipboardItem::Image) {
-        QLabel* imageLabel = new QLabel;
-        imageLabel->setPixmap(item.image.scaled(800, 600, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-        imageLabel->setStyleSheet("background:white; padding:20px;");
-        containerLayout->addWidget(imageLabel);
+        // 大图在工作线程中解码并生成金字塔，打开时先显示缩略图
+        auto* imageView = new TiledImageView;
+        imageView->setObjectName(Theme::PreviewContent);
+        StorageManager::ClipboardData entry;
+        entry.type = StorageManager::ClipboardData::Image;
+        entry.id = item.id;
+        entry.hash = item.hash;
+        QString path = item.hash.isEmpty() ? QString() : history->imagePath(entry);
+        if (!path.isEmpty() && QFile::exists(path)) {
+            imageView->setSource(path, item.thumbnail);
+        } else {
+            imageView->setImage(fullImage(item).toImage(), item.thumbnail);
+        }
+        containerLayout->addWidget(imageView);
     } else {
-        QTextEdit* textEdit = new QTextEdit;
-        textEdit->setText(item.text);
-        textEdit->setReadOnly(true);
-        textEdit->setStyleSheet("background:white; padding:20px;");
-        containerLayout->addWidget(textEdit);
+        // 只对可见行排版和绘制，大段文本不再整篇建立 QTextDocument
+        auto* textView = new TextPreview;
+        textView->setObjectName(Theme::PreviewContent);
+        // 格式化视图下标题栏按钮复制原文，格式化结果由预览区内的按钮复制
+        connect(textView, &TextPreview::formattedChanged, copyBtn, [copyBtn](bool formatted) {
+            copyBtn->setText(formatted ? "复制原文" : "复制");
+        });
+        connect(textView, &TextPreview::formattedCopied, this, [this]() {
+            showToast("已复制格式化结果");
+        });
+        textView->setText(fullText(item));
+        containerLayout->addWidget(textView);
     }
 
     // 添加阴影效果
@@ -368,17 +390,13 @@ QDialog* MainWindow::createStyledDialog(const ClipboardItem& item) {
     shadow->setBlurRadius(20);
     shadow->setColor(QColor(0, 0, 0, 80));
     shadow->setOffset(0, 0);
-    container->setGraphicsEffect(shadow);
+    animationManager->setEffect(container, shadow);
 
     layout->addWidget(container);
 
     // 连接信号槽
-    connect(copyBtn, &QPushButton::clicked, [this, item]() {
-        if(item.type == ClipboardItem::Image) {
-            clipboard->setPixmap(item.image);
-        } else {
-            clipboard->setText(item.text);
-        }
+    connect(copyBtn, &QPushButton::clicked, [this, id = item.id]() {
+        history->copyToClipboard(id);
         showToast("已复制到剪贴板");
     });
 
@@ -392,10 +410,11 @@ QDialog* MainWindow::createStyledDialog(const ClipboardItem& item) {
 }
 
 void MainWindow::showPreview(QListWidgetItem *item) {
-    int index = contentList->row(item);
-    if(index < 0 || index >= items.size()) return;
+    // 行号与 items 下标不对应（置顶条目在前、分类过滤），按行上记录的 id 查找
+    const ClipboardItem* target = findItem(item->data(Qt::UserRole).toULongLong());
+    if (!target) return;
 
-    QDialog* dialog = createStyledDialog(items[index]);
+    QDialog* dialog = createStyledDialog(*target);
     if(!dialog) return;
 
     // Set size and position
@@ -408,12 +427,8 @@ void MainWindow::showPreview(QListWidgetItem *item) {
     animationManager->playPreviewShowAnimation(dialog, geometry);
 
     // Ensure cleanup
+    // 阴影效果属于对话框内的控件，随对话框一起销毁
     dialog->setAttribute(Qt::WA_DeleteOnClose);
-    connect(dialog, &QDialog::destroyed, [this]() {
-        // 强制清理残留的GraphicsEffect
-        QList<QGraphicsEffect*> effects = findChildren<QGraphicsEffect*>();
-        qDeleteAll(effects);
-    });
 }
 
 
@@ -423,28 +438,8 @@ void MainWindow::onCategoryChanged(QAbstractButton *button) {
 
 // 添加Toaster消息
 void MainWindow::showToast(const QString &message) {
-    auto *toast = new QDialog(this, Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint);
-    toast->setAttribute(Qt::WA_DeleteOnClose);
-    toast->setAttribute(Qt::WA_TranslucentBackground); // 添加透明背景支持
-
-    auto *mainWidget = new QWidget(toast);
-    mainWidget->setStyleSheet("background-color: #4B8BF4; border-radius: 4px;");
-
-    auto *layout = new QVBoxLayout(toast);
-    layout->setContentsMargins(0, 0, 0, 0);
-
-    auto *innerLayout = new QVBoxLayout(mainWidget);
-    auto *label = new QLabel(message);
-    label->setStyleSheet("color: white; padding: 10px 20px; background: transparent;");
-    innerLayout->addWidget(label);
-
-    layout->addWidget(mainWidget);
-
-    QPoint pos = this->geometry().center();
-    toast->move(pos.x() - toast->width()/2, pos.y());
-    toast->show();
-
-    animationManager->playToastAnimation(toast, this->geometry().center());
+    // 复用窗口内同一个浮层，连续提示排队或合并
+    animationManager->showToast(this, message);
 }
 
 bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
@@ -457,146 +452,167 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
 QPushButton* MainWindow::createCopyButton()
 {
     QPushButton* copyButton = new QPushButton(tr("复制"));
-    copyButton->setStyleSheet(R"(
-        QPushButton {
-            background-color: #4B8BF4;
-            color: white;
-            border: none;
-            padding: 5px 10px;
-            border-radius: 4px;
-        }
-        QPushButton:hover {
-            background-color: #357ABD;
-        }
-    )");
+    copyButton->setObjectName(Theme::RowButton);
     return copyButton;
 }
 
 
+QPushButton* MainWindow::createPinButton(bool pinned) {
+    auto* pinButton = new QPushButton(pinned ? tr("取消置顶") : tr("置顶"));
+    pinButton->setObjectName(Theme::RowPinButton);
+    return pinButton;
+}
+
 QPushButton* MainWindow::createSaveButton() {
     auto* saveButton = new QPushButton(tr("保存"));
-    saveButton->setStyleSheet(R"(
-        QPushButton {
-            background-color: #4B8BF4;
-            color: white;
-            border: none;
-            padding: 5px 10px;
-            border-radius: 4px;
-        }
-        QPushButton:hover {
-            background-color: #357ABD;
-        }
-    )");
+    saveButton->setObjectName(Theme::RowButton);
     return saveButton;
 }
 
 void MainWindow::updateList() {
+    TRACE_SCOPE("updateList");
     // 暂停UI更新提升性能
     contentList->setUpdatesEnabled(false);
     QSignalBlocker blocker(contentList); // 暂时阻塞信号
 
-    // 预分配空间
-    int estimatedItems = items.size();
-    contentList->clear();
+    clearRows();
 
-    QString category = categoryBtns->checkedButton()->text();
-        // 预分配容器空间
-    QVector<QListWidgetItem*> newItems;
-    newItems.reserve(items.size());
-
-    for (const auto &item : items) {
-        // 检查类型匹配
-        bool shouldShow =
-            category == "全部" ||
-            (category == "文本" && item.type == ClipboardItem::Text) ||
-            (category == "图片" && item.type == ClipboardItem::Image);
-
-        if (!shouldShow) continue;
-
-        // 创建容器widget
-        auto *container = new QWidget;
-        container->setObjectName("itemContainer");
-        container->setStyleSheet(R"(
-           #itemContainer {
-               background-color: #F8F9FA;
-               border-radius: 6px;
-               margin: 5px;
-           }
-       )");
-
-        auto *layout = new QHBoxLayout(container);
-        layout->setContentsMargins(10, 10, 10, 10);
-        layout->setSpacing(10);
-
-        // 根据类型添加内容
-        if (item.type == ClipboardItem::Image) {
-            auto *imageLabel = createImageLabel(item.image);
-            layout->addWidget(imageLabel);
-        } else {
-            auto *textLabel = createTextLabel(item.text);
-            layout->addWidget(textLabel);
-        }
+    const EntryColumns::Query filter = currentFilter();
+    for (const auto &item : pinnedItems) {
+        if (!matchesFilter(item)) continue;
+        addListRow(item);
+    }
+    // 普通条目在列上一次筛出行号，从新到旧加入列表
+    const QList<qsizetype> rows = columns.select(filter);
+    const qsizetype last = items.size() - 1;
+    for (qsizetype k = rows.size() - 1; k >= 0; --k) {
+        addListRow(items.at(last - rows.at(k)));
+    }
 
-        layout->addStretch();
+    // 批量添加并恢复UI更新
+    contentList->setUpdatesEnabled(true);
+    contentList->update();
+}
 
-        // 添加复制按钮
-        auto *copyBtn = createCopyButton();
-        connect(copyBtn, &QPushButton::clicked, [this, item]() {
-            if (item.type == ClipboardItem::Image) {
-                clipboard->setPixmap(item.image);
-            } else {
-                clipboard->setText(item.text);
-            }
-            showToast("已复制到剪贴板");
-        });
-        layout->addWidget(copyBtn);
-        //下载按钮
-        auto* saveBtn = createSaveButton();
-        connect(saveBtn, &QPushButton::clicked, [this, item]() {
-            saveContent(item);
-        });
-        layout->addWidget(saveBtn);
+EntryColumns::Query MainWindow::currentFilter() const {
+    EntryColumns::Query query;
+    // 按钮 id 即分类，不再逐条比较按钮文字
+    switch (categoryBtns->checkedId()) {
+    case TextCategory:
+        query.type = ClipboardItem::Text;
+        break;
+    case ImageCategory:
+        query.type = ClipboardItem::Image;
+        break;
+    default:
+        break;
+    }
+    qint64 seconds = timeFilter->currentData().toLongLong();
+    if (seconds > 0) query.sinceMs = QDateTime::currentMSecsSinceEpoch() - seconds * 1000;
+    query.minBytes = sizeFilter->currentData().toLongLong();
+    return query;
+}
 
-        // 创建列表项
-        auto *listItem = new QListWidgetItem;
-        int itemHeight = (item.type == ClipboardItem::Image) ? 170 : 80;
-        container->setFixedHeight(itemHeight);
-        listItem->setSizeHint(QSize(contentList->viewport()->width(), itemHeight));
-        newItems.append(listItem);
+bool MainWindow::matchesFilter(const ClipboardItem& item) const {
+    return currentFilter().matches(item.type, item.timestamp.toMSecsSinceEpoch(), item.bytes, columnFlags(item));
+}
 
-        contentList->addItem(listItem);
-        contentList->setItemWidget(listItem, container);
+quint8 MainWindow::columnFlags(const ClipboardItem& item) {
+    return (item.pinned ? EntryColumns::Pinned : 0) | (item.chunks.isEmpty() ? 0 : EntryColumns::Chunked);
+}
+
+void MainWindow::insertColumn(qsizetype row, const ClipboardItem& item) {
+    columns.insert(row, item.id, item.type, item.timestamp.toMSecsSinceEpoch(), item.bytes, columnFlags(item));
+}
+
+void MainWindow::addListRow(const ClipboardItem& item) {
+    // 创建容器widget
+    // 背景由 HistoryRow 直接绘制，行内控件只设置 objectName，不解析样式表
+    auto *container = new HistoryRow(item.pinned);
+
+    auto *layout = new QHBoxLayout(container);
+    layout->setContentsMargins(10, 10, 10, 10);
+    layout->setSpacing(10);
+
+    // 根据类型添加内容
+    if (item.type == ClipboardItem::Image) {
+        auto *imageLabel = createImageLabel(item.thumbnail.isNull() ? item.image : item.thumbnail);
+        layout->addWidget(imageLabel);
+    } else {
+        auto *textLabel = createTextLabel(item.text);
+        layout->addWidget(textLabel);
     }
 
-    // 批量添加并恢复UI更新
-    contentList->setUpdatesEnabled(true);
-    contentList->update();
+    layout->addStretch();
+
+    // 添加复制按钮
+    auto *copyBtn = createCopyButton();
+    connect(copyBtn, &QPushButton::clicked, [this, id = item.id]() {
+        history->copyToClipboard(id);
+        showToast("已复制到剪贴板");
+    });
+    layout->addWidget(copyBtn);
+    //下载按钮
+    auto* saveBtn = createSaveButton();
+    connect(saveBtn, &QPushButton::clicked, [this, id = item.id]() {
+        if (const ClipboardItem* target = findItem(id)) saveContent(*target);
+    });
+    layout->addWidget(saveBtn);
+    //置顶按钮
+    auto* pinBtn = createPinButton(item.pinned);
+    connect(pinBtn, &QPushButton::clicked, [this, id = item.id, pinned = item.pinned]() {
+        history->setPinned(id, !pinned);
+    });
+    layout->addWidget(pinBtn);
+
+    // 创建列表项
+    auto *listItem = new QListWidgetItem;
+    listItem->setData(Qt::UserRole, QVariant::fromValue(item.id));
+    int itemHeight = (item.type == ClipboardItem::Image) ? 170 : 80;
+    container->setFixedHeight(itemHeight);
+    listItem->setSizeHint(QSize(contentList->viewport()->width(), itemHeight));
+
+    contentList->addItem(listItem);
+    contentList->setItemWidget(listItem, container);
+    rowItems.insert(item.id, listItem);
+
+    rowOverheadBytes += ROW_OVERHEAD_BYTES;
+    MemoryAccountant::instance()->charge(MemoryAccountant::WidgetOverhead, ROW_OVERHEAD_BYTES);
 }
 
 
 // 辅助函数
 QLabel* MainWindow::createImageLabel(const QPixmap& image) {
+    TRACE_SCOPE("createImageLabel");
     auto *label = new QLabel;
-    label->setFixedSize(200, 150);
+    label->setFixedSize(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT);
     label->setAlignment(Qt::AlignCenter);
 
     if (!image.isNull()) {
-        QPixmap thumbnail = image.scaled(
-            label->size() * 2,
-            Qt::KeepAspectRatio,
-            Qt::SmoothTransformation
-            );
-        label->setPixmap(thumbnail.scaled(
-            label->size(),
-            Qt::KeepAspectRatio,
-            Qt::SmoothTransformation
-            ));
+        // 已经是缩略图时直接使用，避免每次重建列表都重新缩放
+        bool fits = image.width() <= label->width() && image.height() <= label->height();
+        label->setPixmap(fits ? image : makeThumbnail(image));
     } else {
         label->setText("图片加载失败");
     }
     return label;
 }
 
+QPixmap MainWindow::makeThumbnail(const QPixmap& image) {
+    if (image.isNull()) return QPixmap();
+    const QSize size(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT);
+    QPixmap thumbnail = image.scaled(
+        size * 2,
+        Qt::KeepAspectRatio,
+        Qt::SmoothTransformation
+        );
+    return thumbnail.scaled(
+        size,
+        Qt::KeepAspectRatio,
+        Qt::SmoothTransformation
+        );
+}
+
 QLabel* MainWindow::createTextLabel(const QString& text) {
     auto *label = new QLabel(text.length() > 50 ? text.left(50) + "..." : text);
     label->setWordWrap(true);
@@ -606,50 +622,213 @@ QLabel* MainWindow::createTextLabel(const QString& text) {
 }
 
 void MainWindow::clearHistory() {
+    history->clear();
+}
+
+void MainWindow::onHistoryCleared() {
     // Clear images first to free memory
     for(auto &item : items) {
+        accountItem(item, -1);
         if(item.type == ClipboardItem::Image) {
             item.image = QPixmap();
         }
     }
     items.clear();
-    contentList->clear();
+    columns.clear();
+    // 置顶条目不受清空影响
+    updateList();
     showToast("历史记录已清空");
 }
 
-// mainwindow.cpp - 实现缓存机制
-void MainWindow::clearCache() {
-    imageCache.clear();
-    currentCacheSize = 0;
+void MainWindow::onEntriesRemoved(const QList<quint64>& ids) {
+    // 只移除受影响的条目和行，不重建列表；items 按 id 降序，二分定位并标记，
+    // 再与列一起从最小位置起压缩一次
+    // 重复的 id 只处理一次，否则同一条目会被重复释放记账、压缩游标也会错位
+    const QSet<quint64> unique(ids.cbegin(), ids.cend());
+    QList<qsizetype> positions;
+    positions.reserve(unique.size());
+    for (quint64 id : unique) {
+        auto it = std::lower_bound(items.begin(), items.end(), id,
+                                   [](const ClipboardItem& item, quint64 target) { return item.id > target; });
+        if (it != items.end() && it->id == id) {
+            accountItem(*it, -1);
+            positions.append(it - items.begin());
+        } else {
+            auto pinned = std::find_if(pinnedItems.begin(), pinnedItems.end(),
+                                       [id](const ClipboardItem& item) { return item.id == id; });
+            if (pinned == pinnedItems.end()) continue;
+            accountItem(*pinned, -1);
+            pinnedItems.erase(pinned);
+        }
+    }
+    if (!positions.isEmpty()) {
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+        const qsizetype last = items.size() - 1;
+        QList<qsizetype> rows;
+        rows.reserve(positions.size());
+        for (auto it = positions.crbegin(); it != positions.crend(); ++it) rows.append(last - *it);
+
+        qsizetype kept = positions.first();
+        qsizetype next = 0;
+        for (qsizetype i = positions.first(); i < items.size(); ++i) {
+            if (next < positions.size() && positions.at(next) == i) {
+                ++next;
+                continue;
+            }
+            items[kept++] = std::move(items[i]);
+        }
+        items.resize(kept);
+        columns.removeRows(rows);
+    }
+    removeRows(ids);
 }
 
-void MainWindow::addToCache(const QString& hash, const QPixmap& image) {
-    // 添加图片大小限制
-    if(image.width() * image.height() > 4000 * 3000) {
-        QPixmap scaled = image.scaled(2000, 1500, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        imageCache.insert(hash, scaled);
-        currentCacheSize += (scaled.width() * scaled.height() * 4) / (1024 * 1024);
+void MainWindow::removeRows(const QList<quint64>& ids) {
+    QSet<QListWidgetItem*> targets;
+    for (quint64 id : ids) {
+        if (QListWidgetItem *listItem = rowItems.take(id)) targets.insert(listItem);
+    }
+    // 从末尾向前扫一遍，找到的行按降序取出，前面的行号不受影响；全部找到即停止
+    for (int row = contentList->count() - 1; row >= 0 && !targets.isEmpty(); --row) {
+        if (!targets.remove(contentList->item(row))) continue;
+        delete contentList->takeItem(row);
+        rowOverheadBytes -= ROW_OVERHEAD_BYTES;
+        MemoryAccountant::instance()->release(MemoryAccountant::WidgetOverhead, ROW_OVERHEAD_BYTES);
     }
-    // 估算图片大小(MB)
-    int imageSize = (image.width() * image.height() * 4) / (1024 * 1024);
+}
 
-    // 缓存超限时清理最旧的
-    while(currentCacheSize + imageSize > MAX_CACHE_SIZE && !imageCache.isEmpty()) {
-        auto it = imageCache.begin();
-        const QPixmap& oldImage = it.value();
-        currentCacheSize -= (oldImage.width() * oldImage.height() * 4) / (1024 * 1024);
-        imageCache.erase(it);
+void MainWindow::deleteSelected() {
+    const QList<QListWidgetItem*> selected = contentList->selectedItems();
+    if (selected.isEmpty()) {
+        showToast("请先选择要删除的条目");
+        return;
     }
+    QList<quint64> ids;
+    ids.reserve(selected.size());
+    for (auto *listItem : selected) ids.append(listItem->data(Qt::UserRole).value<quint64>());
+    // 列表在 entriesRemoved 中更新
+    history->removeEntries(ids);
+    showToast(QString("已删除 %1 条记录").arg(ids.size()));
+}
 
-    imageCache.insert(hash, image);
-    currentCacheSize += imageSize;
+void MainWindow::onPinnedLoaded(const QList<StorageManager::ClipboardData>& entries) {
+    for (const auto& item : pinnedItems) accountItem(item, -1);
+    pinnedItems.clear();
+    for (const auto& entry : entries) {
+        ClipboardItem item;
+        if (convertFromStorageItem(entry, item)) pinnedItems.append(item);
+    }
+    updateList();
 }
-QPixmap MainWindow::getFromCache(const QString& hash) {
-    return imageCache.value(hash);
+
+void MainWindow::onEntryPinned(const StorageManager::ClipboardData& entry) {
+    auto byId = [&entry](const ClipboardItem& item) { return item.id == entry.id; };
+
+    if (entry.pinned) {
+        // 移入置顶层；已在列表中的沿用现有图片，被回收过的完整图片重新读取
+        ClipboardItem item;
+        auto it = std::find_if(items.begin(), items.end(), byId);
+        if (it != items.end()) {
+            item = *it;
+            columns.removeRow(items.end() - it - 1);
+            items.erase(it);
+            if (item.image.isNull() && item.type == ClipboardItem::Image) {
+                item.image = fullImage(item);
+                MemoryAccountant::instance()->charge(MemoryAccountant::FullImage,
+                    MemoryAccountant::pixmapBytes(item.image.width(), item.image.height(), item.image.depth()));
+            }
+        } else if (!convertFromStorageItem(entry, item)) {
+            return;
+        }
+        item.pinned = true;
+        auto pos = std::find_if(pinnedItems.begin(), pinnedItems.end(),
+                                [&entry](const ClipboardItem& other) { return other.id < entry.id; });
+        pinnedItems.insert(pos, item);
+    } else {
+        auto it = std::find_if(pinnedItems.begin(), pinnedItems.end(), byId);
+        if (it == pinnedItems.end()) return;
+        ClipboardItem item = *it;
+        pinnedItems.erase(it);
+        item.pinned = false;
+
+        // 尚未分页加载到的位置交给后续分页，避免重复
+        if (firstPageLoaded && (historyLoaded || entry.id >= pageCursor)) {
+            auto pos = std::find_if(items.begin(), items.end(),
+                                    [&entry](const ClipboardItem& other) { return other.id < entry.id; });
+            insertColumn(items.end() - pos, item);
+            items.insert(pos, item);
+        } else {
+            accountItem(item, -1);
+        }
+    }
+    updateList();
 }
 
+void MainWindow::accountItem(const ClipboardItem& item, int sign) {
+    auto *accountant = MemoryAccountant::instance();
+    if (!item.image.isNull()) {
+        accountant->charge(MemoryAccountant::FullImage,
+                           sign * MemoryAccountant::pixmapBytes(item.image.width(), item.image.height(), item.image.depth()));
+    }
+    if (!item.thumbnail.isNull()) {
+        accountant->charge(MemoryAccountant::Thumbnail,
+                           sign * MemoryAccountant::pixmapBytes(item.thumbnail.width(), item.thumbnail.height(), item.thumbnail.depth()));
+    }
+}
+
+void MainWindow::clearRows() {
+    contentList->clear();
+    rowItems.clear();
+    MemoryAccountant::instance()->release(MemoryAccountant::WidgetOverhead, rowOverheadBytes);
+    rowOverheadBytes = 0;
+}
+
+qint64 MainWindow::demoteImages(qint64 bytesNeeded) {
+    // 从最旧的条目开始丢弃完整图片，只保留缩略图和 hash，预览/保存时再从磁盘读取
+    qint64 freed = 0;
+    for (int i = items.size() - 1; i >= 0 && freed < bytesNeeded; --i) {
+        ClipboardItem& item = items[i];
+        if (item.image.isNull() || item.hash.isEmpty()) continue;
+        qint64 bytes = MemoryAccountant::pixmapBytes(item.image.width(), item.image.height(), item.image.depth());
+        item.image = QPixmap();
+        MemoryAccountant::instance()->release(MemoryAccountant::FullImage, bytes);
+        freed += bytes;
+    }
+    return freed;
+}
+
+QPixmap MainWindow::fullImage(const ClipboardItem& item) {
+    if (!item.image.isNull()) return item.image;
+    StorageManager::ClipboardData entry;
+    entry.type = StorageManager::ClipboardData::Image;
+    entry.id = item.id;
+    entry.hash = item.hash;
+    return history->loadImage(entry);
+}
+
+QString MainWindow::fullText(const ClipboardItem& item) {
+    if (item.chunks.isEmpty()) return item.text;
+    StorageManager::ClipboardData entry;
+    entry.id = item.id;
+    entry.text = item.text;
+    entry.chunks = item.chunks;
+    entry.textLength = item.textLength;
+    return history->loadText(entry);
+}
+
+const MainWindow::ClipboardItem* MainWindow::findItem(quint64 id) const {
+    for (const auto& item : pinnedItems) {
+        if (item.id == id) return &item;
+    }
+    for (const auto& item : items) {
+        if (item.id == id) return &item;
+    }
+    return nullptr;
+}
 
 void MainWindow::setAutoStart(bool enable) {
+    if (!autoStartManager) return;
     if (autoStartManager->setAutoStart(enable)) {
         showToast(enable ? "已开启开机自启" : "已关闭开机自启");
     } else {
@@ -658,7 +837,10 @@ void MainWindow::setAutoStart(bool enable) {
 }
 
 void MainWindow::loadAutoStartStatus() {
+    // 仅同步勾选状态，不触发 setAutoStart 写注册表
+    QSignalBlocker blocker(autoStart);
     autoStart->setChecked(autoStartManager->isAutoStartEnabled());
+    autoStart->setEnabled(true);
 }
 
 // MainWindow类添加重绘事件处理
@@ -682,20 +864,122 @@ void MainWindow::saveContent(const ClipboardItem& item) {
 
     if (fileName.isEmpty()) return;
 
-    bool success = false;
+    DownloadManager* manager = ensureDownloadManager();
     if (item.type == ClipboardItem::Text) {
-        success = downloadManager->saveText(item.text, fileName);
-    } else {
-        success = downloadManager->saveImage(item.image, fileName);
+        // 分块文本由工作线程逐块写入文件，结果由 fileSaved 提示
+        if (!manager->startTextSave(item.text, item.chunks, history->chunksPath(), fileName)) {
+            showToast("保存失败: " + manager->getLastError());
+        }
+        return;
     }
 
-    if (success) {
-        showToast("文件保存成功");
-    } else {
-        showToast("保存失败: " + downloadManager->getLastError());
+    // 存储中已有 PNG 时交给 DownloadManager 直接复制或在后台转码，结果由 fileSaved 提示
+    StorageManager::ClipboardData entry;
+    entry.type = StorageManager::ClipboardData::Image;
+    entry.id = item.id;
+    entry.hash = item.hash;
+    QString path = item.hash.isEmpty() ? QString() : history->imagePath(entry);
+    QImage image = !path.isEmpty() && QFile::exists(path) ? QImage() : fullImage(item).toImage();
+    if (!manager->startImageSave(path, image, fileName)) {
+        showToast("保存失败: " + manager->getLastError());
     }
 }
 
+void MainWindow::exportHistory() {
+    DownloadManager* manager = ensureDownloadManager();
+    if (manager->isExporting()) {
+        showToast("导出正在进行中");
+        return;
+    }
+
+    // 覆盖整个历史而不只是已分页加载的部分：先按条件筛出元数据（遍历期间不回调 history），
+    // 再只传图片文件路径和块 id，载荷由导出线程读取；界面线程不解码任何图片
+    QList<StorageManager::ClipboardData> matched;
+    const EntryColumns::Query filter = currentFilter();
+    history->forEachEntry([&](const StorageManager::ClipboardData& entry) {
+        const quint8 flags = (entry.pinned ? EntryColumns::Pinned : 0) | (entry.chunks.isEmpty() ? 0 : EntryColumns::Chunked);
+        if (filter.matches(entry.type, entry.timestamp.toMSecsSinceEpoch(), entry.bytes, flags)) matched.append(entry);
+        return true;
+    });
+
+    QList<DownloadManager::ExportItem> exports;
+    exports.reserve(matched.size());
+    const QString chunkRoot = history->chunksPath();
+    int missingImages = 0;
+    for (const auto& entry : std::as_const(matched)) {
+        DownloadManager::ExportItem exportItem;
+        exportItem.id = entry.id;
+        exportItem.isImage = entry.type == StorageManager::ClipboardData::Image;
+        exportItem.text = entry.text;
+        if (!entry.chunks.isEmpty()) {
+            exportItem.chunks = entry.chunks;
+            exportItem.chunkRoot = chunkRoot;
+        }
+        exportItem.timestamp = entry.timestamp;
+        if (exportItem.isImage) {
+            // 图片文件缺失的条目跳过并提示，不在这里解码内存中的图片
+            exportItem.imagePath = history->imagePath(entry);
+            if (!QFile::exists(exportItem.imagePath)) {
+                qDebug() << "导出时图片文件缺失:" << entry.id << entry.hash;
+                ++missingImages;
+                continue;
+            }
+        }
+        exports.append(exportItem);
+    }
+
+    if (exports.isEmpty()) {
+        showToast(missingImages > 0 ? "图片文件缺失，没有可导出的内容" : "没有可导出的内容");
+        return;
+    }
+    if (missingImages > 0) {
+        showToast(QString("%1 张图片的文件缺失，导出时跳过").arg(missingImages));
+    }
+
+    QString selectedFilter;
+    QString target = QFileDialog::getSaveFileName(this,
+                                                  "导出历史",
+                                                  QDir::homePath() + "/Downloads/clipboard_export_" +
+                                                      QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"),
+                                                  "Tar.gz (*.tar.gz);;Tar (*.tar);;Folder (*)",
+                                                  &selectedFilter);
+    if (target.isEmpty()) return;
+
+    DownloadManager::ExportFormat format = DownloadManager::ExportFormat::Directory;
+    if (selectedFilter.startsWith("Tar.gz")) {
+        format = DownloadManager::ExportFormat::TarGz;
+        if (!target.endsWith(".tar.gz")) target += ".tar.gz";
+    } else if (selectedFilter.startsWith("Tar")) {
+        format = DownloadManager::ExportFormat::Tar;
+        if (!target.endsWith(".tar")) target += ".tar";
+    }
+
+    if (!exportDialog) {
+        exportDialog = new QProgressDialog("正在导出...", "取消", 0, 0, this);
+        exportDialog->setWindowModality(Qt::WindowModal);
+        exportDialog->setMinimumDuration(300);
+        exportDialog->setAutoClose(false);
+        exportDialog->setAutoReset(false);
+        connect(exportDialog, &QProgressDialog::canceled, manager, &DownloadManager::cancelExport);
+        connect(manager, &DownloadManager::exportProgress, this, [this](int done, int total) {
+            exportDialog->setMaximum(total);
+            exportDialog->setValue(done);
+        });
+        connect(manager, &DownloadManager::exportFinished, this, [this](bool success, const QString& error) {
+            exportDialog->reset();
+            exportDialog->hide();
+            showToast(success ? "导出完成" : "导出失败: " + error);
+        });
+    }
+
+    if (!manager->startExport(exports, target, format)) {
+        showToast("导出失败: " + manager->getLastError());
+        return;
+    }
+    exportDialog->setMaximum(exports.size());
+    exportDialog->setValue(0);
+}
+
 void MainWindow::onSaveButtonClicked() {
     QListWidgetItem* currentItem = contentList->currentItem();
     if (!currentItem) {
@@ -703,9 +987,8 @@ void MainWindow::onSaveButtonClicked() {
         return;
     }
 
-    int index = contentList->row(currentItem);
-    if (index >= 0 && index < items.size()) {
-        saveContent(items[index]);
+    if (const ClipboardItem* target = findItem(currentItem->data(Qt::UserRole).toULongLong())) {
+        saveContent(*target);
     }
 }
 
@@ -727,6 +1010,8 @@ void MainWindow::closeEvent(QCloseEvent *event) {
 
     connect(dialog, &CustomDialog::closeWithoutSave, this, [this]() {
         shouldSaveHistory = false;
+        // 丢弃尚未自动保存的改动：停掉定时器，析构时不再补存
+        if (auto *local = qobject_cast<ClipboardHistory*>(history)) local->setAutoSave(false);
         setAttribute(Qt::WA_DontShowOnScreen);
         close();
         QRect screenGeometry = QGuiApplication::primaryScreen()->availableGeometry();
@@ -741,74 +1026,137 @@ void MainWindow::closeEvent(QCloseEvent *event) {
 void MainWindow::saveHistoryToStorage() {
     if (!shouldSaveHistory) return;
 
-    QList<StorageManager::ClipboardData> storageItems;
-    int count = 0;
+    if (!history->save()) {
+        showToast("保存历史记录失败");
+    }
+}
 
-    for (const auto& item : items) {
-        if (count >= MAX_HISTORY_ITEMS) {
-            showHistoryLimitWarning();
-            break;
-        }
+void MainWindow::showEvent(QShowEvent *event) {
+    QMainWindow::showEvent(event);
+    if (startupStarted) return;
+    startupStarted = true;
+
+    // 先让窗口骨架完成首次绘制，再在下一轮事件循环中加载历史
+    QTimer::singleShot(0, this, [this]() {
+        StartupProfiler::mark("window_visible");
+        loadFirstHistoryPage();
+    });
+}
+
+void MainWindow::loadFirstHistoryPage() {
+    // 置顶条目数量很少，先于首页整体加载
+    history->requestPinned();
+    history->requestPage(0, FIRST_PAGE_SIZE);
+    pageRequestPending = true;
+}
 
-        StorageManager::ClipboardData storageItem;
-        if (convertToStorageItem(item, storageItem)) {
-            storageItems.append(std::move(storageItem));
-            count++;
+void MainWindow::onHistoryPage(const QList<StorageManager::ClipboardData>& entries, bool finished) {
+    pageRequestPending = false;
+    QList<PageDecoder::Item> batch;
+    batch.reserve(entries.size());
+    for (const auto& entry : entries) {
+        pageCursor = entry.id;
+        // 启动后新捕获的条目已经通过 entryAdded 显示过
+        if (firstCapturedId != 0 && entry.id >= firstCapturedId) continue;
+        // 置顶条目已通过 pinnedLoaded 单独加载
+        if (entry.pinned) continue;
+
+        PageDecoder::Item item;
+        item.entry = entry;
+        if (entry.type == StorageManager::ClipboardData::Image) {
+            item.imagePath = history->imagePath(entry);
         }
+        batch.append(item);
     }
 
-    if (!storageManager->saveHistory(storageItems)) {
-        qDebug() << "保存历史记录失败:" << storageManager->getLastError();
-        showToast("保存历史记录失败");
-    }
+    // 图片解码和缩略图生成在线程池中并行进行，结果按顺序逐条加入列表
+    lastPageReceived = finished || entries.isEmpty();
+    pageDecoder->start(batch);
 }
 
-void MainWindow::loadHistoryFromStorage() {
-    items.clear();
-    auto storageItems = storageManager->loadHistory();
+void MainWindow::onPageItemDecoded(const PageDecoder::Item& decoded) {
+    ClipboardItem item;
+    copyEntryFields(decoded.entry, item);
+    item.image = QPixmap::fromImage(decoded.image);
+    item.thumbnail = QPixmap::fromImage(decoded.thumbnail);
+    accountItem(item, +1);
+
+    // 加载期间新捕获的条目在前，已加载的历史依次追加到末尾
+    items.append(item);
+    insertColumn(0, item);
+    if (matchesFilter(item)) addListRow(item);
+}
 
-    for (const auto& storageItem : storageItems) {
-        ClipboardItem item;
-        if (convertFromStorageItem(storageItem, item)) {
-            items.append(std::move(item));
-        }
+void MainWindow::onPageDecoded() {
+    if (!firstPageLoaded) {
+        firstPageLoaded = true;
+        StartupProfiler::mark("first_page_rendered");
     }
 
+    if (lastPageReceived) {
+        historyLoaded = true;
+        finishStartup();
+        return;
+    }
+
+    // 其余页面在空闲时逐批加载
+    QTimer::singleShot(0, this, [this]() {
+        history->requestPage(pageCursor, DEFERRED_PAGE_SIZE);
+        pageRequestPending = true;
+    });
+}
+
+void MainWindow::finishStartup() {
+    // 注册表访问放在历史加载完成之后的空闲时间
+    if (!autoStartManager) {
+        autoStartManager = new AutoStartManager(this);
+        loadAutoStartStatus();
+    }
+    ensureDownloadManager();
+
     if (items.size() >= MAX_HISTORY_ITEMS) {
         showHistoryLimitWarning();
     }
 
-    updateList();
+    StartupProfiler::mark("fully_loaded");
+    StartupProfiler::writeLog();
 }
 
-bool MainWindow::convertToStorageItem(const ClipboardItem& source, StorageManager::ClipboardData& target) {
-    try {
-        target.type = (source.type == ClipboardItem::Text) ?
-                          StorageManager::ClipboardData::Text :
-                          StorageManager::ClipboardData::Image;
-        target.text = source.text;
-        target.image = source.image;
-        target.timestamp = source.timestamp;
-
-        if (source.type == ClipboardItem::Image) {
-            target.hash = getImageHash(source.image);
-        }
-
-        return true;
-    } catch (const std::exception& e) {
-        qDebug() << "转换到存储项目失败:" << e.what();
-        return false;
+DownloadManager* MainWindow::ensureDownloadManager() {
+    if (!downloadManager) {
+        downloadManager = new DownloadManager(this);
+        connect(downloadManager, &DownloadManager::fileSaved, this,
+                [this](bool success, const QString& filePath, const QString& error) {
+            Q_UNUSED(filePath);
+            showToast(success ? "文件保存成功" : "保存失败: " + error);
+        });
     }
+    return downloadManager;
+}
+
+void MainWindow::copyEntryFields(const StorageManager::ClipboardData& source, ClipboardItem& target) {
+    target.type = (source.type == StorageManager::ClipboardData::Text) ?
+                      ClipboardItem::Text :
+                      ClipboardItem::Image;
+    target.id = source.id;
+    target.text = source.text;
+    target.hash = source.hash;
+    target.timestamp = source.timestamp;
+    target.pinned = source.pinned;
+    target.chunks = source.chunks;
+    target.textLength = source.textLength;
+    target.bytes = source.bytes > 0 ? source.bytes
+                                    : (source.isChunked() ? source.textLength : source.text.size()) * qint64(sizeof(QChar));
 }
 
 bool MainWindow::convertFromStorageItem(const StorageManager::ClipboardData& source, ClipboardItem& target) {
     try {
-        target.type = (source.type == StorageManager::ClipboardData::Text) ?
-                          ClipboardItem::Text :
-                          ClipboardItem::Image;
-        target.text = source.text;
-        target.image = source.image;
-        target.timestamp = source.timestamp;
+        copyEntryFields(source, target);
+        if (source.type == StorageManager::ClipboardData::Image) {
+            target.image = history->loadImage(source);
+            target.thumbnail = makeThumbnail(target.image);
+        }
+        accountItem(target, +1);
 
         return true;
     } catch (const std::exception& e) {
@@ -819,6 +1167,49 @@ bool MainWindow::convertFromStorageItem(const StorageManager::ClipboardData& sou
 
 
 
+void MainWindow::setupDiagnostics() {
+    perfOverlay = new PerfOverlay(this);
+    perfOverlay->setMemoryProvider([this]() { return memoryUsage(); });
+
+    // 完整图片比磁盘缓存更“热”，在缓存之后回收
+    imageReclaimerId = MemoryAccountant::instance()->addReclaimer(10, [this](qint64 needed) {
+        return demoteImages(needed);
+    });
+
+    auto *overlayShortcut = new QShortcut(QKeySequence("Ctrl+Shift+P"), this);
+    connect(overlayShortcut, &QShortcut::activated, this, &MainWindow::togglePerfOverlay);
+
+    auto *traceShortcut = new QShortcut(QKeySequence("Ctrl+Shift+T"), this);
+    connect(traceShortcut, &QShortcut::activated, this, &MainWindow::exportTrace);
+}
+
+void MainWindow::togglePerfOverlay() {
+    bool show = !perfOverlay->isVisible();
+    // 浮层打开时才开启追踪（除非通过环境变量常开）
+    if (show) Tracer::setEnabled(true);
+    perfOverlay->setVisible(show);
+}
+
+void MainWindow::exportTrace() {
+    if (!Tracer::isEnabled()) {
+        Tracer::setEnabled(true);
+        showToast("已开启性能追踪，再次按下导出");
+        return;
+    }
+
+    QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) +
+                   "/trace-" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + ".json";
+    if (Tracer::exportChromeTrace(path)) {
+        showToast("追踪已导出: " + path);
+    } else {
+        showToast("追踪导出失败");
+    }
+}
+
+QList<QPair<QString, qint64>> MainWindow::memoryUsage() const {
+    return MemoryAccountant::instance()->stats();
+}
+
 void MainWindow::showHistoryLimitWarning() {
     auto* dialog = new CustomDialog(CustomDialog::DialogType::HistoryLimit, this);
     dialog->move(this->geometry().center() - dialog->rect().center());
@@ -18,7 +18,11 @@
 #include "../components/autostartmanager.h"
 #include "../components/downloadmanager.h"
 #include "../components/storagemanager.h"
+#include "../components/historysource.h"
+#include "../components/entrycolumns.h"
+#include "../components/pagedecoder.h"
 #include "../components/ui/customdialog.h"
+#include "../components/ui/perfoverlay.h"
 
 #include <QHash>
 #include <QString>
@@ -28,8 +32,12 @@
 
 #include <memory>
 
+class QProgressDialog;
+class QComboBox;
+
 class MainWindow : public QMainWindow {
     Q_OBJECT
+    friend class HistoryBenchmark;
 
 public:
     MainWindow(QWidget *parent = nullptr);
@@ -38,6 +46,7 @@ public:
 protected:
     bool eventFilter(QObject *obj, QEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
 
 private:
 
@@ -47,20 +56,35 @@ private:
     //动画管理类
     AnimationManager *animationManager;
     //自启动管理类
-    AutoStartManager *autoStartManager;
+    AutoStartManager *autoStartManager = nullptr;
     struct ClipboardItem {
         enum Type { Text, Image } type;
+        quint64 id = 0;
         QString text;
-        QPixmap image;
+        QString hash;       // 图片在磁盘上的句柄，完整图片被回收后用于重新加载
+        QPixmap image;      // 完整图片，内存紧张时可能被丢弃
+        QPixmap thumbnail;  // 列表中显示的缩略图
         QDateTime timestamp;
+        bool pinned = false;
+        QStringList chunks;     // 分块存放的大文本，text 只是预览
+        qint64 textLength = 0;
+        qint64 bytes = 0;       // 载荷大小，按大小筛选用
     };
 
 
     void setupUI();
     void updateList();
+    enum Category { AllCategory, TextCategory, ImageCategory };  // 分类按钮在 categoryBtns 中的 id
+    // 分类、时间和大小条件；普通条目按 columns 整列筛选，置顶条目和单条新增逐条判断
+    EntryColumns::Query currentFilter() const;
+    bool matchesFilter(const ClipboardItem& item) const;
+    static quint8 columnFlags(const ClipboardItem& item);
+    void insertColumn(qsizetype row, const ClipboardItem& item);
+    void addListRow(const ClipboardItem& item);
     QDialog* createPreviewDialog(const ClipboardItem& item);
     QPushButton* createCopyButton();
     QPushButton* createSaveButton();
+    QPushButton* createPinButton(bool pinned);
     void copyToClipboard(const QString& text);
     void copyImageToClipboard(const QPixmap& image);
     void showToast(const QString &message);
@@ -72,46 +96,87 @@ private:
 
     QLabel *titleLabel;
     QButtonGroup *categoryBtns;
+    QComboBox *timeFilter;
+    QComboBox *sizeFilter;
     QCheckBox *autoStart;
     QPushButton *clearBtn;
+    QPushButton *exportBtn;
+    QPushButton *deleteBtn;
     QWidget *contentArea;
     QWidget *leftPanel;
     QListWidget *contentList;
-    QClipboard *clipboard;
 
-    QString getImageHash(const QPixmap& image);
     QLabel* createImageLabel(const QPixmap& image);
+    static QPixmap makeThumbnail(const QPixmap& image);
+    static const int THUMBNAIL_WIDTH = 200;
+    static const int THUMBNAIL_HEIGHT = 150;
     QLabel* createTextLabel(const QString& text);
 
     QList<ClipboardItem> items;
+    EntryColumns columns;   // items 的元数据列，行号从旧到新（与 items 顺序相反）
+    // 置顶条目单独一层：常驻内存（完整图片不参与回收），显示在列表最前
+    QList<ClipboardItem> pinnedItems;
     QDialog* createStyledDialog(const ClipboardItem& item);
 
-    // 添加缓存相关成员
-    void clearCache();
-    void addToCache(const QString& hash, const QPixmap& image);
-    QPixmap getFromCache(const QString& hash);
-
-    // 缓存相关成员
-    QHash<QString, QPixmap> imageCache;
-    const int MAX_CACHE_SIZE = 20; // MB
-    int currentCacheSize = 0;
-
     // 下载
-    DownloadManager *downloadManager;
+    DownloadManager *downloadManager = nullptr;
     void saveContent(const ClipboardItem& item);
-    //存储
-    StorageManager *storageManager;
+    // 批量导出当前分类下的历史，在后台线程中进行
+    QProgressDialog *exportDialog = nullptr;
+    void exportHistory();
+    //历史来源：后台守护进程在运行时通过本地套接字连接，否则在进程内运行捕获核心
+    HistorySource *history = nullptr;
+    void setupHistorySource();
+    HistorySource* createLocalHistory();
+    void connectHistorySignals();
+    // 与守护进程的连接断开后切换到进程内历史，并补发丢失的分页请求
+    void onDaemonDisconnected();
     void saveHistoryToStorage();
-    void loadHistoryFromStorage();
+
+    // 分阶段启动：窗口显示后先加载首页历史，其余在空闲时分批加载
+    void loadFirstHistoryPage();
+    void finishStartup();
+    DownloadManager* ensureDownloadManager();
+
+    static const int FIRST_PAGE_SIZE = 10;     // 首屏加载条数
+    static const int DEFERRED_PAGE_SIZE = 10;  // 空闲时每批加载条数
+    bool startupStarted = false;
+    bool firstPageLoaded = false;
+    bool historyLoaded = false;
+    quint64 pageCursor = 0;       // 已加载的最旧条目 id
+    quint64 firstCapturedId = 0;  // 启动后新捕获的最小 id，用于分页去重
+    bool lastPageReceived = false;
+    bool pageRequestPending = false;  // 已发出分页请求、尚未收到结果
+    PageDecoder *pageDecoder = nullptr;  // 分页图片在线程池中并行解码
 
     static const int MAX_HISTORY_ITEMS = 100;  // 最大历史记录数
     bool shouldSaveHistory = true;  // 控制是否保存历史
 
     void showHistoryLimitWarning();
 
+    // 性能浮层（Ctrl+Shift+P）与追踪导出（Ctrl+Shift+T）
+    PerfOverlay *perfOverlay = nullptr;
+    void setupDiagnostics();
+    void togglePerfOverlay();
+    void exportTrace();
+    QList<QPair<QString, qint64>> memoryUsage() const;
+
+    // 内存记账：完整图片、缩略图和列表行都计入 MemoryAccountant，超出预算时回收完整图片
+    static const qint64 ROW_OVERHEAD_BYTES = 4 * 1024;  // 每行控件的估算开销
+    qint64 rowOverheadBytes = 0;
+    int imageReclaimerId = -1;
+    void accountItem(const ClipboardItem& item, int sign);
+    void clearRows();
+    QHash<quint64, QListWidgetItem*> rowItems;  // 当前列表中各条目的行，删除时只移除对应行
+    void removeRows(const QList<quint64>& ids);
+    qint64 demoteImages(qint64 bytesNeeded);
+    QPixmap fullImage(const ClipboardItem& item);
+    QString fullText(const ClipboardItem& item);
+    const ClipboardItem* findItem(quint64 id) const;
+
     void closeEvent(QCloseEvent *event) override;
-    bool convertToStorageItem(const ClipboardItem& source, StorageManager::ClipboardData& target);
     bool convertFromStorageItem(const StorageManager::ClipboardData& source, ClipboardItem& target);
+    static void copyEntryFields(const StorageManager::ClipboardData& source, ClipboardItem& target);
 
 
 
@@ -120,10 +185,18 @@ private:
 
 private slots:
     void onSaveButtonClicked();
-    void clipboardChanged();
+    void onHistoryPage(const QList<StorageManager::ClipboardData>& entries, bool finished);
+    void onPageItemDecoded(const PageDecoder::Item& decoded);
+    void onPageDecoded();
+    void onEntryAdded(const StorageManager::ClipboardData& entry);
+    void onHistoryCleared();
+    void onPinnedLoaded(const QList<StorageManager::ClipboardData>& entries);
+    void onEntryPinned(const StorageManager::ClipboardData& entry);
+    void onEntriesRemoved(const QList<quint64>& ids);
     void showPreview(QListWidgetItem *item);
     void onCategoryChanged(QAbstractButton *button);
     void clearHistory();
+    void deleteSelected();
     void setAutoStart(bool enable);
 };
 